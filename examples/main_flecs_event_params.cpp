@@ -7,6 +7,7 @@
 #include "imgui.h"
 #include "rlImGui.h"	        // include the API header
 #include "bake_config.h"
+#include "module_event_bus.hpp"
 #include <iostream>
 
 // phases
@@ -54,6 +55,8 @@ struct resize_t{
     int height;
 };
 flecs::entity widget;
+// events are queued here and dispatched once per frame after progress()
+event_bus::event_bus_t event_queue;
 
 // Dummy system
 void Sys(flecs::iter& it) {
@@ -111,14 +114,14 @@ void imgui_render_system(flecs::iter& it) {
         ImGui::ColorEdit3("clear color", &ctx.clear_color.x); // Edit 3 floats representing a color
         if (ImGui::Button("Button")){                            // Buttons return true when clicked (most widgets return true when edited/activated)
             TraceLog(LOG_INFO, "Click");
-            // Emit entity event
-            widget.emit<click_t>();
+            // Queue entity event
+            event_queue.post<click_t>(world, widget, event_bus::coalesce_t::none);
         }
 
         if (ImGui::Button("resize")){                            // Buttons return true when clicked (most widgets return true when edited/activated)
             TraceLog(LOG_INFO, "resize");
-            // Emit entity event
-            widget.emit<resize_t>({100, 200});
+            // Queue entity event
+            event_queue.post<resize_t>(world, widget, {100, 200}); // repeated resizes collapse into the last one
         }
         // rlImGuiImage(&image);
     }
@@ -406,6 +409,7 @@ int main()
     while (!WindowShouldClose())    // Detect window close button or ESC key
     {
         world.progress();
+        event_queue.dispatch(world);
     }
 
     // -------------------------------------------------------
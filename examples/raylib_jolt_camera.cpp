@@ -14,6 +14,8 @@
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Body/BodyActivationListener.h>
 
+#include "module_input.hpp"
+
 #include <iostream>
 #include <cstdarg>
 #include <thread>
@@ -245,12 +247,35 @@ int main(int argc, char** argv)
     JPH::Quat  sphere_start_rot = JPH::Quat::sIdentity();
     bool is_spectator = false;
 
+    // -----------------------------------------------------------------
+    // Input: sampled once per frame, everything below reads `in`
+    enum { ACTION_SPECTATOR, ACTION_LOOK, ACTION_RESET };
+    enum { AXIS_FORWARD, AXIS_RIGHT, AXIS_UP, AXIS_LOOK_X, AXIS_LOOK_Y, AXIS_SPEED };
+    using input::source_t;
+    input::action_map_t actions;
+    actions.bind_action(ACTION_SPECTATOR, source_t::key, KEY_ONE)
+           .bind_action(ACTION_LOOK, source_t::mouse_button, MOUSE_RIGHT_BUTTON)
+           .bind_action(ACTION_RESET, source_t::key, KEY_R)
+           .bind_axis(AXIS_FORWARD, source_t::key, KEY_W, 1.0f)
+           .bind_axis(AXIS_FORWARD, source_t::key, KEY_S, -1.0f)
+           .bind_axis(AXIS_RIGHT, source_t::key, KEY_A, 1.0f)   // `right` below points left
+           .bind_axis(AXIS_RIGHT, source_t::key, KEY_D, -1.0f)
+           .bind_axis(AXIS_UP, source_t::key, KEY_SPACE, 1.0f)
+           .bind_axis(AXIS_UP, source_t::key, KEY_LEFT_SHIFT, -1.0f)
+           .bind_axis(AXIS_LOOK_X, source_t::mouse_delta_x, 0)
+           .bind_axis(AXIS_LOOK_Y, source_t::mouse_delta_y, 0)
+           .bind_axis(AXIS_SPEED, source_t::mouse_wheel, 0);
+    input::input_state_t in;
+    input::input_frame_t frame;
+
     // -----------------------------------------------------------------
     // 6. Main loop (raylib + physics)
     while (!WindowShouldClose())
     {
+        input::sample_raylib(frame, GetFrameTime());
+        input::step(in, actions, frame);
 
-        if(IsKeyPressed(KEY_ONE)){
+        if(in.action_pressed(ACTION_SPECTATOR)){
             is_spectator = !is_spectator;
             if(is_spectator){
                 TraceLog(LOG_INFO, "is_spectator true");
@@ -260,11 +285,10 @@ int main(int argc, char** argv)
         }
 
         // ---- 1. Mouse look (right button) ---------------------------------
-        if (IsMouseButtonDown(MOUSE_RIGHT_BUTTON))
+        if (in.action_down(ACTION_LOOK))
         {
-            Vector2 delta = GetMouseDelta();
-            camYaw   -= delta.x * 0.003f;               // yaw sensitivity
-            camPitch -= delta.y * 0.003f;
+            camYaw   -= in.axis(AXIS_LOOK_X) * 0.003f;  // yaw sensitivity
+            camPitch -= in.axis(AXIS_LOOK_Y) * 0.003f;
 
             // clamp pitch
             const float limit = PI * 0.49f;
@@ -291,15 +315,11 @@ int main(int argc, char** argv)
         Vector3 up = Vector3CrossProduct(right, forward); // world up
 
         // ---- 3. Keyboard movement -----------------------------------------
-        Vector3 move = { 0 };
-        if (IsKeyDown(KEY_W)) move = Vector3Add(move, forward);
-        if (IsKeyDown(KEY_S)) move = Vector3Subtract(move, forward);
-        if (IsKeyDown(KEY_A)) move = Vector3Add(move, right);
-        if (IsKeyDown(KEY_D)) move = Vector3Subtract(move, right);
-        if (IsKeyDown(KEY_SPACE))      move.y += 1.0f;
-        if (IsKeyDown(KEY_LEFT_SHIFT)) move.y -= 1.0f;
-
-        float deltaTime = GetFrameTime();
+        Vector3 move = Vector3Add(Vector3Scale(forward, in.axis(AXIS_FORWARD)),
+                                  Vector3Scale(right, in.axis(AXIS_RIGHT)));
+        move.y += in.axis(AXIS_UP);
+
+        float deltaTime = in.current.dt;
         if (Vector3LengthSqr(move) > 0.0f)
         {
             move = Vector3Normalize(move);
@@ -312,7 +332,7 @@ int main(int argc, char** argv)
         camera.target = Vector3Add(camera.position, forward);
 
         // ---- 5. Mouse wheel speed change ----------------------------------
-        float wheel = GetMouseWheelMove();
+        float wheel = in.axis(AXIS_SPEED);
         if (wheel != 0.0f)
         {
             camSpeedMultiplier *= powf(SPEED_STEP, wheel);
@@ -333,7 +353,7 @@ int main(int argc, char** argv)
             (float)joltPos.GetZ()
         };
         // ---- Reset on R --------------------------------------------
-        if (IsKeyPressed(KEY_R))
+        if (in.action_pressed(ACTION_RESET))
         {
             body_interface.SetPositionAndRotation(sphere_id, sphere_start_pos, sphere_start_rot, JPH::EActivation::Activate);
             body_interface.SetLinearVelocity (sphere_id, JPH::Vec3(0, -5, 0));
@@ -17,6 +17,8 @@
 #include <Jolt/Core/TempAllocator.h>
 #include "Jolt/Core/JobSystem.h"
 
+#include "module_input.hpp"
+
 #include <iostream>
 #include <cstdarg>
 #include <thread>
@@ -262,20 +264,36 @@ int main(int argc, char** argv)
     // bool is_running = false;
     JPH::Vec3 gravity(0, -9.8f, 0);
 
+    // sampled once per frame, the loop reads `in`
+    enum { ACTION_JUMP, ACTION_RESET_SPHERE, ACTION_TELEPORT };
+    enum { AXIS_X, AXIS_Z };
+    using input::source_t;
+    input::action_map_t actions;
+    actions.bind_action(ACTION_JUMP, source_t::key, KEY_SPACE)
+           .bind_action(ACTION_JUMP, source_t::gamepad_button, GAMEPAD_BUTTON_RIGHT_FACE_DOWN)
+           .bind_action(ACTION_RESET_SPHERE, source_t::key, KEY_R)
+           .bind_action(ACTION_TELEPORT, source_t::key, KEY_T)
+           .bind_axis(AXIS_Z, source_t::key, KEY_W, 1.0f)
+           .bind_axis(AXIS_Z, source_t::key, KEY_S, -1.0f)
+           .bind_axis(AXIS_Z, source_t::gamepad_axis, GAMEPAD_AXIS_LEFT_Y, -1.0f)
+           .bind_axis(AXIS_X, source_t::key, KEY_A, 1.0f)
+           .bind_axis(AXIS_X, source_t::key, KEY_D, -1.0f)
+           .bind_axis(AXIS_X, source_t::gamepad_axis, GAMEPAD_AXIS_LEFT_X, -1.0f);
+    input::input_state_t in;
+    input::input_frame_t frame;
+
     TraceLog(LOG_INFO, "init loop");
     while (!WindowShouldClose())
     {
-        const float deltaTime = GetFrameTime();
+        input::sample_raylib(frame, GetFrameTime());
+        input::step(in, actions, frame);
+        const float deltaTime = in.current.dt;
 
         // Get character input
-        JPH::Vec3 movement = JPH::Vec3::sZero();
-        if (IsKeyDown(KEY_W)) movement += JPH::Vec3(0, 0, 1);
-        if (IsKeyDown(KEY_S)) movement += JPH::Vec3(0, 0, -1);
-        if (IsKeyDown(KEY_A)) movement += JPH::Vec3(1, 0, 0);
-        if (IsKeyDown(KEY_D)) movement += JPH::Vec3(-1, 0, 0);
+        JPH::Vec3 movement(in.axis(AXIS_X), 0, in.axis(AXIS_Z));
 
         // Jump
-        if (IsKeyPressed(KEY_SPACE) && character->IsSupported())
+        if (in.action_pressed(ACTION_JUMP) && character->IsSupported())
         {
             JPH::Vec3 vel = character->GetLinearVelocity();
             vel.SetY(jump_impulse);
@@ -317,13 +335,13 @@ int main(int argc, char** argv)
             (float)joltPos.GetZ()
         };
         
-        if (IsKeyPressed(KEY_R))
+        if (in.action_pressed(ACTION_RESET_SPHERE))
         {
             body_interface.SetPositionAndRotation(sphere_id, sphere_start_pos, sphere_start_rot, JPH::EActivation::Activate);
             body_interface.SetLinearVelocity (sphere_id, JPH::Vec3(0, -5, 0));
             body_interface.SetAngularVelocity(sphere_id, JPH::Vec3::sZero());
         }
-        if (IsKeyPressed(KEY_T))
+        if (in.action_pressed(ACTION_TELEPORT))
         {
             // Set the new position
             character->SetPosition(player_pos);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ---------------------------------------------------------------
+//  delta – XOR diff + zero-run encoding for byte buffers
+// ---------------------------------------------------------------
+// encode() stores before ^ after as a list of
+//
+//   [varint zero bytes skipped][varint literal count][literal xor bytes]
+//
+// with the trailing zero run left out, so an unchanged float in a large
+// component costs nothing. XOR is its own inverse: applying the same delta
+// to `after` gives `before` and to `before` gives `after`, so one delta
+// serves both undo and redo.
+namespace delta {
+
+    // Append the delta between two buffers of `size` bytes to out.
+    // Returns the number of bytes appended (0 when they are equal).
+    size_t encode(const void* before, const void* after, size_t size, std::vector<uint8_t>& out);
+
+    // XOR a delta into target. Returns false when the delta is malformed
+    // or runs past `size`; target may then be partially written.
+    bool apply(const uint8_t* data, size_t len, void* target, size_t size);
+
+    // ------------------------------------------------------------
+    //  runs with both sides
+    // ------------------------------------------------------------
+    // encode_runs() keeps the old and the new bytes of every changed run,
+    //
+    //   [varint zero bytes skipped][varint count][count before][count after]
+    //
+    // so a side can be written back as absolute values. Check holds_runs()
+    // first: a buffer that changed since the runs were taken should be left
+    // alone, not overwritten with a side that no longer follows from it.
+    enum class side_t : uint8_t { before, after };
+
+    size_t encode_runs(const void* before, const void* after, size_t size, std::vector<uint8_t>& out);
+
+    // True when every run of target holds `side`. False for malformed runs.
+    bool holds_runs(const uint8_t* data, size_t len, const void* target, size_t size, side_t side);
+
+    // Write side `to` of every run into target. Returns false when the
+    // runs are malformed or run past `size`; target may then be partially
+    // written.
+    bool apply_runs(const uint8_t* data, size_t len, void* target, size_t size, side_t to);
+
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "bake_config.h"
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------
+//  jobs – one work-stealing pool for Jolt and flecs
+// ---------------------------------------------------------------
+// Without this, Jolt's JobSystemThreadPool (hardware_concurrency - 1 threads)
+// and flecs' task threads would each size themselves for the whole machine.
+// Both now submit to the same workers:
+//
+//   jobs::install_flecs_tasks(jobs::shared());   // before the first flecs::world
+//   flecs::world world;
+//   world.set_task_threads(jobs::shared().worker_count());
+//
+// and physics::module runs PhysicsSystem::Update on a jolt_job_system_t.
+//
+// Every worker owns a deque per priority. Work submitted from a worker goes
+// to its own deque (popped LIFO, cache warm). Work from other threads is
+// spread round robin. An idle worker steals FIFO from the others. Higher
+// priorities are drained, stolen included, before lower ones are looked at.
+namespace jobs {
+
+    // per subsystem, highest first
+    enum class priority_t : uint8_t {
+        physics,        // Jolt step jobs, on the critical path of a tick
+        ecs,            // flecs task threads
+        background,     // queries, streaming, anything that can wait
+        count
+    };
+
+    struct task_t {
+        void (*fn)(void* ctx, void* arg);
+        void* ctx;
+        void* arg;
+    };
+
+    struct scheduler_stats_t {
+        uint64_t executed = 0;
+        uint64_t stolen = 0;
+        uint64_t sleeps = 0;
+    };
+
+    class scheduler_t {
+    public:
+        // 0 = hardware_concurrency - 1 (the main thread is the last core)
+        explicit scheduler_t(int32_t workers = 0);
+        ~scheduler_t();
+
+        scheduler_t(const scheduler_t&) = delete;
+        scheduler_t& operator=(const scheduler_t&) = delete;
+
+        void submit(task_t task, priority_t priority);
+
+        // Run one queued task on the calling thread, false if there was none.
+        bool run_one();
+
+        int32_t worker_count() const { return (int32_t)threads_.size(); }
+
+        // index of the calling worker, -1 on other threads
+        int32_t worker_index() const;
+
+        scheduler_stats_t stats() const;
+
+    private:
+        struct queue_t {
+            std::mutex mutex;
+            std::deque<task_t> tasks[(int)priority_t::count];
+        };
+
+        bool pop(int32_t self, task_t& out);
+        void worker_main(int32_t index);
+
+        std::vector<std::unique_ptr<queue_t>> queues_;
+        std::vector<std::thread> threads_;
+
+        std::mutex sleep_mutex_;
+        std::condition_variable sleep_cv_;
+        std::atomic<int64_t> pending_{0};
+        std::atomic<uint32_t> next_queue_{0};
+        bool quit_ = false;
+
+        std::atomic<uint64_t> executed_{0};
+        std::atomic<uint64_t> stolen_{0};
+        std::atomic<uint64_t> sleeps_{0};
+    };
+
+    // process wide pool, created on first use
+    scheduler_t& shared();
+
+    // Split [0, count) into chunks of `grain` and run fn(ctx, begin, end) on
+    // the workers and the calling thread. Returns when every chunk is done.
+    // The caller only waits for chunks that are already running and never
+    // picks up unrelated tasks, so this is safe from any thread.
+    using range_fn_t = void (*)(void* ctx, int32_t begin, int32_t end);
+    void parallel_for(scheduler_t& scheduler, int32_t count, int32_t grain, range_fn_t fn, void* ctx,
+                      priority_t priority = priority_t::background);
+
+    // ------------------------------------------------------------
+    //  Jolt
+    // ------------------------------------------------------------
+    // JPH::JobSystem on top of the scheduler. Barriers come from
+    // JobSystemWithBarrier, whose Wait also runs jobs on the waiting thread.
+    class jolt_job_system_t final : public JPH::JobSystemWithBarrier {
+    public:
+        jolt_job_system_t(scheduler_t& scheduler, JPH::uint max_jobs, JPH::uint max_barriers,
+                          priority_t priority = priority_t::physics);
+        ~jolt_job_system_t() override;
+
+        int GetMaxConcurrency() const override;
+        JobHandle CreateJob(const char* name, JPH::ColorArg color, const JobFunction& function,
+                            JPH::uint32 num_dependencies = 0) override;
+
+    protected:
+        void QueueJob(Job* job) override;
+        void QueueJobs(Job** jobs, JPH::uint count) override;
+        void FreeJob(Job* job) override;
+
+    private:
+        static void run_job(void* ctx, void* arg);
+
+        using job_list_t = JPH::FixedSizeFreeList<Job>;
+
+        scheduler_t& scheduler_;
+        priority_t   priority_;
+        job_list_t   jobs_;
+        std::atomic<int32_t> queued_{0};   // tasks still in the scheduler
+    };
+
+    // ------------------------------------------------------------
+    //  flecs
+    // ------------------------------------------------------------
+    // Route ecs_os_api task_new/task_join (world.set_task_threads) to the
+    // scheduler. Call before the first world is created. flecs task threads
+    // wait for each other at pipeline sync points, so keep the task thread
+    // count <= worker_count().
+    void install_flecs_tasks(scheduler_t& scheduler, priority_t priority = priority_t::ecs);
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+// ---------------------------------------------------------------
+//  mapped_file – read-only memory map of a whole file
+// ---------------------------------------------------------------
+// Kept free of raylib/flecs includes: the Windows implementation needs
+// <windows.h>, which clashes with raylib names (CloseWindow, DrawText...).
+class mapped_file {
+public:
+    mapped_file() = default;
+    ~mapped_file();
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+
+    bool open(const char* path);
+    void close();
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool is_open() const { return data_ != nullptr; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
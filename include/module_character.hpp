@@ -0,0 +1,93 @@
+#pragma once
+
+#include "bake_config.h"
+#include "module_physics.hpp"
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Character/CharacterVirtual.h>
+#include <cstdint>
+#include <memory>
+
+// ---------------------------------------------------------------
+//  character – CharacterVirtual crowds, updated in parallel
+// ---------------------------------------------------------------
+// An entity with Character owns one JPH::CharacterVirtual. Gameplay writes
+// the wanted horizontal velocity (and jump) to CharacterMove; the module's
+// character_update_system is a physics pre-step system: it runs in
+// fixed_step::RLFixedPostUpdate after physics_begin_system and before the
+// step starts, so characters move against the bodies of the last step
+// without waiting on a pipelined step, and later RLFixedPostUpdate systems
+// see their new Transform3D positions.
+//
+// The update is spread over the shared job pool. Characters are bucketed in
+// an XZ grid whose cells are wider than any character can reach in one tick
+// (radius + padding + margin + movement), then updated in four passes, one
+// per 2x2 cell colour. Cells of one colour are a full cell apart, so two
+// characters that can touch are never updated at the same time, and a cell
+// is updated start to end by one worker. Character vs character collision
+// only looks at the 3x3 cells around a character instead of every other
+// character (CharacterVsCharacterCollisionSimple is O(n^2) and not safe to
+// use from several updates at once). Every worker has its own TempAllocator.
+//
+//   world.import<character::module>();
+//   flecs::entity npc = world.entity().set<Transform3D>({ .position = {0,1,0} });
+//   character::add_character(world, npc, *character::capsule_settings(1.2f, 0.3f));
+//   npc.get_mut<character::CharacterMove>().velocity = { 2, 0, 0 };
+//
+// Characters hold a pointer to the PhysicsSystem: create them after
+// physics::configure / set_layers.
+namespace character {
+
+    using transform_3d::Transform3D;
+
+    // component, set by add_character
+    struct Character {
+        JPH::Ref<JPH::CharacterVirtual> character;
+    };
+
+    // component, written by gameplay, read every tick
+    struct CharacterMove {
+        Vector3 velocity = { 0, 0, 0 };   // wanted, horizontal, m/s
+        bool    jump = false;             // consumed by the next tick
+    };
+
+    struct character_stats_t {
+        int32_t characters = 0;
+        int32_t supported = 0;     // on ground after the last tick
+        int32_t cells = 0;         // occupied grid cells
+        float   cell_size = 0.0f;
+        double  update_ms = 0.0;   // whole system, all passes
+    };
+
+    struct context_t;
+
+    // singleton
+    struct character_world_t {
+        character_world_t();
+        ~character_world_t();
+        character_world_t(character_world_t&&) noexcept;
+        character_world_t& operator=(character_world_t&&) noexcept;
+
+        std::unique_ptr<context_t> ctx;
+        JPH::ObjectLayer layer = physics::layers::CHARACTER;   // queries are filtered as this layer
+        float   jump_speed = 5.0f;
+        float   margin = 0.5f;     // reach beyond the shape: stair / floor probes, predictive contacts
+        bool    parallel = true;   // false: same passes on the calling thread
+        character_stats_t stats;
+    };
+
+    // Upright capsule centred on the entity position (cylinder `height`
+    // plus two hemispheres of `radius`).
+    JPH::Ref<JPH::CharacterVirtualSettings> capsule_settings(float height, float radius);
+
+    // Create a CharacterVirtual for `e` at its Transform3D and set Character
+    // plus CharacterMove. The user data of the character is the entity.
+    bool add_character(flecs::world& world, flecs::entity e, const JPH::CharacterVirtualSettings& settings);
+
+    // Remove Character (the CharacterVirtual goes with its last reference).
+    void remove_character(flecs::entity e);
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "bake_config.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// ---------------------------------------------------------------
+//  event_bus – deferred, coalescing entity events
+// ---------------------------------------------------------------
+// post() queues an event for an entity instead of emitting it on the spot.
+// Pending events are delivered to the regular flecs observers
+// (widget.observe<resize_t>(...)) in one batch by event_bus_dispatch_system,
+// which runs in the RLDispatchEvents phase after RLEndDrawing. That keeps
+// observer callbacks out of the middle of rendering.
+//
+//   auto& bus = world.get_mut<event_bus::event_bus_t>();
+//   bus.post<resize_t>(world, widget, { w, h });   // 100 resizes -> 1 event
+//   bus.post<click_t>(world, widget, event_bus::coalesce_t::none);
+//
+// Events posted by observers during a dispatch go to the next batch.
+// Main thread only.
+namespace event_bus {
+
+    // What happens to a second event with the same (event, entity) in a batch.
+    enum class coalesce_t : uint8_t {
+        none,    // keep every event
+        last,    // keep one, with the newest payload
+        first    // keep one, with the oldest payload
+    };
+
+    struct event_stats_t {
+        uint64_t posted = 0;        // post() calls
+        uint64_t coalesced = 0;     // posts folded into an earlier event
+        uint64_t dispatched = 0;    // observer emits
+        uint64_t dropped = 0;       // target deleted before dispatch
+        uint64_t batches = 0;
+        uint32_t last_batch = 0;    // events in the last dispatch
+        uint32_t peak_batch = 0;
+        double   last_dispatch_ms = 0.0;
+    };
+
+    // singleton (also usable on its own, call dispatch() yourself)
+    class event_bus_t {
+    public:
+        template <typename E>
+        void post(flecs::world& world, flecs::entity_t target, const E& payload,
+                  coalesce_t mode = coalesce_t::last)
+        {
+            static_assert(std::is_trivially_copyable<E>::value, "event payloads are copied as bytes");
+            post_raw(world.id<E>(), target, &payload, sizeof(E), mode);
+        }
+
+        // payload-less event (tag)
+        template <typename E>
+        void post(flecs::world& world, flecs::entity_t target, coalesce_t mode = coalesce_t::last) {
+            post_raw(world.id<E>(), target, nullptr, 0, mode);
+        }
+
+        void post_raw(flecs::entity_t event, flecs::entity_t target,
+                      const void* payload, size_t size, coalesce_t mode);
+
+        // Emit everything pending to the observers, in post order.
+        void dispatch(flecs::world& world);
+
+        size_t pending() const { return queue_.size(); }
+        const event_stats_t& stats() const { return stats_; }
+        void reset_stats() { stats_ = {}; }
+
+    private:
+        struct pending_t {
+            flecs::entity_t event;
+            flecs::entity_t target;
+            uint32_t        offset;   // into data_
+            uint32_t        size;
+        };
+
+        struct key_t {
+            flecs::entity_t event;
+            flecs::entity_t target;
+            bool operator==(const key_t& o) const { return event == o.event && target == o.target; }
+        };
+
+        struct key_hash_t {
+            size_t operator()(const key_t& k) const {
+                return std::hash<uint64_t>()(k.event * 0x9E3779B97F4A7C15ull ^ k.target);
+            }
+        };
+
+        std::vector<pending_t> queue_;
+        std::vector<unsigned char> data_;
+        std::unordered_map<key_t, uint32_t, key_hash_t> index_;   // coalesced slots
+
+        // swapped in during dispatch
+        std::vector<pending_t> batch_;
+        std::vector<unsigned char> batch_data_;
+
+        event_stats_t stats_;
+    };
+
+    // phase after raylib::RLEndDrawing
+    struct RLDispatchEvents {};
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
+
+}
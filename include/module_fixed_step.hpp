@@ -0,0 +1,52 @@
+#pragma once
+
+#include "bake_config.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------
+//  fixed_step – simulation phases run 0..N times per frame
+// ---------------------------------------------------------------
+// Systems with .kind<fixed_step::RLFixedUpdate>() (or the pre/post phases)
+// are kept out of the builtin pipeline and run from fixed_step::progress()
+// at a constant delta time, driven by an accumulator:
+//
+//   while (!WindowShouldClose()) {
+//       fixed_step::progress(world, GetFrameTime());
+//   }
+namespace fixed_step {
+
+    // tag on the phase entities of the fixed group
+    struct FixedPhase {};
+
+    // phases, in order
+    struct RLFixedPreUpdate {};
+    struct RLFixedUpdate {};
+    struct RLFixedPostUpdate {};
+
+    // singleton
+    struct fixed_time_t {
+        float    tick_rate = 60.0f;   // ticks per second
+        int32_t  max_catch_up = 5;    // max ticks per frame (spiral-of-death guard)
+        double   accumulator = 0.0;   // seconds not simulated yet
+        float    alpha = 0.0f;        // accumulator / fixed dt, for render interpolation
+        uint64_t tick = 0;            // total ticks simulated (index of the running tick)
+        int32_t  steps = 0;           // ticks run in the last frame
+        uint64_t dropped = 0;         // ticks thrown away by the catch-up limit
+
+        float fixed_dt() const { return 1.0f / tick_rate; }
+    };
+
+    // singleton, pipeline that only contains the fixed phases
+    struct fixed_pipeline_t {
+        flecs::entity_t pipeline;
+    };
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
+
+    // Run the fixed pipeline as often as the accumulator allows, then the
+    // regular pipeline. Returns the result of world.progress().
+    bool progress(flecs::world& world, float frame_dt);
+
+}
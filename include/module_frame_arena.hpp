@@ -0,0 +1,119 @@
+#pragma once
+
+#include "bake_config.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+// ---------------------------------------------------------------
+//  frame_arena – per-frame bump allocator for system temporaries
+// ---------------------------------------------------------------
+// One linear_arena per flecs stage (main thread + workers). Systems grab
+// scratch memory with frame_arena::get(it) and never free it; everything
+// is released in one go by reset_system, which runs at RLEndDrawing.
+namespace frame_arena {
+
+    // Bump allocator backed by a list of blocks. Blocks survive reset(), and
+    // a frame that overflowed into several blocks is folded into a single
+    // block sized to the high-water mark, so steady-state frames never touch
+    // the heap.
+    class linear_arena {
+    public:
+        explicit linear_arena(size_t block_size = 64 * 1024);
+        ~linear_arena();
+
+        linear_arena(const linear_arena&) = delete;
+        linear_arena& operator=(const linear_arena&) = delete;
+
+        // nullptr when the heap is out of memory
+        void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+        template <typename T>
+        T* allocate_array(size_t count) {
+            if (count > SIZE_MAX / sizeof(T)) return nullptr;
+            return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void reset();
+
+        size_t used() const { return used_; }             // bytes consumed since reset, padding included
+        size_t capacity() const;                           // bytes reserved in blocks
+        size_t high_water() const { return high_water_; } // largest frame so far
+        uint32_t heap_allocs() const { return heap_allocs_; } // blocks malloc'ed since reset (a fold counts)
+        uint64_t total_heap_allocs() const { return total_heap_allocs_; }
+
+    private:
+        struct block_t {
+            unsigned char* data;
+            size_t size;
+        };
+
+        static block_t make_block(size_t size);
+        bool next_block(size_t size, size_t align);
+
+        std::vector<block_t> blocks_;
+        size_t block_size_;
+        size_t current_ = 0;     // active block
+        size_t offset_ = 0;      // bump offset in active block
+        size_t used_ = 0;
+        size_t high_water_ = 0;
+        uint32_t heap_allocs_ = 0;
+        uint64_t total_heap_allocs_ = 0;
+    };
+
+    // STL allocator adapter. deallocate() is a no-op, memory goes back at reset.
+    template <typename T>
+    struct arena_allocator {
+        using value_type = T;
+
+        linear_arena* arena;
+
+        arena_allocator(linear_arena& a) noexcept : arena(&a) {}
+
+        template <typename U>
+        arena_allocator(const arena_allocator<U>& other) noexcept : arena(other.arena) {}
+
+        T* allocate(size_t n) {
+            T* p = arena->allocate_array<T>(n);
+            if (!p) throw std::bad_alloc();
+            return p;
+        }
+        void deallocate(T*, size_t) noexcept {}
+
+        template <typename U>
+        bool operator==(const arena_allocator<U>& other) const noexcept { return arena == other.arena; }
+        template <typename U>
+        bool operator!=(const arena_allocator<U>& other) const noexcept { return arena != other.arena; }
+    };
+
+    template <typename T>
+    using frame_vector = std::vector<T, arena_allocator<T>>;
+
+    constexpr int32_t MAX_STAGES = 64;
+
+    // singleton, one arena per stage. The slots never move, so a stage
+    // added by set_threads() after the import creates its own arena on
+    // first use without touching the others. Empty slots are null.
+    struct frame_arena_t {
+        size_t block_size = 64 * 1024;
+        std::array<std::unique_ptr<linear_arena>, MAX_STAGES> arenas;
+
+        linear_arena& for_stage(int32_t stage_id);
+    };
+
+    // Arena of the stage the iterator runs on (safe from worker threads).
+    // Stage ids from MAX_STAGES on are fatal.
+    linear_arena& get(flecs::iter& it);
+
+    // Reset every arena, grow the list when the stage count changed.
+    void reset(flecs::world& world);
+    void reset_system(flecs::iter& it);
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
+
+}
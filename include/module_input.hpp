@@ -0,0 +1,185 @@
+#pragma once
+
+#include "bake_config.h"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// ---------------------------------------------------------------
+//  input – per-frame input snapshot, action mapping, record/replay
+// ---------------------------------------------------------------
+// Keyboard, mouse and gamepad 0 are sampled once per frame by
+// input_sample_system, the only system in the RLInput phase. The RLInput
+// phase runs from begin_frame(), before the fixed ticks and the regular
+// pipeline. Every other system reads the input_state_t singleton: raw bits
+// plus the actions and axes bound in action_map_t. The snapshot is not
+// written during the frame, so worker threads can read it too.
+//
+//   enum { ACTION_JUMP };
+//   world.get_mut<input::action_map_t>().bind_action(ACTION_JUMP, input::source_t::key, KEY_SPACE);
+//
+//   input::start_replay(world, "session.rlin");
+//   while (!WindowShouldClose()) {
+//       if (!input::begin_frame(world, GetFrameTime())) break; // replay done
+//       fixed_step::progress(world, input::frame_dt(world));
+//   }
+//
+// Recorded frames store the frame delta time too, so a replay runs the
+// same number of fixed ticks with the same input, bit for bit. Replay
+// never calls raylib input functions and works without a window
+// (input_replay_test replays a session headless and compares state hashes).
+//
+// Dear ImGui is not covered: rlImGui reads raylib directly, so clicks and
+// edits in ImGui windows are not in the recording. Anything a replay has
+// to reproduce must come from input_state_t (actions, keys), not from UI
+// widgets. Demos turn ImGui input off while replaying so the live mouse
+// cannot leak into the session.
+namespace input {
+
+    constexpr int32_t KEY_COUNT = 512;                 // raylib MAX_KEYBOARD_KEYS
+    constexpr int32_t KEY_WORDS = KEY_COUNT / 64;
+    constexpr int32_t GAMEPAD_AXES = 6;                // GAMEPAD_AXIS_*
+    constexpr int32_t MAX_ACTIONS = 64;
+    constexpr int32_t MAX_AXES = 8;
+
+    // phase tag on RLInput, keeps it out of the builtin pipeline
+    struct InputPhase {};
+    struct RLInput {};
+
+    // One frame of raw input. Plain data, written to recordings as-is.
+    struct input_frame_t {
+        uint64_t keys[KEY_WORDS];
+        uint32_t mouse_buttons;       // bit per MouseButton
+        uint32_t gamepad_buttons;     // gamepad 0, bit per GamepadButton
+        Vector2  mouse_position;
+        Vector2  mouse_delta;
+        float    wheel;
+        float    gamepad_axes[GAMEPAD_AXES];
+        float    dt;                  // frame delta time
+
+        bool key_down(int32_t key) const {
+            return key >= 0 && key < KEY_COUNT && (keys[key >> 6] >> (key & 63)) & 1u;
+        }
+        bool mouse_down(int32_t button) const {
+            return button >= 0 && button < 32 && (mouse_buttons >> button) & 1u;
+        }
+        bool gamepad_down(int32_t button) const {
+            return button >= 0 && button < 32 && (gamepad_buttons >> button) & 1u;
+        }
+    };
+
+    // ------------------------------------------------------------
+    //  action mapping
+    // ------------------------------------------------------------
+    enum class source_t : uint8_t {
+        key,              // code = KeyboardKey
+        mouse_button,     // code = MouseButton
+        gamepad_button,   // code = GamepadButton
+        gamepad_axis,     // code = GamepadAxis
+        mouse_delta_x,
+        mouse_delta_y,
+        mouse_wheel
+    };
+
+    struct binding_t {
+        source_t source;
+        bool     is_axis;
+        int32_t  code;
+        int32_t  target;      // action or axis index
+        float    scale;       // axis: value multiplier, action: direction of an analog source
+    };
+
+    // singleton. Several bindings may drive the same action (OR) or axis (sum).
+    struct action_map_t {
+        std::vector<binding_t> bindings;
+        float deadzone = 0.2f;          // gamepad axes below this read as 0
+        float press_threshold = 0.5f;   // analog value that counts as an action press
+
+        action_map_t& bind_action(int32_t action, source_t source, int32_t code, float direction = 1.0f);
+        action_map_t& bind_axis(int32_t axis, source_t source, int32_t code, float scale = 1.0f);
+    };
+
+    enum class mode_t : uint8_t {
+        live,
+        record,
+        replay
+    };
+
+    struct file_closer_t {
+        void operator()(std::FILE* f) const { if (f) std::fclose(f); }
+    };
+
+    // singleton
+    struct input_state_t {
+        input_frame_t current{};
+        input_frame_t previous{};
+        uint64_t      actions = 0;            // bit per action, held this frame
+        uint64_t      actions_previous = 0;
+        float         axes[MAX_AXES] = {};
+        uint64_t      frame = 0;              // frames sampled since start
+
+        mode_t        mode = mode_t::live;
+        std::unique_ptr<std::FILE, file_closer_t> file;
+        float         live_dt = 0.0f;         // set by begin_frame
+        input_frame_t fed{};                  // see feed_frame
+        bool          has_fed = false;
+        bool          replay_finished = false;
+
+        bool key_down(int32_t key) const { return current.key_down(key); }
+        bool key_pressed(int32_t key) const { return current.key_down(key) && !previous.key_down(key); }
+        bool key_released(int32_t key) const { return !current.key_down(key) && previous.key_down(key); }
+        bool mouse_down(int32_t button) const { return current.mouse_down(button); }
+        bool mouse_pressed(int32_t button) const {
+            return current.mouse_down(button) && !previous.mouse_down(button);
+        }
+
+        bool action_down(int32_t action) const { return bit(actions, action); }
+        bool action_pressed(int32_t action) const { return bit(actions & ~actions_previous, action); }
+        bool action_released(int32_t action) const { return bit(~actions & actions_previous, action); }
+        float axis(int32_t axis) const { return axis >= 0 && axis < MAX_AXES ? axes[axis] : 0.0f; }
+
+    private:
+        static bool bit(uint64_t bits, int32_t i) {
+            return i >= 0 && i < MAX_ACTIONS && (bits >> i) & 1u;
+        }
+    };
+
+    // singleton
+    struct input_pipeline_t {
+        flecs::entity_t pipeline;
+    };
+
+    // Read the current raylib input into `out`.
+    void sample_raylib(input_frame_t& out, float dt);
+
+    // Advance `state` to `frame` and evaluate the action map. Also usable
+    // without a world (plain raylib loops).
+    void step(input_state_t& state, const action_map_t& map, const input_frame_t& frame);
+
+    // Use `frame` (dt included) instead of raylib for the next begin_frame:
+    // tests, bots, headless runs. Recorded like a sampled frame, ignored
+    // while replaying.
+    void feed_frame(flecs::world& world, const input_frame_t& frame);
+
+    // Write every following frame to `path`. The state starts from zero
+    // (frame counter, last frame, actions) exactly like start_replay, so
+    // the first recorded frame produces the same edges in both.
+    bool start_recording(flecs::world& world, const char* path);
+    // Take every following frame from `path` instead of raylib.
+    bool start_replay(flecs::world& world, const char* path);
+    // Back to live input, closes the file.
+    void stop(flecs::world& world);
+
+    // Run the RLInput phase for the next frame. Returns false once a
+    // replay has no frames left (state switches back to live).
+    bool begin_frame(flecs::world& world, float live_dt);
+
+    // Delta time of the current frame (recorded dt while replaying).
+    float frame_dt(const flecs::world& world);
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "bake_config.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------
+//  input_events – timestamped raw input and late-latched mouse
+// ---------------------------------------------------------------
+// Optional companion of input::module. GLFW callbacks are chained in
+// front of raylib's and every key, button, cursor and scroll event is
+// pushed with a glfwGetTime() stamp into a lock-free SPSC queue.
+//
+//   RLInput      the queue is drained into input_events_t::events (what
+//                GLFW delivered at raylib's last poll), so systems can order
+//                presses inside the frame (time - frame_time). The array
+//                lives in the frame arena and is gone after RLEndDrawing.
+//   RLLateLatch  the cursor is read once more with glfwGetCursorPos right
+//                before the 3D camera is used. late_mouse_delta is the
+//                movement since the snapshot.
+//
+// The latch never pumps the event loop, so raylib's own state (pressed
+// edges, wheel, GetMouseDelta, the recorded input_frame_t) is untouched.
+// The next snapshot's mouse_delta therefore contains this frame's late
+// movement again. look_delta already accounts for it: a late-latch camera
+// that applies look_delta every frame applies every pixel once, just
+// earlier. The latch is off while replaying (look_delta is then the
+// recorded mouse_delta).
+namespace input_events {
+
+    enum class event_type_t : uint8_t {
+        key,            // code = key, action = GLFW_PRESS/RELEASE/REPEAT
+        mouse_button,   // code = button, action as above
+        cursor,         // x, y = window position
+        scroll          // x, y = offset
+    };
+
+    struct input_event_t {
+        double       time;        // glfwGetTime(), seconds
+        event_type_t type;
+        uint8_t      action;
+        uint16_t     mods;
+        int32_t      code;
+        float        x;
+        float        y;
+    };
+
+    // singleton
+    struct input_events_t {
+        double   frame_time = 0.0;          // when this frame's snapshot was taken
+        double   latch_time = 0.0;          // when RLLateLatch read the cursor
+        const input_event_t* events = nullptr; // delivered before the snapshot, frame arena
+        int32_t  event_count = 0;           // (valid until RLEndDrawing)
+        Vector2  late_mouse_delta = {0, 0}; // cursor movement between snapshot and latch
+        Vector2  carried_delta = {0, 0};    // last frame's late movement, inside this snapshot
+        Vector2  look_delta = {0, 0};       // mouse_delta - carried_delta + late_mouse_delta
+        uint64_t dropped = 0;               // queue overflows since start
+        bool     installed = false;
+    };
+
+    // Chain the GLFW callbacks of raylib's window. Needs InitWindow().
+    bool install(flecs::world& world);
+    void uninstall(flecs::world& world);
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
+
+}
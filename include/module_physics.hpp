@@ -0,0 +1,454 @@
+#pragma once
+
+#include "bake_config.h"
+#include "module_transform_3d_hierarchy.hpp"
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyID.h>
+#include <Jolt/Physics/Collision/ObjectLayer.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseLayer.h>
+#include <Jolt/Physics/Collision/Shape/Shape.h>
+#include <Jolt/Physics/EActivation.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace JPH {
+    class BodyCreationSettings;
+    class BodyInterface;
+    class PhysicsSystem;
+}
+
+// ---------------------------------------------------------------
+//  physics – Jolt rigid bodies driven from the fixed step
+// ---------------------------------------------------------------
+// An entity with RigidBody owns one Jolt body; the body's user data is the
+// entity id. The module runs six systems at the start of
+// fixed_step::RLFixedPostUpdate, so gameplay in the fixed pre/update phases
+// writes first and later post-update systems see the new poses:
+//
+//   physics_begin_system      sync point, queued commands are applied
+//   physics_query_system      batched ray / shape casts, on the job pool
+//   physics_kinematic_system  Transform3D -> body for Kinematic entities
+//   physics_step_system       pre-step systems (add_pre_step_system), then
+//                             PhysicsSystem::Update(fixed dt)
+//   physics_sync_system       poses of the awake bodies are read under one
+//                             BodyLockMultiRead, then written to Transform3D
+//                             in a single pass (no per-body interface locks)
+//   physics_contact_system    contacts of the step go out as contact_added_t /
+//                             contact_removed_t events on both entities
+//
+// The awake set is kept by a BodyActivationListener, so bodies that sleep
+// are not touched by the sync at all; a body that falls asleep is synced
+// one last time.
+//
+// With physics_world_t::threaded the step is pipelined: tick N waits for
+// step N-1 (physics_begin_system, the sync point), takes its poses, then
+// starts step N on the physics thread and returns. The frame renders from
+// the poses of N-1 while N runs, one tick of latency for no step time on
+// the main thread. Gameplay writes go through the command functions below,
+// they are queued and applied at the sync point in either mode. system()
+// and body_interface() wait for a running step before they return, so
+// fixed passes that read the bodies every tick belong in a pre-step system
+// instead of the fixed pre/update phases, where they would stall on the
+// step in flight and serialize the pipeline.
+//
+//   world.import<physics::module>();
+//   flecs::entity ball = world.entity().set<Transform3D>({ .position = {0,10,0} });
+//   physics::add_body(world, ball, settings);    // position taken from Transform3D
+//
+// Bodies are synced as root transforms: give RigidBody entities no parent
+// with a Transform3D. Deleting the entity removes and destroys the body.
+namespace physics {
+
+    using transform_3d::Transform3D;
+
+    // object layers of layer_config_t::defaults()
+    namespace layers {
+        static constexpr JPH::ObjectLayer NON_MOVING = 0;
+        static constexpr JPH::ObjectLayer MOVING     = 1;
+        static constexpr JPH::ObjectLayer DEBRIS     = 2;
+        static constexpr JPH::ObjectLayer TRIGGER    = 3;
+        static constexpr JPH::ObjectLayer CHARACTER  = 4;
+    }
+
+    // ------------------------------------------------------------
+    //  layers
+    // ------------------------------------------------------------
+    // Object layers, the broadphase layer each one lives in, and a symmetric
+    // collision matrix (one bit per layer pair). Text form for load_layers,
+    // one entry per line, '#' starts a comment:
+    //
+    //   broadphase NON_MOVING
+    //   broadphase MOVING
+    //   layer NON_MOVING NON_MOVING          # layer <name> <broadphase>
+    //   layer MOVING MOVING
+    //   collide MOVING NON_MOVING MOVING     # collide <layer> <layers...>
+    //
+    // Layers and broadphase layers are numbered in the order they appear.
+    struct layer_config_t {
+        static constexpr int32_t MAX_LAYERS = 32;
+        static constexpr int32_t MAX_BROADPHASE_LAYERS = 16;
+
+        int32_t     layer_count = 0;
+        int32_t     broadphase_count = 0;
+        std::string layer_names[MAX_LAYERS];
+        std::string broadphase_names[MAX_BROADPHASE_LAYERS];
+        uint8_t     broadphase_of[MAX_LAYERS] = {};
+        uint32_t    collides[MAX_LAYERS] = {};   // bit b: collides with layer b
+
+        // return the new index, -1 when full
+        int32_t add_broadphase(const char* name);
+        int32_t add_layer(const char* name, int32_t broadphase);
+        void    collide(int32_t a, int32_t b);
+
+        int32_t find_layer(const char* name) const;
+        int32_t find_broadphase(const char* name) const;
+
+        // NON_MOVING, MOVING, DEBRIS, TRIGGER, CHARACTER (see physics::layers)
+        static layer_config_t defaults();
+    };
+
+    // Parse the text form above into `out`. Logs and returns false on errors.
+    bool load_layers(const char* path, layer_config_t& out);
+
+    // The three Jolt layer interfaces answered from flat tables: every
+    // query is one bit test, no switch, any number of layers.
+    class layer_tables_t {
+    public:
+        explicit layer_tables_t(const layer_config_t& config);
+
+        layer_tables_t(const layer_tables_t&) = delete;
+        layer_tables_t& operator=(const layer_tables_t&) = delete;
+
+        const JPH::BroadPhaseLayerInterface&    broadphase() const { return broadphase_; }
+        const JPH::ObjectVsBroadPhaseLayerFilter& object_vs_broadphase() const { return object_vs_broadphase_; }
+        const JPH::ObjectLayerPairFilter&       object_pair() const { return object_pair_; }
+
+        const layer_config_t& config() const { return config_; }
+
+    private:
+        class broadphase_interface_t final : public JPH::BroadPhaseLayerInterface {
+        public:
+            explicit broadphase_interface_t(const layer_tables_t& t) : t_(t) {}
+            JPH::uint GetNumBroadPhaseLayers() const override;
+            JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer layer) const override;
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+            const char* GetBroadPhaseLayerName(JPH::BroadPhaseLayer layer) const override;
+#endif
+        private:
+            const layer_tables_t& t_;
+        };
+
+        class object_vs_broadphase_t final : public JPH::ObjectVsBroadPhaseLayerFilter {
+        public:
+            explicit object_vs_broadphase_t(const layer_tables_t& t) : t_(t) {}
+            bool ShouldCollide(JPH::ObjectLayer layer, JPH::BroadPhaseLayer bp) const override;
+        private:
+            const layer_tables_t& t_;
+        };
+
+        class object_pair_t final : public JPH::ObjectLayerPairFilter {
+        public:
+            explicit object_pair_t(const layer_tables_t& t) : t_(t) {}
+            bool ShouldCollide(JPH::ObjectLayer a, JPH::ObjectLayer b) const override;
+        private:
+            const layer_tables_t& t_;
+        };
+
+        layer_config_t config_;
+        uint32_t       broadphase_mask_[layer_config_t::MAX_LAYERS] = {};   // bit: broadphase layer
+        broadphase_interface_t broadphase_{ *this };
+        object_vs_broadphase_t object_vs_broadphase_{ *this };
+        object_pair_t          object_pair_{ *this };
+    };
+
+    // ------------------------------------------------------------
+    //  capacity
+    // ------------------------------------------------------------
+    // Sizes the PhysicsSystem is built with; Jolt allocates for them up
+    // front. A full body table makes add_body fail, full pair / constraint
+    // buffers drop contacts (update error), and a step that outgrows the
+    // temp allocator falls back to the heap (physics_stats_t::temp_fallbacks),
+    // so size temp_allocator_size from temp_peak of the heaviest scene.
+    struct physics_config_t {
+        uint32_t max_bodies = 65536;
+        uint32_t num_body_mutexes = 0;            // 0: Jolt picks
+        uint32_t max_body_pairs = 65536;          // broadphase pairs per step
+        uint32_t max_contact_constraints = 32768;
+        size_t   temp_allocator_size = 32u << 20; // per step scratch, bytes
+        layer_config_t layers = layer_config_t::defaults();
+    };
+
+    // component, set by add_body
+    struct RigidBody {
+        JPH::BodyID id;
+    };
+
+    // tag, Transform3D is pushed to the body every tick (MoveKinematic)
+    struct Kinematic {};
+
+    struct physics_stats_t {
+        int32_t bodies = 0;        // bodies in the PhysicsSystem
+        int32_t active = 0;        // awake bodies after the last step
+        int32_t slept = 0;         // fell asleep during the last step (synced once more)
+        int32_t synced = 0;        // Transform3D written by the last sync
+        int32_t kinematic = 0;     // kinematic bodies pushed by the last tick
+        double  step_ms = 0.0;     // PhysicsSystem::Update, on whichever thread ran it
+        double  sync_ms = 0.0;
+        double  wait_ms = 0.0;     // main thread blocked at the sync point
+        int32_t contacts = 0;      // contact records of the last collected step
+        int32_t queries = 0;       // ray / shape casts of the last batch
+        int32_t query_hits = 0;
+        double  query_ms = 0.0;
+        size_t  temp_high_water = 0;   // temp allocator bytes used by the last step
+        size_t  temp_peak = 0;         // largest temp_high_water since configure
+        int32_t temp_fallbacks = 0;    // allocations of the last step that did not fit, served from the heap
+        uint64_t temp_fallbacks_total = 0;
+        int32_t layer_bodies[layer_config_t::MAX_LAYERS] = {};   // bodies per object layer
+    };
+
+    enum class command_type_t : uint8_t {
+        set_pose,                  // value = position, rotation
+        set_linear_velocity,
+        set_angular_velocity,
+        add_force,
+        add_impulse,
+        activate,
+        deactivate
+    };
+
+    struct command_t {
+        command_type_t type;
+        JPH::BodyID    id;
+        Vector3        value;
+        Quaternion     rotation;
+    };
+
+    // ------------------------------------------------------------
+    //  contacts
+    // ------------------------------------------------------------
+    // The contact listener records from Jolt's workers into one buffer per
+    // thread, no locks in the solver. The buffers are merged on the main
+    // thread with the poses of the step (same latency in threaded mode).
+    enum class contact_state_t : uint8_t {
+        added,
+        persisted,      // only with physics_world_t::persisted_contacts
+        removed         // no point / normal / impulse
+    };
+
+    // One record per body pair and state per step; Jolt reports sub-shape
+    // pairs, those are folded. a / b are 0 for bodies not added through
+    // this module.
+    struct contact_t {
+        flecs::entity_t a = 0;
+        flecs::entity_t b = 0;
+        JPH::BodyID     body_a;
+        JPH::BodyID     body_b;
+        Vector3         point = {};       // world space, centre of the manifold on a
+        Vector3         normal = {};      // a -> b
+        float           impulse = 0.0f;   // approach speed along the normal * reduced mass
+        contact_state_t state = contact_state_t::added;
+    };
+
+    // Events emitted on both entities of a pair, `other` is the far side:
+    //
+    //   e.observe<physics::contact_added_t>([](flecs::entity e, physics::contact_added_t& c) { ... });
+    struct contact_added_t {
+        flecs::entity_t other;
+        Vector3         point;
+        Vector3         normal;           // away from the observed entity
+        float           impulse;
+    };
+
+    struct contact_removed_t {
+        flecs::entity_t other;
+    };
+
+    // ------------------------------------------------------------
+    //  queries
+    // ------------------------------------------------------------
+    // Ray and shape casts are batched. Systems submit them during the tick,
+    // from any thread; physics_query_system runs the whole batch in parallel
+    // on the job pool at the sync point, where no step is running, and the
+    // results stay readable until the next batch has run. A query submitted
+    // in the fixed pre/update phases is answered for the post update systems
+    // and the pre/update phases of the next tick:
+    //
+    //   probe.query = physics::cast_ray(world, { .origin = eye, .direction = Vector3Scale(dir, 50) });
+    //   ...
+    //   if (const physics::query_hit_t* h = physics::query_result(world, probe.query)) { ... }
+    //
+    // Casts see the bodies as the last collected step left them.
+    struct query_id_t {
+        uint32_t batch = 0;        // 0: none
+        int32_t  index = -1;
+    };
+
+    struct ray_query_t {
+        Vector3          origin = {};
+        Vector3          direction = {};          // length is the max distance
+        JPH::ObjectLayer layer = layers::MOVING;  // collides like a body of this layer
+        JPH::BodyID      ignore;                  // e.g. the caster's own body
+        uint64_t         user = 0;                // copied to the hit
+    };
+
+    struct shape_query_t {
+        JPH::ShapeRefC   shape;
+        Vector3          position = {};           // start pose of the shape
+        Quaternion       rotation = { 0, 0, 0, 1 };
+        Vector3          direction = {};          // sweep, length is the max distance
+        JPH::ObjectLayer layer = layers::MOVING;
+        JPH::BodyID      ignore;
+        uint64_t         user = 0;
+    };
+
+    // Closest hit only; fraction is along direction.
+    struct query_hit_t {
+        bool            hit = false;
+        flecs::entity_t entity = 0;               // 0 for bodies not added through this module
+        JPH::BodyID     body;
+        Vector3         point = {};
+        Vector3         normal = {};              // surface normal, towards the caster
+        float           fraction = 1.0f;
+        uint64_t        user = 0;
+    };
+
+    struct context_t;
+
+    // destroys the context, then drops its reference on the Jolt globals
+    struct context_deleter_t {
+        void operator()(context_t* ctx) const;
+    };
+
+    // singleton, owns the Jolt objects (moves are member-wise). ctx is
+    // null until first use or configure(), so importing is cheap.
+    struct physics_world_t {
+        physics_world_t();
+
+        std::unique_ptr<context_t, context_deleter_t> ctx;
+        int32_t collision_steps = 1;
+        bool    threaded = false;  // pipelined step on the physics thread
+        bool    persisted_contacts = false;   // also record every touching pair, every step
+        std::vector<flecs::entity_t> pre_step_systems;   // see add_pre_step_system
+        std::vector<flecs::entity_t> system_holders;     // see add_system_holder
+        physics_stats_t stats;
+    };
+
+    // Create and add a body for `e` and set RigidBody (plus Kinematic for
+    // kinematic settings). mPosition/mRotation are taken from the entity's
+    // Transform3D when it has one, mUserData is overwritten with the entity.
+    // Returns an invalid id (and logs) when the system is full. A body the
+    // entity already has is removed first (replaced, never leaked).
+    JPH::BodyID add_body(flecs::world& world, flecs::entity e, JPH::BodyCreationSettings settings,
+                         JPH::EActivation activation = JPH::EActivation::Activate);
+
+    // Arrays are indexed per entity and hold `count` entries; with
+    // shared_settings one settings entry is used for all of them.
+    struct add_bodies_desc_t {
+        int32_t                          count = 0;
+        const flecs::entity_t*           entities = nullptr;
+        const JPH::BodyCreationSettings* settings = nullptr;
+        bool                             shared_settings = false;
+        JPH::EActivation                 activation = JPH::EActivation::Activate;
+    };
+
+    // add_body for many entities at once, for scene / cell loading. Bodies
+    // are created in parallel on the job pool, then inserted into the
+    // broadphase as one AddBodiesPrepare/AddBodiesFinalize batch instead of
+    // one tree insert per body. The broadphase is optimized at the start of
+    // the next step. Settings that hold a ShapeSettings are converted once
+    // on the calling thread first, the workers only see built shapes. Body
+    // ids are written to out (may be null, count entries, invalid when the
+    // system was full or the shape failed). Returns the number added.
+    // Main thread, outside of systems or in an .immediate() one (the
+    // world_partition hooks).
+    int32_t add_bodies(flecs::world& world, const add_bodies_desc_t& desc, JPH::BodyID* out = nullptr);
+
+    // Run `system` (created with .kind(0), no phase) every tick inside
+    // physics_step_system, before the step starts: after
+    // physics_begin_system collected the last step and applied the
+    // commands, with no step running, so system() does not wait. Systems
+    // run in the order they were added.
+    void add_pre_step_system(flecs::world& world, flecs::entity_t system);
+
+    // Instances of `component` keep a pointer to the PhysicsSystem
+    // (character::Character and its CharacterVirtual): configure() refuses
+    // to rebuild the system while any exist.
+    void add_system_holder(flecs::world& world, flecs::entity_t component);
+
+    // Remove RigidBody (the body is destroyed by the OnRemove observer).
+    void remove_body(flecs::entity e);
+
+    // Queue a write for the next tick. Thread safe. The entity versions
+    // ignore entities without RigidBody.
+    void push_command(flecs::world& world, const command_t& cmd);
+    void set_pose(flecs::entity e, Vector3 position, Quaternion rotation);
+    void set_linear_velocity(flecs::entity e, Vector3 velocity);
+    void set_angular_velocity(flecs::entity e, Vector3 velocity);
+    void add_force(flecs::entity e, Vector3 force);
+    void add_impulse(flecs::entity e, Vector3 impulse);
+
+    // Contacts of the last collected step, sorted by body pair. Valid until
+    // the next step is collected. Main thread.
+    const std::vector<contact_t>& contacts(flecs::world& world);
+
+    // Submit a cast for the next batch. Thread safe.
+    query_id_t cast_ray(flecs::world& world, const ray_query_t& query);
+    query_id_t cast_shape(flecs::world& world, const shape_query_t& query);
+
+    // Result of a submitted cast, nullptr until its batch has run and again
+    // once the next batch has replaced it. Safe from any system, the table
+    // only changes in physics_query_system.
+    const query_hit_t* query_result(flecs::world& world, query_id_t id);
+
+    // Wait for a running step. Main thread.
+    void sync(flecs::world& world);
+
+    // Build the PhysicsSystem with other capacities and layers. Called
+    // before anything used physics, no default system is built at all.
+    // Only while it holds no bodies and no system holder exists (right
+    // after import); logs and returns false otherwise. set_layers keeps the
+    // capacities.
+    bool configure(flecs::world& world, const physics_config_t& config);
+    bool set_layers(flecs::world& world, const layer_config_t& config);
+    const physics_config_t& config_of(flecs::world& world);
+    const layer_config_t& layers_of(flecs::world& world);
+
+    // Everything Jolt holds on the heap, all worlds together (Jolt's
+    // Allocate / Free hooks are process wide). Zero when Jolt was built
+    // with JPH_DISABLE_CUSTOM_ALLOCATOR.
+    struct heap_stats_t {
+        size_t   bytes = 0;
+        size_t   peak = 0;
+        int64_t  blocks = 0;           // live allocations
+        uint64_t allocations = 0;      // since start
+    };
+
+    heap_stats_t heap_stats();
+
+    // Install Jolt's allocator, trace and assert hooks, once per process.
+    // Called by the first physics world and by shapes::shared(), so no
+    // Jolt object is allocated before the hooks are in place. The hooks
+    // stay installed after the last world is gone.
+    void install_jolt_hooks();
+
+    // Log body counts per layer plus Jolt's broadphase / narrowphase stats
+    // when Jolt was built with TRACK_BROADPHASE_STATS / TRACK_NARROWPHASE_STATS.
+    void report_stats(flecs::world& world);
+
+    // Direct access, after sync(). Main thread.
+    JPH::PhysicsSystem& system(flecs::world& world);
+    JPH::BodyInterface& body_interface(flecs::world& world);
+
+    // After PhysicsSystem::RestoreState on system(world): rebuild the awake
+    // set from GetActiveBodies() (RestoreState does not call the activation
+    // listener) and drop the poses and contacts of the step before, so
+    // neither is synced or emitted for the restored state. Main thread.
+    void resync_after_restore(flecs::world& world);
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "bake_config.h"
+#include "module_physics.hpp"
+#include <Jolt/Jolt.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// ---------------------------------------------------------------
+//  physics_history – ring buffer of PhysicsSystem states per tick
+// ---------------------------------------------------------------
+// physics_history_record_system runs first in fixed_step::RLFixedPreUpdate
+// and saves the physics state at the start of every tick (after physics::sync,
+// before gameplay) with PhysicsSystem::SaveState. Static bodies are left
+// out, they do not move.
+//
+// States of one scene have the same layout, so most ticks are stored as an
+// XOR delta against the tick before (delta_codec.hpp): a resting body costs
+// nothing, a moving one a few bytes. Every keyframe_interval ticks, and
+// whenever the body set changes size, a full keyframe is stored; restoring
+// a tick applies at most keyframe_interval deltas to the keyframe before it.
+//
+//   world.import<physics_history::module>();
+//   physics_history::restore(world, tick - 60);   // one second back, then resimulate
+//
+// After a restore, fixed_time_t::tick is the restored tick and the next
+// tick overwrites the newer history, so replaying the same input
+// (module_input) resimulates the same ticks; scrubbing without stepping
+// keeps them. Commands queued with physics::push_command and characters
+// (module_character) are not part of a snapshot.
+namespace physics_history {
+
+    using transform_3d::Transform3D;
+
+    struct history_stats_t {
+        int32_t ticks = 0;          // snapshots held
+        int32_t keyframes = 0;
+        size_t  bytes = 0;          // stored, deltas + keyframes
+        size_t  full_bytes = 0;     // what every snapshot stored in full would take
+        size_t  last_size = 0;      // full size of the newest snapshot
+        double  save_ms = 0.0;      // last record(), SaveState + encode
+        double  restore_ms = 0.0;   // last restore(), decode + RestoreState
+    };
+
+    // singleton
+    class history_t {
+    public:
+        explicit history_t(int32_t capacity = 300, int32_t keyframe_interval = 30);
+
+        // Save the state as `tick`. Snapshots at or after `tick` are
+        // dropped first (the future after a restore).
+        void record(uint64_t tick, JPH::PhysicsSystem& system);
+
+        // Put the system back to the state saved as `tick`.
+        bool restore(uint64_t tick, JPH::PhysicsSystem& system);
+
+        bool contains(uint64_t tick) const;
+        bool empty() const { return entries_.empty(); }
+        uint64_t first_tick() const { return entries_.empty() ? 0 : entries_.front().tick; }
+        uint64_t last_tick() const { return entries_.empty() ? 0 : entries_.back().tick; }
+
+        void clear();
+        void set_capacity(int32_t capacity);
+        int32_t capacity() const { return capacity_; }
+
+        const history_stats_t& stats() const { return stats_; }
+
+        bool recording = true;
+
+    private:
+        struct entry_t {
+            uint64_t tick;
+            bool     keyframe;
+            uint32_t size;                // full state size
+            std::vector<uint8_t> data;    // full state or delta to the entry before
+        };
+
+        void drop_front();
+        ptrdiff_t find(uint64_t tick) const;
+
+        int32_t capacity_;
+        int32_t keyframe_interval_;
+        int32_t since_keyframe_ = 0;
+        bool    force_keyframe_ = true;
+
+        std::deque<entry_t>  entries_;    // ticks increasing, front is a keyframe
+        std::vector<uint8_t> last_;       // full state of entries_.back()
+        std::vector<uint8_t> scratch_;    // recorder bytes, kept between calls
+        history_stats_t      stats_;
+    };
+
+    // Restore physics to `tick`, write every body pose to Transform3D
+    // (sleeping and kinematic ones included) and set fixed_time_t::tick.
+    // Main thread, outside of the fixed pipeline. Returns false (and logs)
+    // when the tick is not in the history.
+    bool restore(flecs::world& world, uint64_t tick);
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
+
+}
@@ -2,12 +2,49 @@
 
 #include "bake_config.h"
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+// ---------------------------------------------------------------
+//  raylib – render pipeline phases and the begin/end systems
+// ---------------------------------------------------------------
+// Import once, then attach systems with .kind<raylib::RLRender3D>() etc.
+//
+//   flecs::world world;
+//   world.import<raylib::module>();
+//   world.set<raylib::main_context_t>({ .camera = camera });
+namespace raylib {
 
+    // phases, in pipeline order
+    struct RLUpdate {};
+    struct RLBeginDrawing {};
+    struct RLStartRender {};
+    struct RLLateLatch {};          // last chance to touch the camera before it is used
+    struct RLBeginModeCamera3D {};
+    struct RLRender3D {};
+    struct RLEndMode3D {};
+    struct RLImguiBegin {};
+    struct RLImguiRender {};
+    struct RLImguiEnd {};
+    struct RLRender2D {};
+    struct RLEndDrawing {};
 
+    // singleton
+    struct main_context_t {
+        Camera3D camera;
+    };
+
+    // singleton, settings read by the pipeline systems
+    struct render_config_t {
+        Color clear_color = RAYWHITE;
+        bool  imgui = true;          // run rlImGuiBegin/End (needs rlImGuiSetup)
+    };
+
+    // The phases only, no systems (module_raylib_phases.cpp). For modules
+    // that schedule work in RLUpdate but draw nothing; module imports it.
+    struct phases {
+        phases(flecs::world& world); // Ctor that loads the module
+    };
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
 
-#ifdef __cplusplus
 }
-#endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "bake_config.h"
+#include "module_transform_3d_hierarchy.hpp"
+#include <cstdint>
+#include <vector>
+
+// ---------------------------------------------------------------
+//  scene – renderable scene content and bulk construction
+// ---------------------------------------------------------------
+namespace scene {
+
+    using transform_3d::Transform3D;
+
+    // Render data below is registered with (OnInstantiate, Inherit): put it
+    // on a prefab and every IsA instance reads the prefab's copy, so an
+    // instance only stores its Transform3D.
+    struct cube_t {
+        Vector3 size;
+        Color color;
+    };
+
+    struct mesh_t {
+        Mesh mesh;
+        Material material;
+    };
+
+    // Arrays are indexed per entity and must hold `count` entries.
+    // parents / prefabs / cubes may be null (roots / no IsA / no cube).
+    struct spawn_desc_t {
+        int32_t                count = 0;
+        const Transform3D*     transforms = nullptr;
+        const flecs::entity_t* parents = nullptr;
+        const flecs::entity_t* prefabs = nullptr;
+        const cube_t*          cubes = nullptr;
+    };
+
+    // Create desc.count entities straight in their final table with
+    // ecs_bulk_init – one call per (parent, prefab) instead of one archetype move per
+    // component per entity. Must be called outside of systems (not deferred).
+    // Entity ids are written to out (count entries) in input order.
+    void spawn(flecs::world& world, const spawn_desc_t& desc, flecs::entity_t* out);
+    std::vector<flecs::entity_t> spawn(flecs::world& world, const spawn_desc_t& desc);
+
+    // Prefab templates for shared render data.
+    flecs::entity cube_prefab(flecs::world& world, const char* name, Vector3 size, Color color);
+    flecs::entity mesh_prefab(flecs::world& world, const char* name, Mesh mesh, Material material);
+
+    // Per-entity memory of everything with a Transform3D. "unshared" is what
+    // the same entities would cost if inherited components were copied into
+    // every instance.
+    struct memory_report_t {
+        int32_t entities = 0;
+        int32_t prefabs = 0;
+        size_t  owned_bytes = 0;     // component columns of the instances
+        size_t  shared_bytes = 0;    // inherited components, stored once per prefab
+        size_t  unshared_bytes = 0;  // owned + inherited copied per instance
+
+        float bytes_per_entity() const {
+            return entities ? (float)(owned_bytes + shared_bytes) / (float)entities : 0.0f;
+        }
+        float bytes_per_entity_unshared() const {
+            return entities ? (float)unshared_bytes / (float)entities : 0.0f;
+        }
+    };
+
+    memory_report_t memory_report(flecs::world& world);
+    void log_memory_report(flecs::world& world);
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
+
+}
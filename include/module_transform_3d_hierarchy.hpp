@@ -1,13 +1,25 @@
 #pragma once
 
 #include "bake_config.h"
+#include <cstdint>
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+// ---------------------------------------------------------------
+//  transform_3d – hierarchical 3-D transform (position/rot/scale)
+// ---------------------------------------------------------------
+namespace transform_3d {
 
+    struct Transform3D {
+        Vector3    position{0,0,0};   // local translation
+        Quaternion rotation{0,0,0,1}; // local rotation (identity)
+        Vector3    scale{1,1,1};      // local scale
+        Matrix     localMatrix{};     // cached local matrix
+        Matrix     worldMatrix{};     // cached world matrix
+        bool       isDirty{true};     // true → needs recalculation
+        int64_t    updateFrame{-1};   // frame the world matrix was last rebuilt
+    };
 
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
 
-#ifdef __cplusplus
 }
-#endif
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "bake_config.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ---------------------------------------------------------------
+//  undo – transaction based undo/redo of component bytes
+// ---------------------------------------------------------------
+// An operation touches the components (or single fields) it is about to
+// change, edits them, then commits. Only the changed byte runs are kept,
+// each with its old and new bytes (delta::encode_runs), so history size
+// and undo cost follow the amount of data that changed, not the scene size.
+//
+//   undo::history_t& h = world.get_mut<undo::history_t>();
+//   h.begin("move", e);                  // merge key: coalesce drags of e
+//   h.touch(world, e, &Transform3D::position);
+//   e.get_mut<Transform3D>().position = p;
+//   h.commit(world);
+//
+// Undo and redo write the recorded values back. An entry whose data was
+// changed outside of the history since (a player walking the entity the
+// editor moved) is refused, logged and left in place rather than
+// overwriting the newer value. Touch only the fields the operation edits,
+// so unrelated writes to the same component (cached matrices, frame
+// counters) don't block it. Only trivially copyable components are
+// recorded; entity creation and deletion are not covered.
+namespace undo {
+
+    // singleton
+    class history_t {
+    public:
+        history_t();
+        explicit history_t(size_t memory_cap);
+
+        // ---- transaction ----------------------------------------------
+        // Commits with the same non-zero merge_key within merge_window
+        // seconds of each other fold into one entry (gizmo drags).
+        void begin(const char* label, uint64_t merge_key = 0);
+        void touch(flecs::world& world, flecs::entity_t e, flecs::id_t id);   // whole component
+        void touch(flecs::world& world, flecs::entity_t e, flecs::id_t id, uint32_t offset, uint32_t size);
+        template <typename T>
+        void touch(flecs::world& world, flecs::entity_t e) {
+            touch(world, e, world.id<T>());
+        }
+        template <typename T, typename F>
+        void touch(flecs::world& world, flecs::entity_t e, F T::* field) {
+            touch(world, e, world.id<T>(), field_offset(field), (uint32_t)sizeof(F));
+        }
+        void commit(flecs::world& world);
+        void cancel(flecs::world& world);   // restore the touched components
+        bool in_transaction() const { return open_; }
+
+        // ---- history --------------------------------------------------
+        bool undo(flecs::world& world);
+        bool redo(flecs::world& world);
+        bool can_undo() const { return cursor_ > 0; }
+        bool can_redo() const { return cursor_ < entries_.size(); }
+        const char* undo_label() const;
+        const char* redo_label() const;
+        void clear();
+
+        // The oldest entries are dropped past the cap, the newest one is
+        // always kept.
+        size_t memory_used() const { return memory_; }
+        size_t memory_cap() const { return memory_cap_; }
+        void set_memory_cap(size_t bytes);
+        size_t size() const { return entries_.size(); }
+
+        double merge_window = 0.5;
+
+        // Called after a component was restored by undo/redo/cancel, e.g.
+        // to flag Transform3D dirty. Refused entries restore nothing.
+        using restore_hook_t = std::function<void(flecs::world&, flecs::entity_t, void* ptr)>;
+        void set_restore_hook(flecs::id_t id, restore_hook_t hook);
+
+    private:
+        template <typename T, typename F>
+        static uint32_t field_offset(F T::* field) {
+            alignas(T) static unsigned char storage[sizeof(T)];
+            const T* t = reinterpret_cast<const T*>(storage);
+            return (uint32_t)(reinterpret_cast<const unsigned char*>(&(t->*field)) - storage);
+        }
+
+        struct change_t {
+            flecs::entity_t e;
+            flecs::id_t     id;
+            uint32_t        field;    // byte offset of the recorded range in the component
+            uint32_t        size;     // bytes recorded
+            uint32_t        offset;   // into entry_t::data (or before_ while open)
+            uint32_t        length;
+        };
+
+        struct entry_t {
+            std::string           label;
+            uint64_t              merge_key;
+            double                time;
+            std::vector<change_t> changes;
+            std::vector<uint8_t>  data;
+
+            size_t bytes() const {
+                return sizeof(entry_t) + label.capacity() +
+                       changes.capacity() * sizeof(change_t) + data.capacity();
+            }
+        };
+
+        bool apply(flecs::world& world, const entry_t& entry, bool reverse);
+        void restored(flecs::world& world, flecs::entity_t e, flecs::id_t id, void* ptr);
+        bool merge_into(flecs::world& world, entry_t& last, const entry_t& next);
+        void push(flecs::world& world, entry_t&& entry);
+        void enforce_cap();
+
+        std::deque<entry_t> entries_;
+        size_t cursor_ = 0;          // entries [0, cursor_) are applied
+        size_t memory_ = 0;
+        size_t memory_cap_ = 32u << 20;
+
+        // open transaction
+        bool                  open_ = false;
+        std::string           label_;
+        uint64_t              merge_key_ = 0;
+        std::vector<change_t> touched_;
+        std::vector<uint8_t>  before_;
+
+        std::vector<uint8_t>  scratch_;
+        std::unordered_map<flecs::id_t, restore_hook_t> hooks_;
+    };
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "bake_config.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+// ---------------------------------------------------------------
+//  world_partition – stream grid cells around the camera
+// ---------------------------------------------------------------
+// The XZ plane is split into square cells, each stored as a scene snapshot
+// (<directory>/cell_<x>_<z>.rlsc). Every frame the camera of
+// raylib::main_context_t picks the wanted cells:
+//
+//   ring <= load_radius      instantiated (entities live in the world)
+//   ring <= prefetch_radius  file read into memory on the loader thread
+//   further                  unloaded / dropped
+//
+// A loaded cell is an entity with cell_t; the snapshot roots and prefabs
+// are its children, so unloading is a single delete. The file I/O runs on
+// a background thread, and entities are created on the main thread, at most
+// max_loads_per_frame cells per frame.
+//
+//   world.import<world_partition::module>();
+//   world_partition::bake_cells(world, "cells");   // editor: split a scene
+namespace world_partition {
+
+    // component on the cell root entity
+    struct cell_t {
+        int32_t x;
+        int32_t z;
+        size_t  bytes;          // estimated resident cost
+        int32_t entities;
+    };
+
+    // singleton
+    struct partition_config_t {
+        float       cell_size = 32.0f;
+        int32_t     load_radius = 1;           // in cells (Chebyshev ring)
+        int32_t     prefetch_radius = 2;       // >= load_radius
+        size_t      memory_budget = 256u << 20; // prefetched bytes + loaded estimate
+        size_t      bytes_per_entity = 160;    // resident estimate, see scene::memory_report
+        int32_t     max_loads_per_frame = 2;
+        std::string directory = "cells";
+    };
+
+    // Hooks for systems that keep extra per-cell state (physics bodies...).
+    // on_loaded runs after the cell's entities exist, on_unloading before
+    // they are deleted. Both run in the immediate world_partition_system, so
+    // physics::add_bodies / remove_body can be called from them (see
+    // cell_loaded in main_flecs_jolt.cpp).
+    struct partition_hooks_t {
+        std::function<void(flecs::world&, flecs::entity cell)> on_loaded;
+        std::function<void(flecs::world&, flecs::entity cell)> on_unloading;
+    };
+
+    struct partition_stats_t {
+        int32_t loaded = 0;        // instantiated cells
+        int32_t prefetched = 0;    // cells held in memory only
+        int32_t pending = 0;       // reads in flight
+        size_t  resident_bytes = 0;
+        bool    over_budget = false;
+    };
+
+    struct streamer_t;
+
+    // singleton, owns the loader thread
+    struct partition_state_t {
+        partition_state_t();
+        ~partition_state_t();
+        partition_state_t(partition_state_t&&) noexcept;
+        partition_state_t& operator=(partition_state_t&&) noexcept;
+
+        std::unique_ptr<streamer_t> streamer;
+        partition_hooks_t hooks;
+        partition_stats_t stats;
+    };
+
+    // Split every root entity with a Transform3D into cell snapshots by its
+    // position. Returns the number of cells written.
+    int32_t bake_cells(flecs::world& world, const char* directory, float cell_size);
+
+    // Stream towards `position` now (also what the module system does).
+    void update(flecs::world& world, Vector3 position);
+
+    // Delete every loaded cell and drop the prefetch cache.
+    void unload_all(flecs::world& world);
+
+    struct module {
+        module(flecs::world& world); // Ctor that loads the module
+    };
+
+}
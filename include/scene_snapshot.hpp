@@ -0,0 +1,112 @@
+#pragma once
+
+#include "module_scene.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// ---------------------------------------------------------------
+//  scene snapshot – compact binary scene format
+// ---------------------------------------------------------------
+// Layout (little endian, every chunk 16-byte aligned):
+//
+//   snapshot_header_t
+//   snapshot_chunk_t[chunk_count]     chunk table
+//   chunk data...
+//
+// Entities are stored in depth order and, inside a depth level, grouped by
+// (parent, prefab, owns cube) so the loader can feed whole runs straight
+// into scene::spawn(). Columns are one chunk per component:
+//
+//   EIDS  uint64   saved entity id per entity (id remap table)
+//   HIER  int32    parent index per entity, -1 for roots
+//   LEVL  level_t  first/count per depth level
+//   XFRM  xform_t  position/rotation/scale per entity
+//   ISA_  int32    prefab index per entity, -1 for none
+//   FLAG  uint8    per entity, SNAPSHOT_OWNS_CUBE
+//   CUBE  cube_t   one per entity that owns a cube, in entity order
+//   PREF  prefab_t prefab table
+//
+// Only data that round-trips without a GPU is saved: mesh_t prefabs are
+// skipped.
+namespace scene {
+
+    constexpr uint32_t SNAPSHOT_VERSION = 1;
+    constexpr uint8_t  SNAPSHOT_OWNS_CUBE = 1u << 0;
+
+    constexpr uint32_t snapshot_tag(char a, char b, char c, char d) {
+        return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) |
+               ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+    }
+
+    struct snapshot_header_t {
+        char     magic[4];        // "RLSC"
+        uint32_t version;
+        uint32_t entity_count;
+        uint32_t chunk_count;
+        uint32_t level_count;
+        uint32_t prefab_count;
+        uint32_t reserved[2];
+    };
+
+    struct snapshot_chunk_t {
+        uint32_t tag;
+        uint32_t elem_size;
+        uint32_t count;
+        uint32_t reserved;
+        uint64_t offset;          // from start of file
+        uint64_t size;            // bytes
+    };
+
+    struct snapshot_level_t {
+        uint32_t first;
+        uint32_t count;
+    };
+
+    struct snapshot_xform_t {
+        Vector3    position;
+        Quaternion rotation;
+        Vector3    scale;
+    };
+
+    struct snapshot_prefab_t {
+        uint64_t saved_id;
+        uint32_t flags;           // SNAPSHOT_OWNS_CUBE
+        cube_t   cube;
+    };
+
+    // saved entity / prefab id -> id created by the load
+    using snapshot_remap_t = std::unordered_map<uint64_t, flecs::entity_t>;
+
+    // Copy the header out of `data` and check it: magic, version, a chunk
+    // table that fits and an entity count the buffer can hold. Logs and
+    // returns false otherwise. Read nothing from a header before this.
+    bool read_snapshot_header(const void* data, size_t size, snapshot_header_t& out);
+
+    // Save every entity with a Transform3D.
+    bool save_snapshot(flecs::world& world, const char* path);
+
+    // Save only `roots` and their Transform3D descendants.
+    bool save_snapshot(flecs::world& world, const char* path,
+                       const flecs::entity_t* roots, int32_t count);
+
+    // Load into the world. The file is memory mapped and its columns are
+    // handed to scene::spawn() level by level. New entity ids are written to
+    // out_entities (indexed like the file) when it is not null, and
+    // out_remap maps the saved ids (EIDS and the prefab table) to them, so
+    // ids kept elsewhere can be fixed up. When `parent` is set, saved roots
+    // and the loaded prefabs become its children, so deleting `parent`
+    // removes everything the load created.
+    bool load_snapshot(flecs::world& world, const char* path,
+                       std::vector<flecs::entity_t>* out_entities = nullptr,
+                       flecs::entity_t parent = 0,
+                       snapshot_remap_t* out_remap = nullptr);
+
+    // Same, from a buffer already in memory (prefetched cells etc).
+    bool load_snapshot_memory(flecs::world& world, const void* data, size_t size,
+                              std::vector<flecs::entity_t>* out_entities = nullptr,
+                              flecs::entity_t parent = 0,
+                              snapshot_remap_t* out_remap = nullptr);
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "bake_config.h"
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Collision/Shape/Shape.h>
+#include <Jolt/Physics/Collision/Shape/ConvexShape.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+// ---------------------------------------------------------------
+//  shapes – deduplicated Jolt shapes, one instance per parameter set
+// ---------------------------------------------------------------
+// Bodies with the same collider share one JPH::Shape instead of each
+// creating its own: less memory, and the narrow phase keeps touching the
+// same shape data. Shapes are keyed by type and parameters, compared bit
+// for bit (no rounding, 0.5 and 0.5001 are two shapes).
+//
+//   JPH::BodyCreationSettings settings(shapes::shared().box({ 0.5f, 0.5f, 0.5f }), ...);
+//
+// Shapes are immutable once created, so sharing is safe across bodies,
+// characters and threads. The cache keeps one reference per shape; trim()
+// drops the shapes nobody else holds any more (after unloading a level).
+namespace shapes {
+
+    enum class shape_type_t : uint8_t {
+        sphere,
+        box,
+        capsule,
+        cylinder,
+        count
+    };
+
+    struct cache_stats_t {
+        int32_t  shapes = 0;            // unique shapes held
+        int32_t  users = 0;             // references held outside the cache
+        int32_t  per_type[(int)shape_type_t::count] = {};
+        uint64_t hits = 0;
+        uint64_t misses = 0;            // shapes created
+        size_t   bytes = 0;             // Shape::GetStats() of the held shapes
+        size_t   saved_bytes = 0;       // what one copy per user would have added
+    };
+
+    class cache_t {
+    public:
+        cache_t() = default;
+        cache_t(const cache_t&) = delete;
+        cache_t& operator=(const cache_t&) = delete;
+
+        // nullptr (and a log line) for invalid parameters
+        JPH::ShapeRefC sphere(float radius);
+        JPH::ShapeRefC box(Vector3 half_extents, float convex_radius = JPH::cDefaultConvexRadius);
+        JPH::ShapeRefC capsule(float half_height, float radius);   // upright, half of the cylinder part
+        JPH::ShapeRefC cylinder(float half_height, float radius, float convex_radius = JPH::cDefaultConvexRadius);
+
+        // Drop shapes only the cache still references, returns how many.
+        int32_t trim();
+        void clear();
+
+        cache_stats_t stats() const;   // walks every held shape
+
+    private:
+        struct key_t {
+            shape_type_t type;
+            uint32_t     params[4];   // float bits
+
+            bool operator==(const key_t& o) const;
+        };
+
+        struct key_hash_t {
+            size_t operator()(const key_t& k) const;
+        };
+
+        JPH::ShapeRefC find_or_create(const key_t& key);
+
+        mutable std::mutex mutex_;
+        std::unordered_map<key_t, JPH::ShapeRefC, key_hash_t> shapes_;
+        uint64_t hits_ = 0;
+        uint64_t misses_ = 0;
+    };
+
+    // process wide cache, shapes do not belong to a world
+    cache_t& shared();
+
+}
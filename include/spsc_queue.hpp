@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// ---------------------------------------------------------------
+//  spsc_queue – bounded lock-free single producer / single consumer ring
+// ---------------------------------------------------------------
+// push() from one thread, pop() from one (possibly other) thread. No
+// allocation after construction; push() fails when the ring is full.
+template <typename T, size_t Capacity>
+class spsc_queue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool push(const T& value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Capacity) return false;
+        items_[head & (Capacity - 1)] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        out = items_[tail & (Capacity - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // exact only when called from the producer or the consumer while the
+    // other side is idle
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    alignas(64) std::atomic<size_t> head_{0};   // written by the producer
+    alignas(64) std::atomic<size_t> tail_{0};   // written by the consumer
+    T items_[Capacity];
+};
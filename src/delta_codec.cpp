@@ -0,0 +1,137 @@
+#include "delta_codec.hpp"
+#include <cstring>
+
+namespace delta {
+
+    static void put_varint(std::vector<uint8_t>& out, size_t v) {
+        while (v >= 0x80) {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t)v);
+    }
+
+    static bool get_varint(const uint8_t*& p, const uint8_t* end, size_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end) return false;
+            const uint8_t b = *p++;
+            v |= (size_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    size_t encode(const void* before, const void* after, size_t size, std::vector<uint8_t>& out) {
+        const uint8_t* a = static_cast<const uint8_t*>(before);
+        const uint8_t* b = static_cast<const uint8_t*>(after);
+        const size_t start = out.size();
+
+        size_t i = 0;
+        while (i < size) {
+            // zero run
+            size_t skip = i;
+            while (skip < size && a[skip] == b[skip]) skip++;
+            if (skip == size) break;
+
+            // literal run, ends at the first pair of equal bytes so a
+            // single unchanged byte doesn't split it
+            size_t end = skip;
+            while (end < size) {
+                if (a[end] == b[end] && (end + 1 == size || a[end + 1] == b[end + 1])) break;
+                end++;
+            }
+
+            put_varint(out, skip - i);
+            put_varint(out, end - skip);
+            for (size_t k = skip; k < end; k++) out.push_back(a[k] ^ b[k]);
+            i = end;
+        }
+        return out.size() - start;
+    }
+
+    bool apply(const uint8_t* data, size_t len, void* target, size_t size) {
+        uint8_t* t = static_cast<uint8_t*>(target);
+        const uint8_t* p = data;
+        const uint8_t* end = data + len;
+        size_t pos = 0;
+
+        while (p < end) {
+            size_t skip, count;
+            if (!get_varint(p, end, skip) || !get_varint(p, end, count)) return false;
+            if (skip > size - pos || count > size - pos - skip) return false;
+            if (count > (size_t)(end - p)) return false;
+            pos += skip;
+            for (size_t k = 0; k < count; k++) t[pos + k] ^= p[k];
+            p += count;
+            pos += count;
+        }
+        return true;
+    }
+
+
+    // ------------------------------------------------------------
+    //  runs with both sides
+    // ------------------------------------------------------------
+    size_t encode_runs(const void* before, const void* after, size_t size, std::vector<uint8_t>& out) {
+        const uint8_t* a = static_cast<const uint8_t*>(before);
+        const uint8_t* b = static_cast<const uint8_t*>(after);
+        const size_t start = out.size();
+
+        size_t i = 0;
+        while (i < size) {
+            size_t skip = i;
+            while (skip < size && a[skip] == b[skip]) skip++;
+            if (skip == size) break;
+
+            size_t end = skip;
+            while (end < size) {
+                if (a[end] == b[end] && (end + 1 == size || a[end + 1] == b[end + 1])) break;
+                end++;
+            }
+
+            put_varint(out, skip - i);
+            put_varint(out, end - skip);
+            out.insert(out.end(), a + skip, a + end);
+            out.insert(out.end(), b + skip, b + end);
+            i = end;
+        }
+        return out.size() - start;
+    }
+
+    // Walk the runs, fn(pos, before, after, count) returns false to stop.
+    template <typename F>
+    static bool walk_runs(const uint8_t* data, size_t len, size_t size, F&& fn) {
+        const uint8_t* p = data;
+        const uint8_t* end = data + len;
+        size_t pos = 0;
+
+        while (p < end) {
+            size_t skip, count;
+            if (!get_varint(p, end, skip) || !get_varint(p, end, count)) return false;
+            if (skip > size - pos || count > size - pos - skip) return false;
+            if (count > (size_t)(end - p) / 2) return false;
+            pos += skip;
+            if (!fn(pos, p, p + count, count)) return false;
+            p += 2 * count;
+            pos += count;
+        }
+        return true;
+    }
+
+    bool holds_runs(const uint8_t* data, size_t len, const void* target, size_t size, side_t side) {
+        const uint8_t* t = static_cast<const uint8_t*>(target);
+        return walk_runs(data, len, size, [&](size_t pos, const uint8_t* before, const uint8_t* after, size_t count) {
+            return memcmp(t + pos, side == side_t::before ? before : after, count) == 0;
+        });
+    }
+
+    bool apply_runs(const uint8_t* data, size_t len, void* target, size_t size, side_t to) {
+        uint8_t* t = static_cast<uint8_t*>(target);
+        return walk_runs(data, len, size, [&](size_t pos, const uint8_t* before, const uint8_t* after, size_t count) {
+            memcpy(t + pos, to == side_t::before ? before : after, count);
+            return true;
+        });
+    }
+
+}
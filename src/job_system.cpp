@@ -0,0 +1,319 @@
+#include "job_system.hpp"
+#include <algorithm>
+#include <chrono>
+
+JPH_SUPPRESS_WARNINGS
+
+namespace jobs {
+
+    // ------------------------------------------------------------
+    //  scheduler
+    // ------------------------------------------------------------
+    static thread_local const scheduler_t* t_scheduler = nullptr;
+    static thread_local int32_t t_worker = -1;
+
+    scheduler_t::scheduler_t(int32_t workers) {
+        if (workers <= 0) {
+            workers = std::max(1, (int32_t)std::thread::hardware_concurrency() - 1);
+        }
+        queues_.reserve(workers);
+        for (int32_t i = 0; i < workers; i++) {
+            queues_.push_back(std::make_unique<queue_t>());
+        }
+        threads_.reserve(workers);
+        for (int32_t i = 0; i < workers; i++) {
+            threads_.emplace_back(&scheduler_t::worker_main, this, i);
+        }
+    }
+
+    scheduler_t::~scheduler_t() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            quit_ = true;
+        }
+        sleep_cv_.notify_all();
+        for (std::thread& t : threads_) t.join();
+    }
+
+    int32_t scheduler_t::worker_index() const {
+        return t_scheduler == this ? t_worker : -1;
+    }
+
+    void scheduler_t::submit(task_t task, priority_t priority) {
+        int32_t q = worker_index();
+        if (q < 0) {
+            q = (int32_t)(next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size());
+        }
+        {
+            std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+            queues_[q]->tasks[(int)priority].push_back(task);
+        }
+        pending_.fetch_add(1, std::memory_order_release);
+
+        // the lock pairs with the sleep check, so the wakeup cannot be missed
+        { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+        sleep_cv_.notify_one();
+    }
+
+    bool scheduler_t::pop(int32_t self, task_t& out) {
+        const int32_t n = (int32_t)queues_.size();
+        for (int p = 0; p < (int)priority_t::count; p++) {
+            // own deque, newest first
+            if (self >= 0) {
+                queue_t& q = *queues_[self];
+                std::lock_guard<std::mutex> lock(q.mutex);
+                if (!q.tasks[p].empty()) {
+                    out = q.tasks[p].back();
+                    q.tasks[p].pop_back();
+                    pending_.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            // steal oldest from the others
+            const int32_t start = self >= 0 ? self + 1 : 0;
+            for (int32_t k = 0; k < n; k++) {
+                const int32_t v = (start + k) % n;
+                if (v == self) continue;
+                queue_t& q = *queues_[v];
+                std::lock_guard<std::mutex> lock(q.mutex);
+                if (!q.tasks[p].empty()) {
+                    out = q.tasks[p].front();
+                    q.tasks[p].pop_front();
+                    pending_.fetch_sub(1, std::memory_order_relaxed);
+                    if (self >= 0) stolen_.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool scheduler_t::run_one() {
+        task_t task;
+        if (pending_.load(std::memory_order_acquire) <= 0 || !pop(worker_index(), task)) return false;
+        task.fn(task.ctx, task.arg);
+        executed_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void scheduler_t::worker_main(int32_t index) {
+        t_scheduler = this;
+        t_worker = index;
+
+        for (;;) {
+            task_t task;
+            if (pending_.load(std::memory_order_acquire) > 0 && pop(index, task)) {
+                task.fn(task.ctx, task.arg);
+                executed_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            if (quit_) break;
+            if (pending_.load(std::memory_order_acquire) > 0) continue;
+            sleeps_.fetch_add(1, std::memory_order_relaxed);
+            sleep_cv_.wait(lock, [this] {
+                return quit_ || pending_.load(std::memory_order_acquire) > 0;
+            });
+            if (quit_) break;
+        }
+    }
+
+    scheduler_stats_t scheduler_t::stats() const {
+        scheduler_stats_t s;
+        s.executed = executed_.load(std::memory_order_relaxed);
+        s.stolen = stolen_.load(std::memory_order_relaxed);
+        s.sleeps = sleeps_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    scheduler_t& shared() {
+        static scheduler_t scheduler;
+        return scheduler;
+    }
+
+    // Helpers hold a reference, so one that starts after the caller returned
+    // only finds no chunks left and frees the state.
+    struct parallel_for_t {
+        range_fn_t fn = nullptr;
+        void*      ctx = nullptr;
+        int32_t    count = 0;
+        int32_t    grain = 1;
+        int32_t    chunks = 0;
+        std::atomic<int32_t> next{0};
+        std::atomic<int32_t> done{0};
+        std::atomic<int32_t> refs{1};
+    };
+
+    static void run_chunks(parallel_for_t* pf) {
+        for (;;) {
+            const int32_t c = pf->next.fetch_add(1, std::memory_order_relaxed);
+            if (c >= pf->chunks) break;
+            const int32_t begin = c * pf->grain;
+            pf->fn(pf->ctx, begin, std::min(pf->count, begin + pf->grain));
+            pf->done.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    static void release(parallel_for_t* pf) {
+        if (pf->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete pf;
+    }
+
+    static void parallel_for_task(void*, void* arg) {
+        parallel_for_t* pf = (parallel_for_t*)arg;
+        run_chunks(pf);
+        release(pf);
+    }
+
+    void parallel_for(scheduler_t& scheduler, int32_t count, int32_t grain, range_fn_t fn, void* ctx,
+                      priority_t priority)
+    {
+        if (count <= 0) return;
+        grain = std::max(1, grain);
+        const int32_t chunks = (count + grain - 1) / grain;
+        if (chunks == 1 || scheduler.worker_count() == 0) {
+            fn(ctx, 0, count);
+            return;
+        }
+
+        parallel_for_t* pf = new parallel_for_t();
+        pf->fn = fn;
+        pf->ctx = ctx;
+        pf->count = count;
+        pf->grain = grain;
+        pf->chunks = chunks;
+        const int32_t helpers = std::min(chunks - 1, scheduler.worker_count());
+        pf->refs.store(1 + helpers, std::memory_order_relaxed);
+        for (int32_t i = 0; i < helpers; i++) {
+            scheduler.submit({ parallel_for_task, nullptr, pf }, priority);
+        }
+
+        run_chunks(pf);
+        while (pf->done.load(std::memory_order_acquire) < chunks) std::this_thread::yield();
+        release(pf);
+    }
+
+    // ------------------------------------------------------------
+    //  Jolt
+    // ------------------------------------------------------------
+    jolt_job_system_t::jolt_job_system_t(scheduler_t& scheduler, JPH::uint max_jobs,
+                                         JPH::uint max_barriers, priority_t priority)
+        : JPH::JobSystemWithBarrier(max_barriers)
+        , scheduler_(scheduler)
+        , priority_(priority)
+    {
+        jobs_.Init(max_jobs, max_jobs);
+    }
+
+    // Every job has been waited for through a barrier, but a barrier wait
+    // may have run a job whose scheduler task is still queued. Drain those
+    // before the job list goes away.
+    jolt_job_system_t::~jolt_job_system_t() {
+        while (queued_.load(std::memory_order_acquire) > 0) {
+            if (!scheduler_.run_one()) std::this_thread::yield();
+        }
+    }
+
+    int jolt_job_system_t::GetMaxConcurrency() const {
+        return scheduler_.worker_count() + 1;   // + the thread that waits
+    }
+
+    jolt_job_system_t::JobHandle jolt_job_system_t::CreateJob(const char* name, JPH::ColorArg color,
+                                                const JobFunction& function, JPH::uint32 num_dependencies)
+    {
+        JPH::uint32 index;
+        for (;;) {
+            index = jobs_.ConstructObject(name, color, this, function, num_dependencies);
+            if (index != job_list_t::cInvalidObjectIndex) break;
+            JPH_ASSERT(false, "No jobs available!");
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        Job* job = &jobs_.Get(index);
+
+        JobHandle handle(job);
+        if (num_dependencies == 0) QueueJob(job);
+        return handle;
+    }
+
+    void jolt_job_system_t::run_job(void* ctx, void* arg) {
+        jolt_job_system_t* self = (jolt_job_system_t*)ctx;
+        Job* job = (Job*)arg;
+        job->Execute();   // no-op if a barrier wait already ran it
+        job->Release();
+        self->queued_.fetch_sub(1, std::memory_order_release);
+    }
+
+    void jolt_job_system_t::QueueJob(Job* job) {
+        job->AddRef();   // released by run_job
+        queued_.fetch_add(1, std::memory_order_relaxed);
+        scheduler_.submit({ run_job, this, job }, priority_);
+    }
+
+    void jolt_job_system_t::QueueJobs(Job** jobs, JPH::uint count) {
+        for (JPH::uint i = 0; i < count; i++) QueueJob(jobs[i]);
+    }
+
+    void jolt_job_system_t::FreeJob(Job* job) {
+        jobs_.DestructObject(job);
+    }
+
+    // ------------------------------------------------------------
+    //  flecs
+    // ------------------------------------------------------------
+    struct flecs_task_t {
+        ecs_os_thread_callback_t callback;
+        void* param;
+        void* result = nullptr;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+    };
+
+    static scheduler_t* g_flecs_scheduler = nullptr;
+    static priority_t g_flecs_priority = priority_t::ecs;
+
+    static void run_flecs_task(void*, void* arg) {
+        flecs_task_t* task = (flecs_task_t*)arg;
+        void* result = task->callback(task->param);
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->result = result;
+        task->done = true;
+        task->cv.notify_all();
+    }
+
+    static ecs_os_thread_t flecs_task_new(ecs_os_thread_callback_t callback, void* param) {
+        flecs_task_t* task = new flecs_task_t();
+        task->callback = callback;
+        task->param = param;
+        g_flecs_scheduler->submit({ run_flecs_task, nullptr, task }, g_flecs_priority);
+        return (ecs_os_thread_t)(uintptr_t)task;
+    }
+
+    // Plain wait, no helping: a flecs worker picked up here could block on
+    // its peers and stall the joining thread.
+    static void* flecs_task_join(ecs_os_thread_t handle) {
+        flecs_task_t* task = (flecs_task_t*)(uintptr_t)handle;
+        void* result;
+        {
+            std::unique_lock<std::mutex> lock(task->mutex);
+            task->cv.wait(lock, [task] { return task->done; });
+            result = task->result;
+        }
+        delete task;
+        return result;
+    }
+
+    void install_flecs_tasks(scheduler_t& scheduler, priority_t priority) {
+        g_flecs_scheduler = &scheduler;
+        g_flecs_priority = priority;
+
+        // load the default OS api first so ecs_init does not replace ours
+#ifdef FLECS_OS_API_IMPL
+        ecs_set_os_api_impl();
+#else
+        ecs_os_set_api_defaults();
+#endif
+        ecs_os_api.task_new_ = flecs_task_new;
+        ecs_os_api.task_join_ = flecs_task_join;
+    }
+}
@@ -8,20 +8,9 @@
 #include "imgui.h"
 #include "rlImGui.h"	        // include the API header
 #include "bake_config.h"
+#include "module_raylib.hpp"
 #include <iostream>
 
-// phases
-flecs::entity RLUpdate;
-flecs::entity RLBeginDrawing;
-flecs::entity RLStartRender;
-flecs::entity RLBeginModeCamera3D;
-flecs::entity RLRender3D;
-flecs::entity RLEndMode3D;
-flecs::entity RLImguiBegin;
-flecs::entity RLImguiRender;
-flecs::entity RLImguiEnd;
-flecs::entity RLRender2D;
-flecs::entity RLEndDrawing;
 // components
 struct cube_t {
     Vector3 position;
@@ -31,9 +20,7 @@ struct cube_t {
 struct velocity_t {
     Vector3 value{0,0,0};
 };
-struct main_context_t {
-    Camera3D camera;
-};
+using raylib::main_context_t;
 struct player_controller_t {
     flecs::entity id;
 };
@@ -48,39 +35,6 @@ struct imgui_test_t {
 void Sys(flecs::iter& it) {
     std::cout << "system " << it.system().name() << "\n";
 }
-// BeginDrawing
-void begin_drawing_system(flecs::iter& it) {
-    BeginDrawing();
-}
-// ClearBackground
-void render_2d_background_color_system(flecs::iter& it) {
-    ClearBackground(RAYWHITE);
-}
-// begin mode camera 3d
-void begin_camera_mode_3d_system(flecs::iter& it) {
-    // TraceLog(LOG_INFO,"Begin Camera 3D");
-    flecs::world world = it.world();
-    if (!world.has<main_context_t>()) { //check for single access
-        return; // Singleton destroyed, skip
-    }
-    // TraceLog(LOG_INFO,"Begin Camera 3D and main_context_t");
-    const main_context_t& ctx = world.get<main_context_t>();
-    Camera3D& cam = const_cast<Camera3D&>(ctx.camera); // non-const ref
-    BeginMode3D(cam);
-}
-// end camera mode 3d
-void end_camera_mode_3d_system(flecs::iter& it) {
-    // TraceLog(LOG_INFO,"End Camera 3D");
-    flecs::world world = it.world();
-    if (!world.has<main_context_t>()) { //check for single access
-        return; // Singleton destroyed, skip to prevent crashed.
-    }
-    EndMode3D();
-}
-// rlImGuiBegin
-void imgui_begin_system(flecs::iter& it) {
-    rlImGuiBegin();
-}
 // imgui set up widgets
 void imgui_render_system(flecs::iter& it) {
 
@@ -105,14 +59,6 @@ void imgui_render_system(flecs::iter& it) {
     }
     ImGui::End();
 }
-// rlImGuiEnd
-void imgui_end_system(flecs::iter& it) {
-    rlImGuiEnd();
-}
-// EndDrawing
-void end_drawing_system(flecs::iter& it) {
-    EndDrawing();
-}
 //-----------------------------------------------
 // player
 //-----------------------------------------------
@@ -190,41 +136,18 @@ void player_move_system(flecs::iter& it)
 // setup system functions
 void init_systems(flecs::world& ecs) {
     TraceLog(LOG_INFO, "init_systems");
-    // Phases
-    ecs.system("begin_drawing_system")
-        .kind(RLBeginDrawing)
-        .run(begin_drawing_system);
-    // background
-    ecs.system("render_2d_background_color_system")
-        .kind(RLStartRender)
-        .run(render_2d_background_color_system);
-    ecs.system("imgui_begin_system")
-        .kind(RLImguiBegin)
-        .run(imgui_begin_system);
     ecs.system("imgui_render_system")
-        .kind(RLImguiRender)
+        .kind<raylib::RLImguiRender>()
         .run(imgui_render_system);
-    ecs.system("imgui_end_system")
-        .kind(RLImguiEnd)
-        .run(imgui_end_system);
-    ecs.system("end_drawing_system")
-        .kind(RLEndDrawing)
-        .run(end_drawing_system);
-    ecs.system("begin_camera_mode_3d_system")
-        .kind(RLBeginModeCamera3D)
-        .run(begin_camera_mode_3d_system);
-    ecs.system("end_camera_mode_3d_system")
-        .kind(RLEndMode3D)
-        .run(end_camera_mode_3d_system);
     // player
     ecs.system("player_input_system")
-        .kind(RLUpdate)
+        .kind<raylib::RLUpdate>()
         .run(player_input_system);
     ecs.system("player_move_system")
-        .kind(RLUpdate)               // runs right after player_input_system
+        .kind<raylib::RLUpdate>()     // runs right after player_input_system
         .run(player_move_system);
     ecs.system<cube_t>("render_3d_cube_system")
-    .kind(RLRender3D)
+    .kind<raylib::RLRender3D>()
     .each([](cube_t& cube) {
         // TraceLog(LOG_INFO, "render???");
         // Each is invoked for each entity
@@ -234,49 +157,7 @@ void init_systems(flecs::world& ecs) {
 }
 // set up components
 void setup_components(flecs::world& ecs) {
-    // UPDATE RL
-    RLUpdate = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(flecs::OnUpdate);
-    // BeginDrawing
-    RLBeginDrawing = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLUpdate);
-
-    RLStartRender = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLBeginDrawing);
-    // Camera 3D
-    RLBeginModeCamera3D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLStartRender);
-    RLRender3D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLBeginModeCamera3D);
-    RLEndMode3D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLRender3D);
-    // imgui
-    RLImguiBegin = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLEndMode3D);
-    RLImguiRender = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLImguiBegin);
-    RLImguiEnd = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLImguiRender);
-    // render 2d
-    RLRender2D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLImguiEnd);
-    // end render
-    RLEndDrawing = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLRender2D);
-
     // Register singleton component
-    ecs.component<main_context_t>().add(flecs::Singleton);
     ecs.component<player_controller_t>().add(flecs::Singleton);
     // Register component
     ecs.component<imgui_test_t>();
@@ -312,6 +193,7 @@ int main()
 
     // Create the world
     flecs::world world;
+    world.import<raylib::module>();
     // set up
     setup_components(world);
     init_systems(world);
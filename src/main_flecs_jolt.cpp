@@ -1,518 +1,462 @@
-// main.cpp
-// https://github.com/SanderMertens/flecs/blob/master/examples/cpp/game_mechanics/scene_management/src/main.cpp
-// https://github.com/SanderMertens/flecs/blob/master/examples/cpp/systems/custom_phases/src/main.cpp
+// main_flecs_jolt.cpp
+// flecs + Jolt Physics through physics::module
+// Boxes drop onto a static floor. Bodies are plain entities with
+// Transform3D + RigidBody, rendered by the scene module. A crowd of
+// CharacterVirtual NPCs wanders between them. Right mouse drag orbits the
+// camera with the late-latched mouse (input_events::module).
+// A field of pillars is baked into world_partition cells at startup and
+// streamed around the camera; each loaded cell gets static bodies through
+// physics::add_bodies, which go again when the cell unloads.
 
-#define RAYLIB_IMPLEMENTATION   // <-- tells raylib to include its source once
-#include <raylib.h>             // <-- raylib header (C API, works fine in C++)
-#include "raymath.h"
 #include "imgui.h"
 #include "rlImGui.h"	        // include the API header
 #include "bake_config.h"
-#include <iostream>
-#include <rlgl.h>
-
-
-const float MOUSE_YAW_SENSITIVITY   = 0.003f;   // radians per pixel
-const float MOUSE_PITCH_SENSITIVITY = 0.003f;
-
-// phases
-flecs::entity RLUpdate;
-flecs::entity RLBeginDrawing;
-flecs::entity RLStartRender;
-flecs::entity RLBeginModeCamera3D;
-flecs::entity RLRender3D;
-flecs::entity RLEndMode3D;
-flecs::entity RLImguiBegin;
-flecs::entity RLImguiRender;
-flecs::entity RLImguiEnd;
-flecs::entity RLRender2D;
-flecs::entity RLEndDrawing;
-
-flecs::entity parent_id;
-flecs::entity child_id;
-
-// components
-struct cube_t {
-    Vector3 position;
-    Vector3 size;
-    Color color;
+#include "module_raylib.hpp"
+#include "module_fixed_step.hpp"
+#include "module_scene.hpp"
+#include "module_input.hpp"
+#include "module_input_events.hpp"
+#include "module_frame_arena.hpp"
+#include "module_physics.hpp"
+#include "module_character.hpp"
+#include "module_physics_history.hpp"
+#include "module_world_partition.hpp"
+#include "job_system.hpp"
+#include "shape_cache.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+JPH_SUPPRESS_WARNINGS
+
+using raylib::main_context_t;
+using transform_3d::Transform3D;
+
+enum demo_action_t : int32_t {
+    ACTION_RESET,
 };
-// struct velocity_t {
-//     Vector3 value{0,0,0};
-// };
-struct main_context_t {
-    Camera3D camera;
-};
-struct player_controller_t {
-    flecs::entity id;
+
+// component, look-ahead ray of an NPC, answered for the next tick
+struct Probe {
+    physics::query_id_t query;
+    bool blocked = false;
 };
-struct imgui_test_t {
-    bool is_demo;
-    bool is_open;
-    float f;
-    ImVec4 clear_color;
+
+// singleton
+struct demo_t {
+    int32_t columns = 16;                // boxes per side
+    int32_t layers = 8;
+    flecs::entity prefab;
+    std::vector<flecs::entity_t> boxes;
+    int32_t impacts = 0;                 // hard hits on the floor
+    int32_t crowd = 500;
+    flecs::entity npc_prefab;
+    std::vector<flecs::entity_t> npcs;
 };
 
 // ---------------------------------------------------------------
-//  Transform3D – hierarchical 3-D transform (position/rot/scale)
+//  content
 // ---------------------------------------------------------------
-struct Transform3D {
-    Vector3    position{0,0,0};   // local translation
-    Quaternion rotation{0,0,0,1}; // local rotation (identity)
-    Vector3    scale{1,1,1};      // local scale
-    Matrix     localMatrix{};     // cached local matrix
-    Matrix     worldMatrix{};     // cached world matrix
-    bool       isDirty{true};     // true → needs recalculation
-};
-
-// ------------------------------------------------------------
-//  Helpers – world is now const&
-// ------------------------------------------------------------
-static void mark_hierarchy_dirty(flecs::entity e)
+static void spawn_boxes(flecs::world& world)
 {
-    if (!e.has<Transform3D>()) return;
-
-    Transform3D& t = e.get_mut<Transform3D>();
-    t.isDirty = true;
-    e.modified<Transform3D>();
+    demo_t& demo = world.get_mut<demo_t>();
+    for (flecs::entity_t e : demo.boxes) {
+        if (world.is_alive(e)) world.entity(e).destruct();   // body goes with it
+    }
+    demo.boxes.clear();
+
+    const int32_t n = demo.columns;
+    const int32_t count = n * n * demo.layers;
+    std::vector<Transform3D> transforms(count);
+    std::vector<flecs::entity_t> prefabs(count, demo.prefab);
+    for (int32_t i = 0; i < count; i++) {
+        const int32_t x = i % n;
+        const int32_t z = (i / n) % n;
+        const int32_t y = i / (n * n);
+        transforms[i].position = { (x - n / 2) * 1.1f, 4.0f + y * 1.2f, (z - n / 2) * 1.1f };
+        transforms[i].rotation = QuaternionFromAxisAngle({ 0, 1, 0 }, 0.1f * (float)i);
+    }
+    demo.boxes = scene::spawn(world, {
+        .count = count,
+        .transforms = transforms.data(),
+        .prefabs = prefabs.data()
+    });
 
-    e.children([&](flecs::entity child){
-        mark_hierarchy_dirty(child);
+    JPH::BodyCreationSettings settings(shapes::shared().box({ 0.5f, 0.5f, 0.5f }), JPH::RVec3::sZero(), JPH::Quat::sIdentity(),
+                                       JPH::EMotionType::Dynamic, physics::layers::MOVING);
+    // one broadphase batch, optimized at the next step
+    physics::add_bodies(world, {
+        .count = (int32_t)demo.boxes.size(),
+        .entities = demo.boxes.data(),
+        .settings = &settings,
+        .shared_settings = true
     });
 }
 
-static void update_transform(const flecs::world& world, flecs::entity e, Transform3D& t)
+static void spawn_crowd(flecs::world& world)
 {
-    // ---- early-out ------------------------------------------------
-    flecs::entity parent = e.parent();
-    bool parentDirty = false;
-    if (parent && parent.has<Transform3D>()) {
-        const Transform3D& pt = parent.get<Transform3D>();
-        parentDirty = pt.isDirty;
+    demo_t& demo = world.get_mut<demo_t>();
+    for (flecs::entity_t e : demo.npcs) {
+        if (world.is_alive(e)) world.entity(e).destruct();
     }
-    if (!t.isDirty && !parentDirty) return;
-
-    // ---- local matrix --------------------------------------------
-    Matrix translation = MatrixTranslate(t.position.x, t.position.y, t.position.z);
-    Matrix rotation    = QuaternionToMatrix(t.rotation);
-    Matrix scaling     = MatrixScale(t.scale.x, t.scale.y, t.scale.z);
-    t.localMatrix = MatrixMultiply(scaling, MatrixMultiply(rotation, translation));
-
-    // ---- world matrix --------------------------------------------
-    if (!parent) {
-        t.worldMatrix = t.localMatrix;
-    } else {
-        const Transform3D& pt = parent.get<Transform3D>();
-        t.worldMatrix = MatrixMultiply(t.localMatrix, pt.worldMatrix);
+    demo.npcs.clear();
+
+    const int32_t count = demo.crowd;
+    const int32_t side = (int32_t)std::ceil(std::sqrt((float)count));
+    std::vector<Transform3D> transforms(count);
+    std::vector<flecs::entity_t> prefabs(count, demo.npc_prefab);
+    for (int32_t i = 0; i < count; i++) {
+        const float x = ((i % side) - side / 2) * 1.4f;
+        const float z = ((i / side) - side / 2) * 1.4f;
+        transforms[i].position = { x, 1.0f, z };
     }
-
-    // ---- mark children dirty --------------------------------------
-    e.children([&](flecs::entity child){
-        if (child.has<Transform3D>()) {
-            Transform3D& ct = child.get_mut<Transform3D>();
-            ct.isDirty = true;
-            child.modified<Transform3D>();
-        }
+    demo.npcs = scene::spawn(world, {
+        .count = count,
+        .transforms = transforms.data(),
+        .prefabs = prefabs.data()
     });
 
-    t.isDirty = false;
+    JPH::Ref<JPH::CharacterVirtualSettings> settings = character::capsule_settings(1.2f, 0.3f);
+    for (flecs::entity_t e : demo.npcs) {
+        character::add_character(world, world.entity(e), *settings);
+        world.entity(e).add<Probe>();
+    }
 }
 
-static void update_hierarchy(const flecs::world& world, flecs::entity e)
+static void spawn_floor(flecs::world& world)
 {
-    if (!e.has<Transform3D>()) return;
+    flecs::entity floor = world.entity("Floor")
+        .set<Transform3D>({ .position = { 0, -1, 0 } })
+        .set<scene::cube_t>({ .size = { 60, 2, 60 }, .color = DARKGREEN });
+
+    JPH::BodyCreationSettings settings(shapes::shared().box({ 30.0f, 1.0f, 30.0f }),
+                                       JPH::RVec3::sZero(), JPH::Quat::sIdentity(),
+                                       JPH::EMotionType::Static, physics::layers::NON_MOVING);
+    physics::add_body(world, floor, settings, JPH::EActivation::DontActivate);
+    floor.observe<physics::contact_added_t>([](flecs::entity e, physics::contact_added_t& c) {
+        if (c.impulse > 5.0f) e.world().get_mut<demo_t>().impacts++;
+    });
 
-    Transform3D& t = e.get_mut<Transform3D>();
-    update_transform(world, e, t);
+    // spinning paddle, driven from Transform3D
+    flecs::entity paddle = world.entity("Paddle")
+        .set<Transform3D>({ .position = { 0, 0.5f, 0 } })
+        .set<scene::cube_t>({ .size = { 16, 1, 1 }, .color = MAROON });
 
-    e.children([&](flecs::entity child){
-        update_hierarchy(world, child);
-    });
+    JPH::BodyCreationSettings paddle_settings(shapes::shared().box({ 8.0f, 0.5f, 0.5f }),
+                                              JPH::RVec3::sZero(), JPH::Quat::sIdentity(),
+                                              JPH::EMotionType::Kinematic, physics::layers::MOVING);
+    physics::add_body(world, paddle, paddle_settings);
 }
 
-// ------------------------------------------------------------
-//  System – capture the world correctly
-// ------------------------------------------------------------
-static void Transform3DSystem(flecs::iter& it)
-{
-    // it.world() is an rvalue → store it in a variable first
-    const flecs::world& w = it.world();
+// ---------------------------------------------------------------
+//  streamed cells
+// ---------------------------------------------------------------
+static const char* g_cell_directory = "cells_flecs_jolt";
 
-    auto q = w.query<Transform3D>();
-    q.each([&w](flecs::entity e, Transform3D&) {
-        update_hierarchy(w, e);
+// pillars every 8 m out to 124 m, the middle stays free for the boxes
+static void bake_field(float cell_size)
+{
+    flecs::world field;
+    field.import<scene::module>();
+    flecs::entity pillar = scene::cube_prefab(field, "Pillar", { 1.0f, 4.0f, 1.0f }, GRAY);
+
+    std::vector<Transform3D> transforms;
+    for (int32_t z = -15; z <= 15; z++) {
+        for (int32_t x = -15; x <= 15; x++) {
+            if (std::abs(x) < 2 && std::abs(z) < 2) continue;
+            Transform3D t;
+            t.position = { x * 8.0f, 2.0f, z * 8.0f };
+            transforms.push_back(t);
+        }
+    }
+    std::vector<flecs::entity_t> prefabs(transforms.size(), pillar);
+    scene::spawn(field, {
+        .count = (int32_t)transforms.size(),
+        .transforms = transforms.data(),
+        .prefabs = prefabs.data()
     });
+    world_partition::bake_cells(field, g_cell_directory, cell_size);
 }
 
-void setup_transform3d(flecs::world& ecs)
+// one static box per cell root with a cube, in one add_bodies batch
+static void cell_loaded(flecs::world& world, flecs::entity cell)
 {
-    // Component
-    ecs.component<Transform3D>();
-
-    // System – give it a nice name and put it in a phase you prefer.
-    // Here we put it in the same RLUpdate phase you already use for
-    // player logic, but you can create a dedicated phase if you want.
-    ecs.system("Transform3DSystem")
-       .kind(RLUpdate)                 // <-- change to your own phase if desired
-       .run(Transform3DSystem);
+    std::vector<flecs::entity_t> entities;
+    std::vector<JPH::BodyCreationSettings> settings;
+    cell.children([&](flecs::entity e) {
+        if (e.has(flecs::Prefab)) return;
+        const Transform3D* t = e.try_get<Transform3D>();
+        const scene::cube_t* cube = e.try_get<scene::cube_t>();
+        if (!t || !cube) return;
+        const Vector3 half = Vector3Scale(Vector3Multiply(cube->size, t->scale), 0.5f);
+        entities.push_back(e.id());
+        settings.emplace_back(shapes::shared().box(half), JPH::RVec3::sZero(), JPH::Quat::sIdentity(),
+                              JPH::EMotionType::Static, physics::layers::NON_MOVING);
+    });
+    physics::add_bodies(world, {
+        .count = (int32_t)entities.size(),
+        .entities = entities.data(),
+        .settings = settings.data(),
+        .activation = JPH::EActivation::DontActivate
+    });
 }
 
+// collected first, removing RigidBody moves the entity to another table
+static void cell_unloading(flecs::world& world, flecs::entity cell)
+{
+    std::vector<flecs::entity_t> bodies;
+    cell.children([&](flecs::entity e) {
+        if (e.has<physics::RigidBody>()) bodies.push_back(e.id());
+    });
+    for (flecs::entity_t e : bodies) physics::remove_body(world.entity(e));
+}
 
 // ---------------------------------------------------------------
-// 
+//  systems
 // ---------------------------------------------------------------
-
-// Dummy system
-void Sys(flecs::iter& it) {
-    std::cout << "system " << it.system().name() << "\n";
-}
-// BeginDrawing
-void begin_drawing_system(flecs::iter& it) {
-    BeginDrawing();
-}
-// ClearBackground
-void render_2d_background_color_system(flecs::iter& it) {
-    ClearBackground(RAYWHITE);
-}
-// begin mode camera 3d
-void begin_camera_mode_3d_system(flecs::iter& it) {
-    // TraceLog(LOG_INFO,"Begin Camera 3D");
-    flecs::world world = it.world();
-    if (!world.has<main_context_t>()) { //check for single access
-        return; // Singleton destroyed, skip
-    }
-    // TraceLog(LOG_INFO,"Begin Camera 3D and main_context_t");
-    const main_context_t& ctx = world.get<main_context_t>();
-    Camera3D& cam = const_cast<Camera3D&>(ctx.camera); // non-const ref
-    BeginMode3D(cam);
-}
-// end camera mode 3d
-void end_camera_mode_3d_system(flecs::iter& it) {
-    // TraceLog(LOG_INFO,"End Camera 3D");
+void paddle_system(flecs::iter& it)
+{
     flecs::world world = it.world();
-    if (!world.has<main_context_t>()) { //check for single access
-        return; // Singleton destroyed, skip to prevent crashed.
-    }
-    EndMode3D();
-}
-// rlImGuiBegin
-void imgui_begin_system(flecs::iter& it) {
-    rlImGuiBegin();
+    flecs::entity paddle = world.lookup("Paddle");
+    if (!paddle) return;
+    Transform3D& t = paddle.get_mut<Transform3D>();
+    t.rotation = QuaternionMultiply(t.rotation, QuaternionFromAxisAngle({ 0, 1, 0 }, 0.8f * it.delta_time()));
+    t.isDirty = true;
 }
-// imgui set up widgets
-void imgui_render_system(flecs::iter& it) {
 
+// new heading every 1.5 s, derived from entity and tick; a quarter turn
+// while the probe of the last tick hits a body
+void wander_system(flecs::iter& it)
+{
     flecs::world world = it.world();
-
-    if (!world.has<imgui_test_t>()) { //check for single access
-        return; // Singleton destroyed, skip to prevent crashed.
-    }
-    imgui_test_t& ctx = world.get_mut<imgui_test_t>();
-
-
-    if (ImGui::Begin("Test Window", &ctx.is_demo))
-    {
-        ImGui::TextUnformatted(ICON_FA_JEDI);
-        ImGui::Text("Test Text.");               // Display some text (you can use a format strings too)
-        ImGui::SliderFloat("float", &ctx.f, 0.0f, 1.0f);            // Edit 1 float using a slider from 0.0f to 1.0f
-        ImGui::ColorEdit3("clear color", &ctx.clear_color.x); // Edit 3 floats representing a color
-        if (ImGui::Button("Button")){                            // Buttons return true when clicked (most widgets return true when edited/activated)
-            TraceLog(LOG_INFO, "Click");
+    const uint64_t period = world.get<fixed_step::fixed_time_t>().tick / 90;
+    while (it.next()) {
+        auto move = it.field<character::CharacterMove>(0);
+        auto probe = it.field<Probe>(1);
+        auto t = it.field<const Transform3D>(2);
+        for (auto i : it) {
+            if (const physics::query_hit_t* hit = physics::query_result(world, probe[i].query)) {
+                probe[i].blocked = hit->hit;
+            }
+            const uint64_t h = (it.entity(i).id() ^ (period * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull;
+            float angle = (float)(h >> 40) / (float)(1u << 24) * 2.0f * PI;
+            if (probe[i].blocked) angle += 0.5f * PI;
+            const Vector3 heading = { cosf(angle), 0.0f, sinf(angle) };
+            move[i].velocity = Vector3Scale(heading, 2.0f);
+            probe[i].query = physics::cast_ray(world, {
+                .origin = t[i].position,
+                .direction = Vector3Scale(heading, 1.5f),
+                .layer = physics::layers::CHARACTER
+            });
         }
-        // rlImGuiImage(&image);
     }
-    ImGui::End();
-}
-// rlImGuiEnd
-void imgui_end_system(flecs::iter& it) {
-    rlImGuiEnd();
-}
-// EndDrawing
-void end_drawing_system(flecs::iter& it) {
-    EndDrawing();
 }
-//-----------------------------------------------
-// player
-//-----------------------------------------------
-void render_3d_cube_system(flecs::iter& it) {
-    Vector3 cubePosition = { 0.0f, 0.0f, 0.0f };
-    DrawCubeWires(cubePosition, 2.0f, 2.0f, 2.0f, MAROON);
-}
-
 
-// ------------------------------------------------------------
-//  Player input – use get_mut + modified
-// ------------------------------------------------------------
-void player_input_system(flecs::iter& it)
+void reset_system(flecs::iter& it)
 {
-    const flecs::world& world = it.world();
-    if (!world.has<player_controller_t>()) return;
-
-    auto& pc = world.get_mut<player_controller_t>();
-    flecs::entity player = pc.id;
-    if (!player.has<Transform3D>() || !world.has<main_context_t>()) return;
-
-    const auto& ctx = world.get<main_context_t>();
-    const Camera3D& cam = ctx.camera;
-
-    // === 1. Build camera-relative forward/right (XZ plane) ===
-    Vector3 camForward = Vector3Subtract(cam.target, cam.position);
-    camForward.y = 0;
-    camForward = Vector3Normalize(camForward);
-    Vector3 camRight = Vector3CrossProduct(camForward, cam.up);
-    camRight = Vector3Normalize(camRight);
-
-    // === 2. Accumulate movement input ===
-    Vector3 move_dir{0,0,0};
-    const float speed = 5.0f;
-
-    if(IsKeyPressed(KEY_ONE)){
-        pc.id = parent_id;
-        return;
-    }
-
-    if(IsKeyPressed(KEY_TWO)){
-        pc.id = child_id;
-        return;
+    flecs::world world = it.world();
+    if (world.get<input::input_state_t>().action_pressed(ACTION_RESET)) {
+        spawn_boxes(world);
     }
+}
 
+// RLLateLatch: orbit around the target with look_delta, which includes
+// the cursor movement since the input snapshot
+void camera_orbit_system(flecs::iter& it)
+{
+    flecs::world world = it.world();
+    if (!world.get<input::input_state_t>().mouse_down(MOUSE_BUTTON_RIGHT)) return;
+    if (ImGui::GetIO().WantCaptureMouse) return;
+
+    const Vector2 delta = world.get<input_events::input_events_t>().look_delta;
+    Camera3D& camera = world.get_mut<main_context_t>().camera;
+    Vector3 offset = Vector3Subtract(camera.position, camera.target);
+    const float distance = Vector3Length(offset);
+    if (distance <= 0.0f) return;
+
+    float yaw = atan2f(offset.x, offset.z) - 0.005f * delta.x;
+    float pitch = asinf(Clamp(offset.y / distance, -1.0f, 1.0f)) + 0.005f * delta.y;
+    pitch = Clamp(pitch, -1.4f, 1.4f);
+    offset = { distance * cosf(pitch) * sinf(yaw), distance * sinf(pitch), distance * cosf(pitch) * cosf(yaw) };
+    camera.position = Vector3Add(camera.target, offset);
+}
 
-    if (IsKeyDown(KEY_W)) move_dir = Vector3Add(move_dir, camForward);
-    if (IsKeyDown(KEY_S)) move_dir = Vector3Subtract(move_dir, camForward);
-    if (IsKeyDown(KEY_A)) move_dir = Vector3Subtract(move_dir, camRight);
-    if (IsKeyDown(KEY_D)) move_dir = Vector3Add(move_dir, camRight);
-    if (Vector3LengthSqr(move_dir) > 0.0f) move_dir = Vector3Normalize(move_dir);
-
-    float dt = it.delta_time();
-    Vector3 worldDelta = Vector3Scale(move_dir, speed * dt);
-
-    // === 3. Mouse rotation ===
-    Vector2 mouseDelta = GetMouseDelta();
-    bool doYaw   = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
-    bool doPitch = IsMouseButtonDown(MOUSE_RIGHT_BUTTON);
-
-    Transform3D& t = player.get_mut<Transform3D>();
-
-    if (doYaw || doPitch) {
-        Quaternion yawQuat   = QuaternionIdentity();
-        Quaternion pitchQuat = QuaternionIdentity();
+void imgui_render_system(flecs::iter& it)
+{
+    flecs::world world = it.world();
+    const physics::physics_stats_t& stats = world.get<physics::physics_world_t>().stats;
 
-        if (doYaw) {
-            float yaw = -mouseDelta.x * MOUSE_YAW_SENSITIVITY;
-            yawQuat = QuaternionFromAxisAngle({0,1,0}, yaw);
+    if (ImGui::Begin("Physics"))
+    {
+        ImGui::Text("bodies %d  awake %d  slept %d  synced %d  kinematic %d",
+                    stats.bodies, stats.active, stats.slept, stats.synced, stats.kinematic);
+        ImGui::Text("step %.2f ms  sync %.2f ms  wait %.2f ms", stats.step_ms, stats.sync_ms, stats.wait_ms);
+        ImGui::Text("contacts %d  floor impacts %d", stats.contacts, world.get<demo_t>().impacts);
+        ImGui::Text("queries %d  hits %d  %.2f ms", stats.queries, stats.query_hits, stats.query_ms);
+        const physics::physics_config_t& config = physics::config_of(world);
+        ImGui::Text("temp %.2f / %.0f MB  peak %.2f MB  fallbacks %d (%llu total)",
+                    stats.temp_high_water / 1048576.0f, config.temp_allocator_size / 1048576.0f,
+                    stats.temp_peak / 1048576.0f, stats.temp_fallbacks, (unsigned long long)stats.temp_fallbacks_total);
+        const physics::heap_stats_t heap = physics::heap_stats();
+        ImGui::Text("jolt heap %.1f MB  peak %.1f MB  blocks %lld",
+                    heap.bytes / 1048576.0f, heap.peak / 1048576.0f, (long long)heap.blocks);
+        size_t arena_used = 0, arena_capacity = 0, arena_peak = 0;
+        uint32_t arena_allocs = 0;
+        uint64_t arena_allocs_total = 0;
+        for (const auto& arena : world.get<frame_arena::frame_arena_t>().arenas) {
+            if (!arena) continue;
+            arena_used += arena->used();
+            arena_capacity += arena->capacity();
+            arena_peak += arena->high_water();
+            arena_allocs += arena->heap_allocs();
+            arena_allocs_total += arena->total_heap_allocs();
         }
-        if (doPitch) {
-            float pitch = -mouseDelta.y * MOUSE_PITCH_SENSITIVITY;
-            pitchQuat = QuaternionFromAxisAngle({1,0,0}, pitch);
+        ImGui::Text("frame arena %.1f / %.1f KB  peak %.1f KB  heap allocs %u (%llu total)  events %d",
+                    arena_used / 1024.0f, arena_capacity / 1024.0f, arena_peak / 1024.0f,
+                    arena_allocs, (unsigned long long)arena_allocs_total,
+                    world.get<input_events::input_events_t>().event_count);
+        const world_partition::partition_stats_t& ps = world.get<world_partition::partition_state_t>().stats;
+        ImGui::Text("cells %d  prefetched %d  pending %d  resident %.1f KB%s",
+                    ps.loaded, ps.prefetched, ps.pending, ps.resident_bytes / 1024.0f,
+                    ps.over_budget ? "  over budget" : "");
+        const physics::layer_config_t& layers = physics::layers_of(world);
+        for (int32_t i = 0; i < layers.layer_count; i++) {
+            if (stats.layer_bodies[i] == 0) continue;
+            ImGui::Text("  %-12s %d", layers.layer_names[i].c_str(), stats.layer_bodies[i]);
+        }
+        const character::character_stats_t& cs = world.get<character::character_world_t>().stats;
+        ImGui::Text("characters %d  supported %d  cells %d (%.1f m)  update %.2f ms",
+                    cs.characters, cs.supported, cs.cells, cs.cell_size, cs.update_ms);
+        const physics_history::history_stats_t& hs = world.get<physics_history::history_t>().stats();
+        ImGui::Text("history %d ticks  %.1f KB (%.1f KB full)  save %.2f ms  restore %.2f ms",
+                    hs.ticks, hs.bytes / 1024.0f, hs.full_bytes / 1024.0f, hs.save_ms, hs.restore_ms);
+        const shapes::cache_stats_t ss = shapes::shared().stats();
+        ImGui::Text("shapes %d  users %d  %.1f KB (%.1f KB saved)  hits %llu",
+                    ss.shapes, ss.users, ss.bytes / 1024.0f, ss.saved_bytes / 1024.0f, (unsigned long long)ss.hits);
+        ImGui::Checkbox("threaded step", &world.get_mut<physics::physics_world_t>().threaded);
+        ImGui::SameLine();
+        if (ImGui::Button("Report stats")) physics::report_stats(world);
+
+        demo_t& demo = world.get_mut<demo_t>();
+        ImGui::SliderInt("columns", &demo.columns, 1, 64);
+        ImGui::SliderInt("layers", &demo.layers, 1, 32);
+        ImGui::Checkbox("parallel characters", &world.get_mut<character::character_world_t>().parallel);
+        ImGui::SliderInt("crowd", &demo.crowd, 0, 2000);
+        if (ImGui::Button("Spawn crowd")) spawn_crowd(world);
+        ImGui::SameLine();
+        if (ImGui::Button("Respawn (R)")) spawn_boxes(world);
+        ImGui::SameLine();
+        if (ImGui::Button("Rewind 1 s")) {
+            const uint64_t tick = world.get<fixed_step::fixed_time_t>().tick;
+            const physics_history::history_t& h = world.get<physics_history::history_t>();
+            physics_history::restore(world, std::max(h.first_tick(), tick > 60 ? tick - 60 : 0));
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Kick")) {
+            // queued, safe while a threaded step runs
+            for (flecs::entity_t e : demo.boxes) {
+                physics::add_impulse(world.entity(e), { 0.0f, 6.0f, 0.0f });
+            }
         }
-
-        t.rotation = QuaternionMultiply(t.rotation, QuaternionMultiply(pitchQuat, yawQuat));
-        t.isDirty = true;
-    }
-
-    // === 4. Apply movement in local space ===
-    if (Vector3LengthSqr(worldDelta) > 0.0f) {
-        Matrix rotMat = QuaternionToMatrix(t.rotation);
-        Vector3 localDelta = Vector3Transform(worldDelta, rotMat);
-        t.position = Vector3Add(t.position, localDelta);
-        t.isDirty = true;
     }
-
-    player.modified<Transform3D>();
+    ImGui::End();
 }
 
-//-----------------------------------------------
-//
-//-----------------------------------------------
-// setup system functions
-void init_systems(flecs::world& ecs) {
-    TraceLog(LOG_INFO, "init_systems");
-    // Phases
-    ecs.system("begin_drawing_system")
-        .kind(RLBeginDrawing)
-        .run(begin_drawing_system);
-    // background
-    ecs.system("render_2d_background_color_system")
-        .kind(RLStartRender)
-        .run(render_2d_background_color_system);
-    ecs.system("imgui_begin_system")
-        .kind(RLImguiBegin)
-        .run(imgui_begin_system);
-    ecs.system("imgui_render_system")
-        .kind(RLImguiRender)
-        .run(imgui_render_system);
-    ecs.system("imgui_end_system")
-        .kind(RLImguiEnd)
-        .run(imgui_end_system);
-    ecs.system("end_drawing_system")
-        .kind(RLEndDrawing)
-        .run(end_drawing_system);
-    ecs.system("begin_camera_mode_3d_system")
-        .kind(RLBeginModeCamera3D)
-        .run(begin_camera_mode_3d_system);
-    ecs.system("end_camera_mode_3d_system")
-        .kind(RLEndMode3D)
-        .run(end_camera_mode_3d_system);
-    // player
-    ecs.system("player_input_system")
-        .kind(RLUpdate)
-        .run(player_input_system);
-
-    ecs.system<cube_t, const Transform3D>("render_3d_cube_system")
-        .kind(RLRender3D)
-        .each([](const cube_t& c, const Transform3D& tr) {
-            // push matrix, draw, pop
-            rlPushMatrix();
-            rlMultMatrixf(MatrixToFloat(tr.worldMatrix));
-            DrawCubeWires({0,0,0}, c.size.x, c.size.y, c.size.z, c.color);
-            rlPopMatrix();
-        });
-    
-}
-// set up components
-void setup_components(flecs::world& ecs) {
-    // UPDATE RL
-    RLUpdate = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(flecs::OnUpdate);
-    // BeginDrawing
-    RLBeginDrawing = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLUpdate);
-
-    RLStartRender = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLBeginDrawing);
-    // Camera 3D
-    RLBeginModeCamera3D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLStartRender);
-    RLRender3D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLBeginModeCamera3D);
-    RLEndMode3D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLRender3D);
-    // imgui
-    RLImguiBegin = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLEndMode3D);
-    RLImguiRender = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLImguiBegin);
-    RLImguiEnd = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLImguiRender);
-    // render 2d
-    RLRender2D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLImguiEnd);
-    // end render
-    RLEndDrawing = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLRender2D);
-
-    // Register singleton component
-    ecs.component<main_context_t>().add(flecs::Singleton);
-    ecs.component<player_controller_t>().add(flecs::Singleton);
-    // Register component
-    ecs.component<Transform3D>();
-    ecs.component<imgui_test_t>();
-    ecs.component<cube_t>();
-}
 // ----------------------------------------------
 // main
 // ----------------------------------------------
-int main()
+int main(int argc, char** argv)
 {
-    // -------------------------------------------------------
-    // 1. Initialise the window
-    // -------------------------------------------------------
-    const int screenWidth  = 800;
-    const int screenHeight = 450;
-
-    InitWindow(screenWidth, screenHeight, "raylib [C++] Hello World");
-    SetTargetFPS(60);                                               // 60 FPS
+    const int screenWidth  = 1200;
+    const int screenHeight = 800;
 
-    // -----------------------------------------------------------------
-    // 1. Change the global log level (default = LOG_INFO)
-    // -----------------------------------------------------------------
-    SetTraceLogLevel(LOG_ALL);                                      // show everything
+    InitWindow(screenWidth, screenHeight, "flecs + Jolt Physics");
+    SetTargetFPS(60);
 
-    // Define the camera to look into our 3d world
     Camera3D camera = { 0 };
-    camera.position = { 0.0f, 10.0f, 10.0f };                       // Camera position
-    camera.target = { 0.0f, 0.0f, 0.0f };                           // Camera looking at point
-    camera.up = { 0.0f, 1.0f, 0.0f };                               // Camera up vector (rotation towards target)
-    camera.fovy = 45.0f;                                            // Camera field-of-view Y
-    camera.projection = CAMERA_PERSPECTIVE;                         // Camera mode type
+    camera.position = { 30.0f, 22.0f, 30.0f };
+    camera.target = { 0.0f, 2.0f, 0.0f };
+    camera.up = { 0.0f, 1.0f, 0.0f };
+    camera.fovy = 45.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
 
-    // Create the world
-    flecs::world world;
-    // set up
-    setup_components(world);
-    init_systems(world);
-    setup_transform3d(world);
-
-    world.set<main_context_t>({
-        .camera = camera
-    });
+    // flecs task threads and Jolt jobs share one pool
+    jobs::install_flecs_tasks(jobs::shared());
 
-    // world.set(main_context_t{
-    //     .camera = camera
-    // });
-
-    // ---------------------------------------------------
-    // 1. Add the component to an entity
-    // ---------------------------------------------------
-    flecs::entity cube = world.entity()
-        .set<Transform3D>({
-            .position = {0, 0, 0},
-            .rotation = QuaternionFromAxisAngle({0,1,0}, 0), // identity
-            .scale    = {1,1,1}
-        })
-        .set<cube_t>({ .size = {1,1,1}, .color = RED });
-    parent_id = cube;
-    // ---------------------------------------------------
-    // 2. Make a child
-    // ---------------------------------------------------
-    flecs::entity child = world.entity()
-        .child_of(cube)                     // hierarchy!
-        .set<Transform3D>({
-            .position = {2,0,0},
-            .scale    = {0.5f,0.5f,0.5f}
-        })
-        .set<cube_t>({ .size = {1,1,1}, .color = BLUE });;
-    child_id = child;
-    flecs::entity sub_cube = world.entity("ChildCube")
-    .child_of(child)
-    .set<Transform3D>({
-        .position = {2, 2, 0},
-        .scale    = {0.5f, 0.5f, 0.5f}
-    })
-    .set<cube_t>({ .size = {1,1,1}, .color = BLUE });
-
-    // test
-    world.set(player_controller_t{
-        // .id = cube
-        .id = child
-    });
+    flecs::world world;
+    world.set_task_threads(jobs::shared().worker_count());
+    world.import<raylib::module>();
+    world.import<fixed_step::module>();
+    world.import<scene::module>();
+    world.import<input::module>();
+    world.import<input_events::module>();
+    world.import<physics::module>();
+    world.import<character::module>();
+    world.import<physics_history::module>();
+    world.import<world_partition::module>();
+
+    // --layers <file>: object / broadphase layers from a text file
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--layers") != 0) continue;
+        physics::layer_config_t layers;
+        if (physics::load_layers(argv[i + 1], layers)) physics::set_layers(world, layers);
+    }
 
+    world.set<main_context_t>({ .camera = camera });
+    world.component<demo_t>().add(flecs::Singleton);
+    world.add<demo_t>();
+
+    world.get_mut<input::action_map_t>()
+        .bind_action(ACTION_RESET, input::source_t::key, KEY_R);
+
+    world.system<character::CharacterMove, Probe, const Transform3D>("wander_system")
+        .kind<fixed_step::RLFixedPreUpdate>()
+        .run(wander_system);
+    world.system("paddle_system")
+        .kind<fixed_step::RLFixedUpdate>()
+        .run(paddle_system);
+    // both may respawn, scene::spawn needs a non-deferred world
+    world.system("reset_system")
+        .kind<raylib::RLUpdate>()
+        .immediate()
+        .run(reset_system);
+    world.system("camera_orbit_system")
+        .kind<raylib::RLLateLatch>()
+        .run(camera_orbit_system);
+    world.system("imgui_render_system")
+        .kind<raylib::RLImguiRender>()
+        .immediate()
+        .run(imgui_render_system);
 
-    rlImGuiSetup(true); 	// sets up ImGui with ether a dark or light default theme
-    // -------------------------------------------------------
-    // 2. Main game loop
-    // -------------------------------------------------------
-    TraceLog(LOG_INFO,"RAYLIB INIT LOOP...");
-    while (!WindowShouldClose())    // Detect window close button or ESC key
+    world.get_mut<demo_t>().prefab = scene::cube_prefab(world, "Box", { 1, 1, 1 }, ORANGE);
+    world.get_mut<demo_t>().npc_prefab = scene::cube_prefab(world, "Npc", { 0.6f, 1.8f, 0.6f }, DARKBLUE);
+    spawn_floor(world);
+    spawn_boxes(world);
+    spawn_crowd(world);
+
+    const float cell_size = world.get<world_partition::partition_config_t>().cell_size;
+    world.get_mut<world_partition::partition_config_t>().directory = g_cell_directory;
+    bake_field(cell_size);
+    world_partition::partition_hooks_t& hooks = world.get_mut<world_partition::partition_state_t>().hooks;
+    hooks.on_loaded = cell_loaded;
+    hooks.on_unloading = cell_unloading;
+
+    input_events::install(world);
+    rlImGuiSetup(true);
+    while (!WindowShouldClose())
     {
-        world.progress();
+        if (!input::begin_frame(world, GetFrameTime())) break;
+        fixed_step::progress(world, input::frame_dt(world));
     }
+    input::stop(world);
+    input_events::uninstall(world);
 
-    // -------------------------------------------------------
-    // 3. Cleanup
-    // -------------------------------------------------------
-    rlImGuiShutdown();		        // cleans up ImGui
-    CloseWindow();                  // Close window and OpenGL context
+    rlImGuiShutdown();
+    CloseWindow();
     return 0;
-}
\ No newline at end of file
+}
@@ -8,40 +8,42 @@
 #include "imgui.h"
 #include "rlImGui.h"	        // include the API header
 #include "bake_config.h"
+#include "module_raylib.hpp"
+#include "module_fixed_step.hpp"
+#include "module_scene.hpp"
+#include "module_undo.hpp"
+#include "module_input.hpp"
+#include <cstring>
 #include <iostream>
+#include <vector>
 #include <rlgl.h>
 
 
 const float MOUSE_YAW_SENSITIVITY   = 0.003f;   // radians per pixel
 const float MOUSE_PITCH_SENSITIVITY = 0.003f;
 
-// phases
-flecs::entity RLUpdate;
-flecs::entity RLBeginDrawing;
-flecs::entity RLStartRender;
-flecs::entity RLBeginModeCamera3D;
-flecs::entity RLRender3D;
-flecs::entity RLEndMode3D;
-flecs::entity RLImguiBegin;
-flecs::entity RLImguiRender;
-flecs::entity RLImguiEnd;
-flecs::entity RLRender2D;
-flecs::entity RLEndDrawing;
-
 flecs::entity parent_id;
 flecs::entity child_id;
 
 // components
-struct cube_t {
-    Vector3 position;
-    Vector3 size;
-    Color color;
-};
 // struct velocity_t {
 //     Vector3 value{0,0,0};
 // };
-struct main_context_t {
-    Camera3D camera;
+using raylib::main_context_t;
+using transform_3d::Transform3D;
+using scene::cube_t;
+// input actions / axes, bound in setup_input()
+enum player_action_t : int32_t {
+    ACTION_SELECT_PARENT,
+    ACTION_SELECT_CHILD,
+    ACTION_LOOK_YAW,
+    ACTION_LOOK_PITCH,
+};
+enum player_axis_t : int32_t {
+    AXIS_MOVE_FORWARD,
+    AXIS_MOVE_RIGHT,
+    AXIS_LOOK_X,
+    AXIS_LOOK_Y,
 };
 struct player_controller_t {
     flecs::entity id;
@@ -53,111 +55,6 @@ struct imgui_test_t {
     ImVec4 clear_color;
 };
 
-// ---------------------------------------------------------------
-//  Transform3D – hierarchical 3-D transform (position/rot/scale)
-// ---------------------------------------------------------------
-struct Transform3D {
-    Vector3    position{0,0,0};   // local translation
-    Quaternion rotation{0,0,0,1}; // local rotation (identity)
-    Vector3    scale{1,1,1};      // local scale
-    Matrix     localMatrix{};     // cached local matrix
-    Matrix     worldMatrix{};     // cached world matrix
-    bool       isDirty{true};     // true → needs recalculation
-};
-
-// ------------------------------------------------------------
-//  Helpers – world is now const&
-// ------------------------------------------------------------
-static void mark_hierarchy_dirty(flecs::entity e)
-{
-    if (!e.has<Transform3D>()) return;
-
-    Transform3D& t = e.get_mut<Transform3D>();
-    t.isDirty = true;
-    e.modified<Transform3D>();
-
-    e.children([&](flecs::entity child){
-        mark_hierarchy_dirty(child);
-    });
-}
-
-static void update_transform(const flecs::world& world, flecs::entity e, Transform3D& t)
-{
-    // ---- early-out ------------------------------------------------
-    flecs::entity parent = e.parent();
-    bool parentDirty = false;
-    if (parent && parent.has<Transform3D>()) {
-        const Transform3D& pt = parent.get<Transform3D>();
-        parentDirty = pt.isDirty;
-    }
-    if (!t.isDirty && !parentDirty) return;
-
-    // ---- local matrix --------------------------------------------
-    Matrix translation = MatrixTranslate(t.position.x, t.position.y, t.position.z);
-    Matrix rotation    = QuaternionToMatrix(t.rotation);
-    Matrix scaling     = MatrixScale(t.scale.x, t.scale.y, t.scale.z);
-    t.localMatrix = MatrixMultiply(scaling, MatrixMultiply(rotation, translation));
-
-    // ---- world matrix --------------------------------------------
-    if (!parent) {
-        t.worldMatrix = t.localMatrix;
-    } else {
-        const Transform3D& pt = parent.get<Transform3D>();
-        t.worldMatrix = MatrixMultiply(t.localMatrix, pt.worldMatrix);
-    }
-
-    // ---- mark children dirty --------------------------------------
-    e.children([&](flecs::entity child){
-        if (child.has<Transform3D>()) {
-            Transform3D& ct = child.get_mut<Transform3D>();
-            ct.isDirty = true;
-            child.modified<Transform3D>();
-        }
-    });
-
-    t.isDirty = false;
-}
-
-static void update_hierarchy(const flecs::world& world, flecs::entity e)
-{
-    if (!e.has<Transform3D>()) return;
-
-    Transform3D& t = e.get_mut<Transform3D>();
-    update_transform(world, e, t);
-
-    e.children([&](flecs::entity child){
-        update_hierarchy(world, child);
-    });
-}
-
-// ------------------------------------------------------------
-//  System – capture the world correctly
-// ------------------------------------------------------------
-static void Transform3DSystem(flecs::iter& it)
-{
-    // it.world() is an rvalue → store it in a variable first
-    const flecs::world& w = it.world();
-
-    auto q = w.query<Transform3D>();
-    q.each([&w](flecs::entity e, Transform3D&) {
-        update_hierarchy(w, e);
-    });
-}
-
-void setup_transform3d(flecs::world& ecs)
-{
-    // Component
-    ecs.component<Transform3D>();
-
-    // System – give it a nice name and put it in a phase you prefer.
-    // Here we put it in the same RLUpdate phase you already use for
-    // player logic, but you can create a dedicated phase if you want.
-    ecs.system("Transform3DSystem")
-       .kind(RLUpdate)                 // <-- change to your own phase if desired
-       .run(Transform3DSystem);
-}
-
-
 // ---------------------------------------------------------------
 // 
 // ---------------------------------------------------------------
@@ -166,39 +63,6 @@ void setup_transform3d(flecs::world& ecs)
 void Sys(flecs::iter& it) {
     std::cout << "system " << it.system().name() << "\n";
 }
-// BeginDrawing
-void begin_drawing_system(flecs::iter& it) {
-    BeginDrawing();
-}
-// ClearBackground
-void render_2d_background_color_system(flecs::iter& it) {
-    ClearBackground(RAYWHITE);
-}
-// begin mode camera 3d
-void begin_camera_mode_3d_system(flecs::iter& it) {
-    // TraceLog(LOG_INFO,"Begin Camera 3D");
-    flecs::world world = it.world();
-    if (!world.has<main_context_t>()) { //check for single access
-        return; // Singleton destroyed, skip
-    }
-    // TraceLog(LOG_INFO,"Begin Camera 3D and main_context_t");
-    const main_context_t& ctx = world.get<main_context_t>();
-    Camera3D& cam = const_cast<Camera3D&>(ctx.camera); // non-const ref
-    BeginMode3D(cam);
-}
-// end camera mode 3d
-void end_camera_mode_3d_system(flecs::iter& it) {
-    // TraceLog(LOG_INFO,"End Camera 3D");
-    flecs::world world = it.world();
-    if (!world.has<main_context_t>()) { //check for single access
-        return; // Singleton destroyed, skip to prevent crashed.
-    }
-    EndMode3D();
-}
-// rlImGuiBegin
-void imgui_begin_system(flecs::iter& it) {
-    rlImGuiBegin();
-}
 // imgui set up widgets
 void imgui_render_system(flecs::iter& it) {
 
@@ -219,18 +83,32 @@ void imgui_render_system(flecs::iter& it) {
         if (ImGui::Button("Button")){                            // Buttons return true when clicked (most widgets return true when edited/activated)
             TraceLog(LOG_INFO, "Click");
         }
+
+        // undo/redo of the selected transform, a drag is one history entry
+        undo::history_t& history = world.get_mut<undo::history_t>();
+        flecs::entity player = world.has<player_controller_t>() ? world.get<player_controller_t>().id : flecs::entity();
+        if (player.is_valid() && player.has<Transform3D>()) {
+            Vector3 position = player.get<Transform3D>().position;
+            if (ImGui::DragFloat3("position", &position.x, 0.05f)) {
+                history.begin("move", player.id());
+                history.touch(world, player, &Transform3D::position);   // WASD writes the same component
+                Transform3D& t = player.get_mut<Transform3D>();
+                t.position = position;
+                t.isDirty = true;
+                history.commit(world);
+                player.modified<Transform3D>();
+            }
+        }
+        const auto& in = world.get<input::input_state_t>();
+        const bool ctrl = in.key_down(KEY_LEFT_CONTROL) || in.key_down(KEY_RIGHT_CONTROL);
+        if (ImGui::Button("Undo") || (ctrl && in.key_pressed(KEY_Z))) history.undo(world);
+        ImGui::SameLine();
+        if (ImGui::Button("Redo") || (ctrl && in.key_pressed(KEY_Y))) history.redo(world);
+        ImGui::Text("history %zu entries, %zu B", history.size(), history.memory_used());
         // rlImGuiImage(&image);
     }
     ImGui::End();
 }
-// rlImGuiEnd
-void imgui_end_system(flecs::iter& it) {
-    rlImGuiEnd();
-}
-// EndDrawing
-void end_drawing_system(flecs::iter& it) {
-    EndDrawing();
-}
 //-----------------------------------------------
 // player
 //-----------------------------------------------
@@ -241,7 +119,54 @@ void render_3d_cube_system(flecs::iter& it) {
 
 
 // ------------------------------------------------------------
-//  Player input – use get_mut + modified
+//  Player select + mouse look – per-frame input stays in RLUpdate,
+//  a frame without a fixed tick would lose it otherwise
+// ------------------------------------------------------------
+void player_frame_input_system(flecs::iter& it)
+{
+    const flecs::world& world = it.world();
+    if (!world.has<player_controller_t>()) return;
+
+    auto& pc = world.get_mut<player_controller_t>();
+    const auto& in = world.get<input::input_state_t>();
+    if(in.action_pressed(ACTION_SELECT_PARENT)){
+        pc.id = parent_id;
+        return;
+    }
+    if(in.action_pressed(ACTION_SELECT_CHILD)){
+        pc.id = child_id;
+        return;
+    }
+
+    flecs::entity player = pc.id;
+    if (!player.has<Transform3D>()) return;
+
+    // === Mouse rotation ===
+    Vector2 mouseDelta = { in.axis(AXIS_LOOK_X), in.axis(AXIS_LOOK_Y) };
+    bool doYaw   = in.action_down(ACTION_LOOK_YAW);
+    bool doPitch = in.action_down(ACTION_LOOK_PITCH);
+    if (!doYaw && !doPitch) return;
+
+    Transform3D& t = player.get_mut<Transform3D>();
+    Quaternion yawQuat   = QuaternionIdentity();
+    Quaternion pitchQuat = QuaternionIdentity();
+
+    if (doYaw) {
+        float yaw = -mouseDelta.x * MOUSE_YAW_SENSITIVITY;
+        yawQuat = QuaternionFromAxisAngle({0,1,0}, yaw);
+    }
+    if (doPitch) {
+        float pitch = -mouseDelta.y * MOUSE_PITCH_SENSITIVITY;
+        pitchQuat = QuaternionFromAxisAngle({1,0,0}, pitch);
+    }
+
+    t.rotation = QuaternionMultiply(t.rotation, QuaternionMultiply(pitchQuat, yawQuat));
+    t.isDirty = true;
+    player.modified<Transform3D>();
+}
+
+// ------------------------------------------------------------
+//  Player input – movement, runs at the fixed tick rate
 // ------------------------------------------------------------
 void player_input_system(flecs::iter& it)
 {
@@ -266,51 +191,17 @@ void player_input_system(flecs::iter& it)
     Vector3 move_dir{0,0,0};
     const float speed = 5.0f;
 
-    if(IsKeyPressed(KEY_ONE)){
-        pc.id = parent_id;
-        return;
-    }
-
-    if(IsKeyPressed(KEY_TWO)){
-        pc.id = child_id;
-        return;
-    }
+    const auto& in = world.get<input::input_state_t>();
+    move_dir = Vector3Add(Vector3Scale(camForward, in.axis(AXIS_MOVE_FORWARD)),
+                          Vector3Scale(camRight, in.axis(AXIS_MOVE_RIGHT)));
+    if (Vector3LengthSqr(move_dir) > 1.0f) move_dir = Vector3Normalize(move_dir); // keep stick magnitude
 
-
-    if (IsKeyDown(KEY_W)) move_dir = Vector3Add(move_dir, camForward);
-    if (IsKeyDown(KEY_S)) move_dir = Vector3Subtract(move_dir, camForward);
-    if (IsKeyDown(KEY_A)) move_dir = Vector3Subtract(move_dir, camRight);
-    if (IsKeyDown(KEY_D)) move_dir = Vector3Add(move_dir, camRight);
-    if (Vector3LengthSqr(move_dir) > 0.0f) move_dir = Vector3Normalize(move_dir);
-
-    float dt = it.delta_time();
+    float dt = it.delta_time();                 // fixed step
     Vector3 worldDelta = Vector3Scale(move_dir, speed * dt);
 
-    // === 3. Mouse rotation ===
-    Vector2 mouseDelta = GetMouseDelta();
-    bool doYaw   = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
-    bool doPitch = IsMouseButtonDown(MOUSE_RIGHT_BUTTON);
-
     Transform3D& t = player.get_mut<Transform3D>();
 
-    if (doYaw || doPitch) {
-        Quaternion yawQuat   = QuaternionIdentity();
-        Quaternion pitchQuat = QuaternionIdentity();
-
-        if (doYaw) {
-            float yaw = -mouseDelta.x * MOUSE_YAW_SENSITIVITY;
-            yawQuat = QuaternionFromAxisAngle({0,1,0}, yaw);
-        }
-        if (doPitch) {
-            float pitch = -mouseDelta.y * MOUSE_PITCH_SENSITIVITY;
-            pitchQuat = QuaternionFromAxisAngle({1,0,0}, pitch);
-        }
-
-        t.rotation = QuaternionMultiply(t.rotation, QuaternionMultiply(pitchQuat, yawQuat));
-        t.isDirty = true;
-    }
-
-    // === 4. Apply movement in local space ===
+    // === 3. Apply movement in local space ===
     if (Vector3LengthSqr(worldDelta) > 0.0f) {
         Matrix rotMat = QuaternionToMatrix(t.rotation);
         Vector3 localDelta = Vector3Transform(worldDelta, rotMat);
@@ -327,103 +218,48 @@ void player_input_system(flecs::iter& it)
 // setup system functions
 void init_systems(flecs::world& ecs) {
     TraceLog(LOG_INFO, "init_systems");
-    // Phases
-    ecs.system("begin_drawing_system")
-        .kind(RLBeginDrawing)
-        .run(begin_drawing_system);
-    // background
-    ecs.system("render_2d_background_color_system")
-        .kind(RLStartRender)
-        .run(render_2d_background_color_system);
-    ecs.system("imgui_begin_system")
-        .kind(RLImguiBegin)
-        .run(imgui_begin_system);
     ecs.system("imgui_render_system")
-        .kind(RLImguiRender)
+        .kind<raylib::RLImguiRender>()
         .run(imgui_render_system);
-    ecs.system("imgui_end_system")
-        .kind(RLImguiEnd)
-        .run(imgui_end_system);
-    ecs.system("end_drawing_system")
-        .kind(RLEndDrawing)
-        .run(end_drawing_system);
-    ecs.system("begin_camera_mode_3d_system")
-        .kind(RLBeginModeCamera3D)
-        .run(begin_camera_mode_3d_system);
-    ecs.system("end_camera_mode_3d_system")
-        .kind(RLEndMode3D)
-        .run(end_camera_mode_3d_system);
     // player
+    ecs.system("player_frame_input_system")
+        .kind<raylib::RLUpdate>()
+        .run(player_frame_input_system);
     ecs.system("player_input_system")
-        .kind(RLUpdate)
+        .kind<fixed_step::RLFixedUpdate>()
         .run(player_input_system);
 
-    ecs.system<cube_t, const Transform3D>("render_3d_cube_system")
-        .kind(RLRender3D)
-        .each([](const cube_t& c, const Transform3D& tr) {
-            // push matrix, draw, pop
-            rlPushMatrix();
-            rlMultMatrixf(MatrixToFloat(tr.worldMatrix));
-            DrawCubeWires({0,0,0}, c.size.x, c.size.y, c.size.z, c.color);
-            rlPopMatrix();
-        });
-    
+}
+// keyboard/mouse plus gamepad 0 bindings
+void setup_input(flecs::world& ecs) {
+    using input::source_t;
+    ecs.get_mut<input::action_map_t>()
+        .bind_action(ACTION_SELECT_PARENT, source_t::key, KEY_ONE)
+        .bind_action(ACTION_SELECT_CHILD, source_t::key, KEY_TWO)
+        .bind_action(ACTION_SELECT_PARENT, source_t::gamepad_button, GAMEPAD_BUTTON_LEFT_TRIGGER_1)
+        .bind_action(ACTION_SELECT_CHILD, source_t::gamepad_button, GAMEPAD_BUTTON_RIGHT_TRIGGER_1)
+        .bind_action(ACTION_LOOK_YAW, source_t::mouse_button, MOUSE_LEFT_BUTTON)
+        .bind_action(ACTION_LOOK_PITCH, source_t::mouse_button, MOUSE_RIGHT_BUTTON)
+        .bind_axis(AXIS_MOVE_FORWARD, source_t::key, KEY_W, 1.0f)
+        .bind_axis(AXIS_MOVE_FORWARD, source_t::key, KEY_S, -1.0f)
+        .bind_axis(AXIS_MOVE_FORWARD, source_t::gamepad_axis, GAMEPAD_AXIS_LEFT_Y, -1.0f)
+        .bind_axis(AXIS_MOVE_RIGHT, source_t::key, KEY_D, 1.0f)
+        .bind_axis(AXIS_MOVE_RIGHT, source_t::key, KEY_A, -1.0f)
+        .bind_axis(AXIS_MOVE_RIGHT, source_t::gamepad_axis, GAMEPAD_AXIS_LEFT_X, 1.0f)
+        .bind_axis(AXIS_LOOK_X, source_t::mouse_delta_x, 0)
+        .bind_axis(AXIS_LOOK_Y, source_t::mouse_delta_y, 0);
 }
 // set up components
 void setup_components(flecs::world& ecs) {
-    // UPDATE RL
-    RLUpdate = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(flecs::OnUpdate);
-    // BeginDrawing
-    RLBeginDrawing = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLUpdate);
-
-    RLStartRender = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLBeginDrawing);
-    // Camera 3D
-    RLBeginModeCamera3D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLStartRender);
-    RLRender3D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLBeginModeCamera3D);
-    RLEndMode3D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLRender3D);
-    // imgui
-    RLImguiBegin = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLEndMode3D);
-    RLImguiRender = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLImguiBegin);
-    RLImguiEnd = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLImguiRender);
-    // render 2d
-    RLRender2D = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLImguiEnd);
-    // end render
-    RLEndDrawing = ecs.entity()
-        .add(flecs::Phase)
-        .depends_on(RLRender2D);
-
     // Register singleton component
-    ecs.component<main_context_t>().add(flecs::Singleton);
     ecs.component<player_controller_t>().add(flecs::Singleton);
     // Register component
-    ecs.component<Transform3D>();
     ecs.component<imgui_test_t>();
-    ecs.component<cube_t>();
 }
 // ----------------------------------------------
 // main
 // ----------------------------------------------
-int main()
+int main(int argc, char** argv)
 {
     // -------------------------------------------------------
     // 1. Initialise the window
@@ -449,10 +285,15 @@ int main()
 
     // Create the world
     flecs::world world;
+    world.import<raylib::module>();
+    world.import<fixed_step::module>();
+    world.import<scene::module>();
+    world.import<undo::module>();
+    world.import<input::module>();
     // set up
     setup_components(world);
+    setup_input(world);
     init_systems(world);
-    setup_transform3d(world);
 
     world.set<main_context_t>({
         .camera = camera
@@ -492,6 +333,26 @@ int main()
     })
     .set<cube_t>({ .size = {1,1,1}, .color = BLUE });
 
+    // ---------------------------------------------------
+    // 3. Bulk spawn a grid of tiles sharing one prefab
+    // ---------------------------------------------------
+    flecs::entity tile = scene::cube_prefab(world, "FloorTile", {0.5f,0.1f,0.5f}, LIGHTGRAY);
+
+    const int grid = 32;
+    std::vector<Transform3D> grid_transforms(grid * grid);
+    std::vector<flecs::entity_t> grid_prefabs(grid * grid, tile);
+    for (int z = 0; z < grid; z++) {
+        for (int x = 0; x < grid; x++) {
+            grid_transforms[z * grid + x].position = { (x - grid / 2) * 1.0f, -1.0f, (z - grid / 2) * 1.0f };
+        }
+    }
+    scene::spawn(world, {
+        .count = grid * grid,
+        .transforms = grid_transforms.data(),
+        .prefabs = grid_prefabs.data()
+    });
+    scene::log_memory_report(world);
+
     // test
     world.set(player_controller_t{
         // .id = cube
@@ -504,10 +365,22 @@ int main()
     // 2. Main game loop
     // -------------------------------------------------------
     TraceLog(LOG_INFO,"RAYLIB INIT LOOP...");
+    // --record <file> / --replay <file>
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--record") == 0) input::start_recording(world, argv[i + 1]);
+        if (std::strcmp(argv[i], "--replay") == 0) input::start_replay(world, argv[i + 1]);
+    }
+    // rlImGui reads raylib, not the recording: keep the live mouse and
+    // keyboard out of the UI while replaying
+    if (world.get<input::input_state_t>().mode == input::mode_t::replay) {
+        ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_NoMouse | ImGuiConfigFlags_NoKeyboard;
+    }
     while (!WindowShouldClose())    // Detect window close button or ESC key
     {
-        world.progress();
+        if (!input::begin_frame(world, GetFrameTime())) break; // replay finished
+        fixed_step::progress(world, input::frame_dt(world));
     }
+    input::stop(world);
 
     // -------------------------------------------------------
     // 3. Cleanup
@@ -0,0 +1,281 @@
+// main_input_replay_test.cpp
+// Input record / replay determinism, no window.
+// A small game (a player moved by axes in the fixed step, a marker spawned
+// per jump press in RLUpdate) is driven by generated input_frame_t through
+// input::feed_frame while input::start_recording writes the session. A
+// fresh world then replays the file through begin_frame, and both worlds
+// are reduced to one hash:
+//
+//   - the replay runs exactly as many frames as were recorded
+//   - the state hash (transforms, fixed tick, input frame, actions) matches
+//   - start_recording after live frames starts again at frame 0
+//
+//   input_replay_test [--frames 600] [--file input_replay_test.rlin]
+//
+// Exit code 0 when every check passes, registered with ctest.
+
+#include "bake_config.h"
+#include "module_raylib.hpp"
+#include "module_fixed_step.hpp"
+#include "module_transform_3d_hierarchy.hpp"
+#include "module_input.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using transform_3d::Transform3D;
+
+enum test_action_t : int32_t {
+    ACTION_JUMP,
+};
+
+enum test_axis_t : int32_t {
+    AXIS_MOVE_X,
+    AXIS_MOVE_Z,
+    AXIS_TURN,
+};
+
+struct test_config_t {
+    int32_t     frames = 600;
+    const char* path = "input_replay_test.rlin";
+};
+
+// component
+struct Player {
+    float yaw = 0.0f;
+    float vertical_speed = 0.0f;
+};
+
+// component, one per jump press
+struct Marker {};
+
+static int32_t g_failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) g_failures++;
+}
+
+// ---------------------------------------------------------------
+//  game
+// ---------------------------------------------------------------
+// fixed step: move on the axes, turn with the mouse, fall back down
+static void player_system(flecs::iter& it)
+{
+    flecs::world world = it.world();
+    const input::input_state_t& in = world.get<input::input_state_t>();
+    const float dt = it.delta_time();
+    while (it.next()) {
+        auto player = it.field<Player>(0);
+        auto t = it.field<Transform3D>(1);
+        for (auto i : it) {
+            player[i].yaw += 0.003f * in.axis(AXIS_TURN);
+            const float c = cosf(player[i].yaw);
+            const float s = sinf(player[i].yaw);
+            const float x = in.axis(AXIS_MOVE_X);
+            const float z = in.axis(AXIS_MOVE_Z);
+            t[i].position.x += 4.0f * dt * (c * x - s * z);
+            t[i].position.z += 4.0f * dt * (s * x + c * z);
+
+            if (in.action_down(ACTION_JUMP) && t[i].position.y <= 0.0f) player[i].vertical_speed = 5.0f;
+            player[i].vertical_speed -= 9.81f * dt;
+            t[i].position.y = fmaxf(0.0f, t[i].position.y + player[i].vertical_speed * dt);
+            t[i].isDirty = true;
+        }
+    }
+}
+
+// per frame: a marker where the player was on each jump press
+static void marker_system(flecs::iter& it)
+{
+    flecs::world world = it.world();
+    if (!world.get<input::input_state_t>().action_pressed(ACTION_JUMP)) return;
+    flecs::entity player = world.lookup("Player");
+    if (!player) return;
+    world.entity().add<Marker>().set<Transform3D>({ .position = player.get<Transform3D>().position });
+}
+
+static void setup(flecs::world& world)
+{
+    world.import<fixed_step::module>();
+    world.import<transform_3d::module>();
+    world.import<input::module>();
+
+    world.get_mut<input::action_map_t>()
+        .bind_action(ACTION_JUMP, input::source_t::key, KEY_SPACE)
+        .bind_action(ACTION_JUMP, input::source_t::gamepad_button, GAMEPAD_BUTTON_RIGHT_FACE_DOWN)
+        .bind_axis(AXIS_MOVE_X, input::source_t::key, KEY_D, 1.0f)
+        .bind_axis(AXIS_MOVE_X, input::source_t::key, KEY_A, -1.0f)
+        .bind_axis(AXIS_MOVE_Z, input::source_t::key, KEY_S, 1.0f)
+        .bind_axis(AXIS_MOVE_Z, input::source_t::key, KEY_W, -1.0f)
+        .bind_axis(AXIS_MOVE_Z, input::source_t::gamepad_axis, GAMEPAD_AXIS_LEFT_Y, 1.0f)
+        .bind_axis(AXIS_TURN, input::source_t::mouse_delta_x, 0, 1.0f);
+
+    world.component<Player>();
+    world.component<Marker>();
+    world.entity("Player").add<Player>().set<Transform3D>({});
+
+    world.system<Player, Transform3D>("player_system")
+        .kind<fixed_step::RLFixedUpdate>()
+        .run(player_system);
+    world.system("marker_system")
+        .kind<raylib::RLUpdate>()
+        .run(marker_system);
+}
+
+// ---------------------------------------------------------------
+//  input
+// ---------------------------------------------------------------
+// xorshift, the same frames for the same seed and index
+static uint32_t next_random(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static void set_key(input::input_frame_t& f, int32_t key)
+{
+    f.keys[key >> 6] |= 1ull << (key & 63);
+}
+
+// Held keys change every few frames, jump is tapped, frame times jitter
+// between 144 and 30 fps so some frames run no fixed tick and some several.
+static input::input_frame_t make_frame(int32_t i, uint32_t& rng)
+{
+    input::input_frame_t f;
+    std::memset(&f, 0, sizeof(f));
+
+    const int32_t phase = (i / 45) % 4;
+    const int32_t keys[4] = { KEY_W, KEY_D, KEY_S, KEY_A };
+    set_key(f, keys[phase]);
+    if ((next_random(rng) & 15) == 0) set_key(f, KEY_SPACE);
+    if ((i / 120) % 2) f.gamepad_buttons |= 1u << GAMEPAD_BUTTON_RIGHT_FACE_DOWN;
+    f.gamepad_axes[GAMEPAD_AXIS_LEFT_Y] = ((i / 200) % 2) ? 0.6f : 0.1f;   // second one under the deadzone
+
+    f.mouse_delta = { (float)((int32_t)(next_random(rng) % 41) - 20), 0.0f };
+    f.mouse_position = { 600.0f + 0.5f * (float)i, 400.0f };
+    if (f.mouse_delta.x > 0.0f) f.mouse_buttons |= 1u << MOUSE_BUTTON_RIGHT;
+    f.wheel = (i % 50 == 0) ? 1.0f : 0.0f;
+    f.dt = 1.0f / (30.0f + (float)(next_random(rng) % 115));
+    return f;
+}
+
+// ---------------------------------------------------------------
+//  state hash
+// ---------------------------------------------------------------
+static uint64_t hash_bytes(uint64_t h, const void* data, size_t size)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+}
+
+// FNV-1a over everything the session can change, in creation order
+static uint64_t state_hash(flecs::world& world)
+{
+    uint64_t h = 14695981039346656037ull;
+    world.query_builder<const Transform3D>().build().each([&](flecs::entity, const Transform3D& t) {
+        h = hash_bytes(h, &t.position, sizeof(t.position));
+    });
+    const Player& player = world.lookup("Player").get<Player>();
+    h = hash_bytes(h, &player, sizeof(player));
+
+    const input::input_state_t& in = world.get<input::input_state_t>();
+    h = hash_bytes(h, &in.frame, sizeof(in.frame));
+    h = hash_bytes(h, &in.actions, sizeof(in.actions));
+    h = hash_bytes(h, in.axes, sizeof(in.axes));
+
+    const fixed_step::fixed_time_t& ft = world.get<fixed_step::fixed_time_t>();
+    h = hash_bytes(h, &ft.tick, sizeof(ft.tick));
+    h = hash_bytes(h, &ft.accumulator, sizeof(ft.accumulator));
+    return h;
+}
+
+// ---------------------------------------------------------------
+//  run
+// ---------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    test_config_t cfg;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            cfg.frames = atoi(argv[++i]) > 0 ? atoi(argv[i]) : cfg.frames;
+        } else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+            cfg.path = argv[++i];
+        } else {
+            printf("usage: %s [--frames N] [--file path]\n", argv[0]);
+            return 1;
+        }
+    }
+    SetTraceLogLevel(LOG_WARNING);
+    printf("input replay test: %d frames\n", cfg.frames);
+
+    // ---- record ------------------------------------------------------
+    uint64_t recorded_hash = 0;
+    uint64_t recorded_frames = 0;
+    int32_t recorded_markers = 0;
+    {
+        flecs::world world;
+        setup(world);
+        const bool ok = input::start_recording(world, cfg.path);
+        check(ok, "start_recording");
+
+        uint32_t rng = 0x2545F491u;
+        for (int32_t i = 0; i < cfg.frames; i++) {
+            input::feed_frame(world, make_frame(i, rng));
+            input::begin_frame(world, 0.0f);
+            fixed_step::progress(world, input::frame_dt(world));
+        }
+        recorded_frames = world.get<input::input_state_t>().frame;
+        recorded_markers = world.count<Marker>();
+        input::stop(world);
+        recorded_hash = state_hash(world);
+    }
+
+    // ---- replay ------------------------------------------------------
+    uint64_t replayed_hash = 0;
+    uint64_t replayed_frames = 0;
+    {
+        flecs::world world;
+        setup(world);
+        const bool ok = input::start_replay(world, cfg.path);
+        check(ok, "start_replay");
+
+        while (ok && input::begin_frame(world, 0.0f)) {
+            fixed_step::progress(world, input::frame_dt(world));
+            replayed_frames = world.get<input::input_state_t>().frame;
+        }
+        replayed_hash = state_hash(world);
+    }
+    remove(cfg.path);
+
+    check(recorded_frames == (uint64_t)cfg.frames && replayed_frames == recorded_frames, "replayed frame count");
+    check(recorded_markers > 0, "session pressed jump");
+    check(replayed_hash == recorded_hash, "state hash after replay");
+    printf("  recorded %016llx  replayed %016llx\n",
+           (unsigned long long)recorded_hash, (unsigned long long)replayed_hash);
+
+    // ---- recording after live frames ---------------------------------
+    {
+        flecs::world world;
+        setup(world);
+        uint32_t rng = 7u;
+        for (int32_t i = 0; i < 10; i++) {
+            input::feed_frame(world, make_frame(i, rng));
+            input::begin_frame(world, 0.0f);
+        }
+        const bool ok = input::start_recording(world, cfg.path);
+        const input::input_state_t& in = world.get<input::input_state_t>();
+        check(ok && in.frame == 0 && in.actions == 0, "start_recording resets the frame counter");
+        input::stop(world);
+        remove(cfg.path);
+    }
+
+    printf("\n%s\n", g_failures ? "FAILED" : "passed");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,301 @@
+// main_physics_bench.cpp
+// Headless physics stress benchmark, no window.
+// Drops 1k / 10k / 100k bodies (half boxes, half spheres) onto a height
+// field terrain through physics::module and runs the fixed pipeline only.
+// Per run it prints step time (avg / p95 / max), awake bodies, islands of
+// the last step, the temp allocator high-water mark and fallbacks and the
+// Jolt heap, so the capacity of a level can be sized before content ships.
+//
+//   physics_bench [--steps 600] [--temp 256] [counts...]
+//
+// --temp is the temp allocator size in MB; it is set generously on purpose,
+// the peak column is what a level actually needs. Run with a smaller one
+// to see the fallback count (steps served from the heap).
+//
+// Nothing here opens a window: raylib is not linked (see the log section),
+// transform_3d only brings the raylib phases, not the render systems.
+
+#include "bake_config.h"
+#include "module_fixed_step.hpp"
+#include "module_physics.hpp"
+#include "job_system.hpp"
+#include "shape_cache.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Collision/Shape/HeightFieldShape.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+JPH_SUPPRESS_WARNINGS
+
+using transform_3d::Transform3D;
+
+// ---------------------------------------------------------------
+//  log
+// ---------------------------------------------------------------
+// raylib is not linked into the bench. The physics sources only use it to
+// log, so its two logging functions (declared extern "C" by raylib.h) are
+// defined here and print to stdout the way raylib does.
+static int g_log_level = LOG_INFO;
+
+void SetTraceLogLevel(int level)
+{
+    g_log_level = level;
+}
+
+void TraceLog(int level, const char* text, ...)
+{
+    if (level < g_log_level) return;
+    static const char* names[] = { "ALL", "TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "FATAL", "NONE" };
+    printf("%s: ", level >= LOG_ALL && level <= LOG_NONE ? names[level] : "LOG");
+    va_list args;
+    va_start(args, text);
+    vprintf(text, args);
+    va_end(args);
+    printf("\n");
+    if (level == LOG_FATAL) exit(EXIT_FAILURE);
+}
+
+struct bench_config_t {
+    int32_t steps = 600;                    // ticks per run, 10 s at 60 Hz
+    size_t  temp_size = 256u << 20;
+    std::vector<int32_t> counts;
+};
+
+struct bench_result_t {
+    int32_t count = 0;
+    int32_t added = 0;
+    double  add_ms = 0.0;
+    double  step_avg = 0.0;
+    double  step_p95 = 0.0;
+    double  step_max = 0.0;
+    double  sync_avg = 0.0;
+    int32_t awake = 0;
+    int32_t islands = 0;
+    int32_t largest_island = 0;
+    int32_t contacts = 0;
+    size_t  temp_peak = 0;
+    uint64_t temp_fallbacks = 0;           // allocations that did not fit the temp allocator
+    size_t  heap_bytes = 0;                // Jolt heap with every body in the world
+};
+
+// ---------------------------------------------------------------
+//  scene
+// ---------------------------------------------------------------
+static constexpr int32_t TERRAIN_SAMPLES = 256;
+static constexpr float   BODY_SPACING = 1.2f;
+static constexpr int32_t BODIES_PER_LAYER = 10000;
+
+static void spawn_terrain(flecs::world& world, float size)
+{
+    const float cell = size / (float)(TERRAIN_SAMPLES - 1);
+    std::vector<float> heights(TERRAIN_SAMPLES * TERRAIN_SAMPLES);
+    for (int32_t z = 0; z < TERRAIN_SAMPLES; z++) {
+        for (int32_t x = 0; x < TERRAIN_SAMPLES; x++) {
+            heights[z * TERRAIN_SAMPLES + x] = 1.5f * sinf(x * 0.11f) * cosf(z * 0.07f);
+        }
+    }
+
+    JPH::HeightFieldShapeSettings shape(heights.data(), JPH::Vec3(-0.5f * size, 0.0f, -0.5f * size),
+                                        JPH::Vec3(cell, 1.0f, cell), TERRAIN_SAMPLES);
+    JPH::BodyCreationSettings settings(shape.Create().Get(), JPH::RVec3::sZero(), JPH::Quat::sIdentity(),
+                                       JPH::EMotionType::Static, physics::layers::NON_MOVING);
+
+    flecs::entity terrain = world.entity("Terrain").set<Transform3D>({});
+    physics::add_body(world, terrain, settings, JPH::EActivation::DontActivate);
+}
+
+// `count` bodies in layers of up to BODIES_PER_LAYER, boxes and spheres
+// alternating, added as two add_bodies batches
+static int32_t spawn_bodies(flecs::world& world, int32_t count, float& footprint)
+{
+    const int32_t per_layer = std::min(count, BODIES_PER_LAYER);
+    const int32_t side = (int32_t)ceilf(sqrtf((float)per_layer));
+    footprint = side * BODY_SPACING;
+
+    std::vector<flecs::entity_t> boxes, spheres;
+    boxes.reserve(count / 2 + 1);
+    spheres.reserve(count / 2 + 1);
+    for (int32_t i = 0; i < count; i++) {
+        const int32_t layer = i / per_layer;
+        const int32_t j = i % per_layer;
+        const float x = ((j % side) - 0.5f * (side - 1)) * BODY_SPACING;
+        const float z = ((j / side) - 0.5f * (side - 1)) * BODY_SPACING;
+        const float y = 4.0f + layer * BODY_SPACING;
+
+        flecs::entity e = world.entity().set<Transform3D>({ .position = { x, y, z } });
+        (i & 1 ? spheres : boxes).push_back(e);
+    }
+
+    JPH::BodyCreationSettings box(shapes::shared().box({ 0.4f, 0.4f, 0.4f }), JPH::RVec3::sZero(),
+                                  JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, physics::layers::MOVING);
+    JPH::BodyCreationSettings sphere(shapes::shared().sphere(0.4f), JPH::RVec3::sZero(),
+                                     JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, physics::layers::MOVING);
+
+    int32_t added = 0;
+    added += physics::add_bodies(world, { .count = (int32_t)boxes.size(), .entities = boxes.data(),
+                                          .settings = &box, .shared_settings = true });
+    added += physics::add_bodies(world, { .count = (int32_t)spheres.size(), .entities = spheres.data(),
+                                          .settings = &sphere, .shared_settings = true });
+    return added;
+}
+
+// ---------------------------------------------------------------
+//  islands
+// ---------------------------------------------------------------
+// Jolt does not expose its islands, so they are rebuilt from the touching
+// pairs of the last step (persisted contacts on for that step): awake
+// dynamic bodies joined by a contact. The bench has no constraints, so
+// this is what the solver saw.
+static int32_t find_root(std::vector<int32_t>& parent, int32_t i)
+{
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+static void count_islands(flecs::world& world, bench_result_t& r)
+{
+    JPH::PhysicsSystem& system = physics::system(world);
+    JPH::BodyIDVector awake;
+    system.GetActiveBodies(JPH::EBodyType::RigidBody, awake);
+
+    std::vector<int32_t> parent(physics::config_of(world).max_bodies, -1);
+    for (const JPH::BodyID& id : awake) parent[id.GetIndex()] = (int32_t)id.GetIndex();
+
+    for (const physics::contact_t& c : physics::contacts(world)) {
+        if (c.state == physics::contact_state_t::removed) continue;
+        const int32_t a = (int32_t)c.body_a.GetIndex();
+        const int32_t b = (int32_t)c.body_b.GetIndex();
+        if (parent[a] < 0 || parent[b] < 0) continue;   // static or asleep
+        const int32_t ra = find_root(parent, a);
+        const int32_t rb = find_root(parent, b);
+        if (ra != rb) parent[ra] = rb;
+    }
+
+    std::vector<int32_t> size(parent.size(), 0);
+    for (const JPH::BodyID& id : awake) size[find_root(parent, (int32_t)id.GetIndex())]++;
+    r.islands = 0;
+    r.largest_island = 0;
+    for (int32_t n : size) {
+        if (n == 0) continue;
+        r.islands++;
+        r.largest_island = std::max(r.largest_island, n);
+    }
+}
+
+// ---------------------------------------------------------------
+//  run
+// ---------------------------------------------------------------
+static bench_result_t run(const bench_config_t& cfg, int32_t count)
+{
+    bench_result_t r;
+    r.count = count;
+
+    flecs::world world;
+    world.set_task_threads(jobs::shared().worker_count());
+    world.import<fixed_step::module>();
+    world.import<physics::module>();
+
+    physics::physics_config_t pc;
+    pc.max_bodies = (uint32_t)count + 16;
+    pc.max_body_pairs = (uint32_t)count * 8 + 1024;          // piles touch several neighbours
+    pc.max_contact_constraints = (uint32_t)count * 2 + 1024;
+    pc.temp_allocator_size = cfg.temp_size;
+    if (!physics::configure(world, pc)) return r;
+
+    const auto start = std::chrono::steady_clock::now();
+    float footprint = 0.0f;
+    r.added = spawn_bodies(world, count, footprint);
+    spawn_terrain(world, footprint + 32.0f);
+    const auto end = std::chrono::steady_clock::now();
+    r.add_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    const flecs::entity_t pipeline = world.get<fixed_step::fixed_pipeline_t>().pipeline;
+    const float dt = world.get<fixed_step::fixed_time_t>().fixed_dt();
+
+    std::vector<double> step_ms;
+    step_ms.reserve(cfg.steps);
+    double sync_ms = 0.0;
+    for (int32_t i = 0; i < cfg.steps; i++) {
+        // the last step also records resting pairs, for the islands
+        world.get_mut<physics::physics_world_t>().persisted_contacts = i == cfg.steps - 1;
+        world.run_pipeline(pipeline, dt);
+        world.get_mut<fixed_step::fixed_time_t>().tick++;
+
+        const physics::physics_stats_t& st = world.get<physics::physics_world_t>().stats;
+        step_ms.push_back(st.step_ms);
+        sync_ms += st.sync_ms;
+    }
+
+    const physics::physics_stats_t& st = world.get<physics::physics_world_t>().stats;
+    if (!step_ms.empty()) {
+        r.step_avg = std::accumulate(step_ms.begin(), step_ms.end(), 0.0) / step_ms.size();
+        r.sync_avg = sync_ms / step_ms.size();
+        std::sort(step_ms.begin(), step_ms.end());
+        r.step_p95 = step_ms[std::min(step_ms.size() - 1, step_ms.size() * 95 / 100)];
+        r.step_max = step_ms.back();
+    }
+    r.awake = st.active;
+    r.contacts = st.contacts;
+    r.temp_peak = st.temp_peak;
+    r.temp_fallbacks = st.temp_fallbacks_total;
+    r.heap_bytes = physics::heap_stats().bytes;
+    count_islands(world, r);
+
+    SetTraceLogLevel(LOG_INFO);   // report_stats logs at info
+    physics::report_stats(world);
+    SetTraceLogLevel(LOG_WARNING);
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    bench_config_t cfg;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            cfg.steps = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--temp") == 0 && i + 1 < argc) {
+            cfg.temp_size = (size_t)std::max(1, atoi(argv[++i])) << 20;
+        } else if (atoi(argv[i]) > 0) {
+            cfg.counts.push_back(atoi(argv[i]));
+        } else {
+            printf("usage: %s [--steps N] [--temp MB] [counts...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (cfg.counts.empty()) cfg.counts = { 1000, 10000, 100000 };
+
+    SetTraceLogLevel(LOG_WARNING);
+    jobs::install_flecs_tasks(jobs::shared());
+    printf("physics bench: %d steps, %d workers, temp %zu MB\n", cfg.steps,
+           jobs::shared().worker_count(), cfg.temp_size >> 20);
+
+    std::vector<bench_result_t> results;
+    for (int32_t count : cfg.counts) {
+        results.push_back(run(cfg, count));
+        const bench_result_t& r = results.back();
+        printf("  %d bodies: added %d in %.1f ms, step avg %.2f ms\n", r.count, r.added, r.add_ms, r.step_avg);
+    }
+
+    printf("\n%8s %9s %9s %9s %9s %8s %8s %8s %9s %10s %9s %10s\n", "bodies", "step avg", "step p95", "step max",
+           "sync avg", "awake", "islands", "largest", "contacts", "temp peak", "fallback", "jolt heap");
+    for (const bench_result_t& r : results) {
+        printf("%8d %9.2f %9.2f %9.2f %9.2f %8d %8d %8d %9d %7.1f MB %9llu %7.1f MB\n", r.count, r.step_avg,
+               r.step_p95, r.step_max, r.sync_avg, r.awake, r.islands, r.largest_island, r.contacts,
+               r.temp_peak / 1048576.0, (unsigned long long)r.temp_fallbacks, r.heap_bytes / 1048576.0);
+    }
+    printf("jolt heap peak %.1f MB over all runs\n", physics::heap_stats().peak / 1048576.0);
+    return 0;
+}
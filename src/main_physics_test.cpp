@@ -0,0 +1,242 @@
+// main_physics_test.cpp
+// physics::module checks, no window.
+//
+//   - add_bodies with a BoxShapeSettings template, shared and copied per
+//     body: every body is created, all of them share one built shape
+//   - add_bodies with a template whose shape fails: nothing added, no crash
+//   - add_body / add_bodies on entities that already have a body replace
+//     it, the body count stays the same
+//   - importing builds no PhysicsSystem, configure() builds the only one;
+//     configure() is refused while a Character exists
+//
+//   physics_test [--bodies 4000]
+//
+// Exit code 0 when every check passes, registered with ctest. Like
+// physics_bench it links no raylib (see the log section).
+
+#include "bake_config.h"
+#include "module_fixed_step.hpp"
+#include "module_physics.hpp"
+#include "module_character.hpp"
+#include "job_system.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+JPH_SUPPRESS_WARNINGS
+
+using transform_3d::Transform3D;
+
+// ---------------------------------------------------------------
+//  log
+// ---------------------------------------------------------------
+// raylib is not linked, the physics sources only use it to log
+static int g_log_level = LOG_INFO;
+
+void SetTraceLogLevel(int level)
+{
+    g_log_level = level;
+}
+
+void TraceLog(int level, const char* text, ...)
+{
+    if (level < g_log_level) return;
+    static const char* names[] = { "ALL", "TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "FATAL", "NONE" };
+    printf("%s: ", level >= LOG_ALL && level <= LOG_NONE ? names[level] : "LOG");
+    va_list args;
+    va_start(args, text);
+    vprintf(text, args);
+    va_end(args);
+    printf("\n");
+    if (level == LOG_FATAL) exit(EXIT_FAILURE);
+}
+
+struct test_config_t {
+    int32_t bodies = 4000;
+};
+
+static int32_t g_failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) g_failures++;
+}
+
+// ---------------------------------------------------------------
+//  world
+// ---------------------------------------------------------------
+static bool setup(flecs::world& world, int32_t bodies)
+{
+    world.set_task_threads(jobs::shared().worker_count());
+    world.import<fixed_step::module>();
+    world.import<physics::module>();
+
+    physics::physics_config_t pc;
+    pc.max_bodies = (uint32_t)bodies * 2 + 16;
+    pc.max_body_pairs = (uint32_t)bodies * 8 + 1024;
+    pc.max_contact_constraints = (uint32_t)bodies * 2 + 1024;
+    return physics::configure(world, pc);
+}
+
+static std::vector<flecs::entity_t> make_entities(flecs::world& world, int32_t count, float y)
+{
+    std::vector<flecs::entity_t> out((size_t)count);
+    for (int32_t i = 0; i < count; i++) {
+        out[i] = world.entity().set<Transform3D>({ .position = { (float)(i % 64) * 1.5f, y, (float)(i / 64) * 1.5f } });
+    }
+    return out;
+}
+
+static void run_ticks(flecs::world& world, int32_t ticks)
+{
+    const flecs::entity_t pipeline = world.get<fixed_step::fixed_pipeline_t>().pipeline;
+    const float dt = world.get<fixed_step::fixed_time_t>().fixed_dt();
+    for (int32_t i = 0; i < ticks; i++) {
+        world.run_pipeline(pipeline, dt);
+        world.get_mut<fixed_step::fixed_time_t>().tick++;
+    }
+}
+
+// every entity has RigidBody and all bodies use the same shape instance
+static bool one_shape(flecs::world& world, const std::vector<flecs::entity_t>& entities)
+{
+    const JPH::Shape* first = nullptr;
+    for (flecs::entity_t e : entities) {
+        const physics::RigidBody* rb = world.entity(e).try_get<physics::RigidBody>();
+        if (!rb) return false;
+        JPH::RefConst<JPH::Shape> shape = physics::body_interface(world).GetShape(rb->id);
+        if (!first) first = shape.GetPtr();
+        if (shape.GetPtr() != first) return false;
+    }
+    return first != nullptr;
+}
+
+// ---------------------------------------------------------------
+//  checks
+// ---------------------------------------------------------------
+// The settings hold a ShapeSettings, not a shape. Without the conversion on
+// the calling thread the workers race on its cached result.
+static void check_shape_settings_template(int32_t count)
+{
+    flecs::world world;
+    check(setup(world, count), "configure");
+
+    JPH::Ref<JPH::BoxShapeSettings> box = new JPH::BoxShapeSettings(JPH::Vec3(0.5f, 0.5f, 0.5f));
+    JPH::BodyCreationSettings tmpl(box, JPH::RVec3::sZero(), JPH::Quat::sIdentity(),
+                                   JPH::EMotionType::Dynamic, physics::layers::MOVING);
+
+    const std::vector<flecs::entity_t> shared = make_entities(world, count, 4.0f);
+    const int32_t shared_added = physics::add_bodies(world, {
+        .count = count, .entities = shared.data(), .settings = &tmpl, .shared_settings = true });
+    check(shared_added == count && one_shape(world, shared), "ShapeSettings template, shared");
+
+    const std::vector<flecs::entity_t> copied = make_entities(world, count, 8.0f);
+    const std::vector<JPH::BodyCreationSettings> copies((size_t)count, tmpl);
+    const int32_t copied_added = physics::add_bodies(world, {
+        .count = count, .entities = copied.data(), .settings = copies.data() });
+    check(copied_added == count && one_shape(world, copied), "ShapeSettings template, copied per body");
+    check(tmpl.GetShapeSettings() == box.GetPtr(), "caller's settings left untouched");
+
+    run_ticks(world, 30);
+    check(world.get<physics::physics_world_t>().stats.bodies == 2 * count, "bodies after 30 ticks");
+}
+
+// convex radius larger than the half extent: Create() fails
+static void check_failed_shape()
+{
+    flecs::world world;
+    check(setup(world, 16), "configure");
+
+    JPH::Ref<JPH::BoxShapeSettings> box = new JPH::BoxShapeSettings(JPH::Vec3(0.1f, 0.1f, 0.1f), 0.5f);
+    JPH::BodyCreationSettings tmpl(box, JPH::RVec3::sZero(), JPH::Quat::sIdentity(),
+                                   JPH::EMotionType::Dynamic, physics::layers::MOVING);
+    const std::vector<flecs::entity_t> entities = make_entities(world, 16, 4.0f);
+    const int32_t added = physics::add_bodies(world, {
+        .count = 16, .entities = entities.data(), .settings = &tmpl, .shared_settings = true });
+    check(added == 0 && !world.entity(entities[0]).has<physics::RigidBody>(), "failing ShapeSettings adds nothing");
+}
+
+static void check_replaced_bodies()
+{
+    flecs::world world;
+    check(setup(world, 64), "configure");
+    JPH::PhysicsSystem& system = physics::system(world);
+
+    JPH::Ref<JPH::BoxShapeSettings> box = new JPH::BoxShapeSettings(JPH::Vec3(0.5f, 0.5f, 0.5f));
+    JPH::BodyCreationSettings settings(box, JPH::RVec3::sZero(), JPH::Quat::sIdentity(),
+                                       JPH::EMotionType::Dynamic, physics::layers::MOVING);
+
+    flecs::entity e = world.entity().set<Transform3D>({ .position = { 0, 4, 0 } });
+    physics::add_body(world, e, settings);
+    const JPH::BodyID second = physics::add_body(world, e, settings);
+    check(system.GetNumBodies() == 1 && e.get<physics::RigidBody>().id == second, "add_body twice keeps one body");
+
+    const std::vector<flecs::entity_t> entities = make_entities(world, 32, 8.0f);
+    const physics::add_bodies_desc_t desc = {
+        .count = 32, .entities = entities.data(), .settings = &settings, .shared_settings = true };
+    physics::add_bodies(world, desc);
+    physics::add_bodies(world, desc);
+    check(system.GetNumBodies() == 33, "add_bodies twice keeps one body each");
+
+    run_ticks(world, 10);
+    check(world.get<physics::physics_world_t>().stats.bodies == 33, "bodies after 10 ticks");
+}
+
+static void check_configure()
+{
+    flecs::world world;
+    world.import<fixed_step::module>();
+    world.import<character::module>();
+    check(!world.get<physics::physics_world_t>().ctx, "import builds no context");
+    check(physics::config_of(world).max_bodies > 0 && !world.get<physics::physics_world_t>().ctx,
+          "config_of builds no context");
+
+    physics::physics_config_t pc;
+    pc.max_bodies = 128;
+    check(physics::configure(world, pc) && physics::system(world).GetMaxBodies() == 128, "configure builds it");
+
+    flecs::entity npc = world.entity().set<Transform3D>({ .position = { 0, 1, 0 } });
+    JPH::Ref<JPH::CharacterVirtualSettings> settings = character::capsule_settings(1.8f, 0.3f);
+    character::add_character(world, npc, *settings);
+    pc.max_bodies = 256;
+    check(!physics::configure(world, pc), "configure refused with a Character");
+
+    character::remove_character(npc);
+    check(physics::configure(world, pc) && physics::system(world).GetMaxBodies() == 256,
+          "configure after the Character is gone");
+}
+
+// ---------------------------------------------------------------
+//  run
+// ---------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    test_config_t cfg;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bodies") == 0 && i + 1 < argc) {
+            cfg.bodies = atoi(argv[++i]) > 0 ? atoi(argv[i]) : cfg.bodies;
+        } else {
+            printf("usage: %s [--bodies N]\n", argv[0]);
+            return 1;
+        }
+    }
+    SetTraceLogLevel(LOG_ERROR);   // the failure cases log warnings on purpose
+    jobs::install_flecs_tasks(jobs::shared());
+    printf("physics test: %d bodies, %d workers\n", cfg.bodies, jobs::shared().worker_count());
+
+    check_shape_settings_template(cfg.bodies);
+    check_failed_shape();
+    check_replaced_bodies();
+    check_configure();
+
+    printf("\n%s\n", g_failures ? "FAILED" : "passed");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,371 @@
+// main_scene_test.cpp
+// Scene snapshot round trip and timing, no window.
+// Builds a hierarchy (roots, children, grandchildren) where entities are
+// IsA instances of two cube prefabs, own a cube, or both, saves it with
+// scene::save_snapshot and loads it back three ways:
+//
+//   - load_snapshot (memory mapped file), with the saved -> loaded id map
+//   - load_snapshot_memory from a buffer at an odd address
+//   - load_snapshot_memory with a broken LEVL chunk, which must fail and
+//     create nothing
+//   - read_snapshot_header with a bad magic or an impossible entity count
+//
+// Every loaded entity is compared with its source (transform, parent,
+// prefab cube, owned cube). The same world then goes through
+// world.to_json() / from_json() for comparison. Last, --spawn entities
+// with Transform3D + cube_t are created with scene::spawn and one at a
+// time with chained set() calls, both timed (the 200k level target).
+//
+//   scene_test [--roots 2000] [--spawn 200000] [--file scene_test.rlsc]
+//
+// Exit code 0 when every check passes, registered with ctest.
+
+#include "bake_config.h"
+#include "module_scene.hpp"
+#include "scene_snapshot.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using scene::cube_t;
+using transform_3d::Transform3D;
+
+struct test_config_t {
+    int32_t     roots = 2000;                    // 13 entities per root
+    int32_t     spawn = 200000;                  // flat Transform3D + cube_t entities
+    const char* path = "scene_test.rlsc";
+};
+
+static int32_t g_failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) g_failures++;
+}
+
+static double ms_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ---------------------------------------------------------------
+//  world
+// ---------------------------------------------------------------
+// reflection, so to_json / from_json carry the same data the snapshot does
+static void register_reflection(flecs::world& world)
+{
+    world.component<Vector3>()
+        .member("x", &Vector3::x)
+        .member("y", &Vector3::y)
+        .member("z", &Vector3::z);
+    world.component<Quaternion>()
+        .member("x", &Quaternion::x)
+        .member("y", &Quaternion::y)
+        .member("z", &Quaternion::z)
+        .member("w", &Quaternion::w);
+    world.component<Color>()
+        .member("r", &Color::r)
+        .member("g", &Color::g)
+        .member("b", &Color::b)
+        .member("a", &Color::a);
+    world.component<Transform3D>()
+        .member("position", &Transform3D::position)
+        .member("rotation", &Transform3D::rotation)
+        .member("scale", &Transform3D::scale);
+    world.component<cube_t>()
+        .member("size", &cube_t::size)
+        .member("color", &cube_t::color);
+}
+
+static void setup(flecs::world& world)
+{
+    world.import<scene::module>();
+    register_reflection(world);
+}
+
+// Entities are keyed by position.x, which is unique, so a loaded entity can
+// be matched with its source without the saved ids.
+static void build(flecs::world& world, int32_t roots)
+{
+    flecs::entity crate = scene::cube_prefab(world, "Crate", { 1.0f, 1.0f, 1.0f }, BROWN);
+    flecs::entity pillar = scene::cube_prefab(world, "Pillar", { 0.5f, 3.0f, 0.5f }, GRAY);
+
+    int32_t key = 0;
+    auto make = [&](flecs::entity parent, int32_t depth) {
+        const int32_t i = key++;
+        Transform3D t;
+        t.position = { (float)i, (float)depth, -0.5f * (float)i };
+        t.rotation = QuaternionFromAxisAngle({ 0.0f, 1.0f, 0.0f }, 0.01f * (float)i);
+        t.scale = { 1.0f, 1.0f + 0.25f * (float)(i % 4), 1.0f };
+
+        flecs::entity e = world.entity().set<Transform3D>(t);
+        if (parent) e.child_of(parent);
+        switch (i % 4) {
+        case 0: e.is_a(crate); break;
+        case 1: e.set<cube_t>({ { 0.2f, 0.2f, 0.2f }, Color{ (unsigned char)i, 80, 160, 255 } }); break;
+        case 2: e.is_a(pillar).set<cube_t>({ { 0.5f, 1.0f, 0.5f }, RED }); break;
+        default: break;                             // transform only
+        }
+        return e;
+    };
+
+    for (int32_t r = 0; r < roots; r++) {
+        flecs::entity root = make(flecs::entity(), 0);
+        for (int32_t c = 0; c < 3; c++) {
+            flecs::entity child = make(root, 1);
+            for (int32_t g = 0; g < 3; g++) make(child, 2);
+        }
+    }
+}
+
+// ---------------------------------------------------------------
+//  compare
+// ---------------------------------------------------------------
+static int32_t key_of(flecs::entity e)
+{
+    const Transform3D* t = e.try_get<Transform3D>();
+    return t ? (int32_t)t->position.x : -1;
+}
+
+static std::unordered_map<int32_t, flecs::entity> index(flecs::world& world)
+{
+    std::unordered_map<int32_t, flecs::entity> out;
+    world.query<const Transform3D>().each([&](flecs::entity e, const Transform3D&) {
+        out[key_of(e)] = e;
+    });
+    return out;
+}
+
+static bool same_cube(const cube_t* a, const cube_t* b)
+{
+    if (!a || !b) return a == b;
+    return memcmp(a, b, sizeof(cube_t)) == 0;
+}
+
+static bool same_entity(flecs::entity a, flecs::entity b)
+{
+    const Transform3D& ta = a.get<Transform3D>();
+    const Transform3D& tb = b.get<Transform3D>();
+    if (memcmp(&ta.position, &tb.position, sizeof(Vector3)) != 0) return false;
+    if (memcmp(&ta.rotation, &tb.rotation, sizeof(Quaternion)) != 0) return false;
+    if (memcmp(&ta.scale, &tb.scale, sizeof(Vector3)) != 0) return false;
+
+    const flecs::entity pa = a.parent();
+    const flecs::entity pb = b.parent();
+    if ((pa ? key_of(pa) : -1) != (pb ? key_of(pb) : -1)) return false;
+
+    const flecs::entity fa = a.target(flecs::IsA);
+    const flecs::entity fb = b.target(flecs::IsA);
+    if ((bool)fa != (bool)fb) return false;
+    if (fa && !same_cube(fa.try_get<cube_t>(), fb.try_get<cube_t>())) return false;
+
+    if (a.owns<cube_t>() != b.owns<cube_t>()) return false;
+    return same_cube(a.try_get<cube_t>(), b.try_get<cube_t>());   // owned or inherited
+}
+
+static bool same_scene(flecs::world& src, flecs::world& dst)
+{
+    std::unordered_map<int32_t, flecs::entity> a = index(src);
+    std::unordered_map<int32_t, flecs::entity> b = index(dst);
+    if (a.size() != b.size()) return false;
+    for (const auto& [key, e] : a) {
+        auto it = b.find(key);
+        if (it == b.end() || !same_entity(e, it->second)) return false;
+    }
+    return true;
+}
+
+// every saved entity and prefab id maps to the loaded entity it became
+static bool same_remap(flecs::world& src, flecs::world& dst, const scene::snapshot_remap_t& remap)
+{
+    size_t prefabs = 0;
+    for (const auto& [key, e] : index(src)) {
+        auto it = remap.find(e.id());
+        if (it == remap.end() || key_of(dst.entity(it->second)) != key) return false;
+        const flecs::entity prefab = e.target(flecs::IsA);
+        if (!prefab) continue;
+        auto pt = remap.find(prefab.id());
+        if (pt == remap.end() || dst.entity(it->second).target(flecs::IsA).id() != pt->second) return false;
+    }
+    for (const char* name : { "Crate", "Pillar" }) prefabs += remap.count(src.lookup(name).id());
+    return prefabs == 2 && remap.size() == index(src).size() + prefabs;
+}
+
+// ---------------------------------------------------------------
+//  file helpers
+// ---------------------------------------------------------------
+static std::vector<unsigned char> read_file(const char* path)
+{
+    std::vector<unsigned char> data;
+    FILE* f = fopen(path, "rb");
+    if (!f) return data;
+    fseek(f, 0, SEEK_END);
+    data.resize((size_t)ftell(f));
+    fseek(f, 0, SEEK_SET);
+    if (fread(data.data(), 1, data.size(), f) != data.size()) data.clear();
+    fclose(f);
+    return data;
+}
+
+// levels start at 1 instead of 0, so entity 0 is never covered
+static bool break_levels(std::vector<unsigned char>& data)
+{
+    scene::snapshot_header_t header;
+    memcpy(&header, data.data(), sizeof(header));
+    for (uint32_t i = 0; i < header.chunk_count; i++) {
+        scene::snapshot_chunk_t c;
+        memcpy(&c, data.data() + sizeof(header) + i * sizeof(c), sizeof(c));
+        if (c.tag != scene::snapshot_tag('L', 'E', 'V', 'L') || c.count == 0) continue;
+        scene::snapshot_level_t level;
+        memcpy(&level, data.data() + c.offset, sizeof(level));
+        level.first++;
+        memcpy(data.data() + c.offset, &level, sizeof(level));
+        return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------
+//  run
+// ---------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    test_config_t cfg;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--roots") == 0 && i + 1 < argc) {
+            cfg.roots = atoi(argv[++i]) > 0 ? atoi(argv[i]) : cfg.roots;
+        } else if (strcmp(argv[i], "--spawn") == 0 && i + 1 < argc) {
+            cfg.spawn = atoi(argv[++i]) > 0 ? atoi(argv[i]) : cfg.spawn;
+        } else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+            cfg.path = argv[++i];
+        } else {
+            printf("usage: %s [--roots N] [--spawn N] [--file path]\n", argv[0]);
+            return 1;
+        }
+    }
+    SetTraceLogLevel(LOG_WARNING);
+
+    flecs::world src;
+    setup(src);
+    build(src, cfg.roots);
+    const int32_t count = (int32_t)index(src).size();
+    printf("scene test: %d entities (%d roots)\n", count, cfg.roots);
+
+    // ---- snapshot ----------------------------------------------------
+    auto start = std::chrono::steady_clock::now();
+    const bool saved = scene::save_snapshot(src, cfg.path);
+    const double save_ms = ms_since(start);
+    check(saved, "save_snapshot");
+
+    double load_ms = 0.0;
+    {
+        flecs::world dst;
+        setup(dst);
+        std::vector<flecs::entity_t> loaded;
+        scene::snapshot_remap_t remap;
+        start = std::chrono::steady_clock::now();
+        const bool ok = scene::load_snapshot(dst, cfg.path, &loaded, 0, &remap);
+        load_ms = ms_since(start);
+        check(ok && (int32_t)loaded.size() == count, "load_snapshot");
+        check(ok && same_scene(src, dst), "mapped file round trip");
+        check(ok && same_remap(src, dst, remap), "saved ids remapped");
+    }
+
+    std::vector<unsigned char> file = read_file(cfg.path);
+    {
+        // one byte in, so no column is aligned for its type
+        std::vector<unsigned char> buffer(file.size() + 1);
+        memcpy(buffer.data() + 1, file.data(), file.size());
+
+        flecs::world dst;
+        setup(dst);
+        const bool ok = scene::load_snapshot_memory(dst, buffer.data() + 1, file.size());
+        check(ok && same_scene(src, dst), "misaligned buffer round trip");
+    }
+    {
+        std::vector<unsigned char> broken = file;
+        flecs::world dst;
+        setup(dst);
+        const bool ok = break_levels(broken) && !scene::load_snapshot_memory(dst, broken.data(), broken.size());
+        check(ok && dst.count<Transform3D>() == 0, "broken LEVL rejected, nothing created");
+    }
+    {
+        scene::snapshot_header_t header;
+        std::vector<unsigned char> broken = file;
+        broken[0] = 'X';
+        const bool bad_magic = !scene::read_snapshot_header(broken.data(), broken.size(), header);
+        broken = file;
+        const uint32_t huge = 0xFFFFFFFFu;
+        memcpy(broken.data() + offsetof(scene::snapshot_header_t, entity_count), &huge, sizeof(huge));
+        const bool bad_count = !scene::read_snapshot_header(broken.data(), broken.size(), header);
+        check(bad_magic && bad_count && scene::read_snapshot_header(file.data(), file.size(), header),
+              "header checks (magic, entity count)");
+    }
+    remove(cfg.path);
+
+    // ---- flecs json --------------------------------------------------
+    start = std::chrono::steady_clock::now();
+    const flecs::string json = src.to_json();
+    const double to_json_ms = ms_since(start);
+
+    double from_json_ms = 0.0;
+    {
+        flecs::world dst;
+        setup(dst);
+        start = std::chrono::steady_clock::now();
+        const bool ok = dst.from_json(json.c_str()) != nullptr;
+        from_json_ms = ms_since(start);
+        if (!ok) printf("  from_json failed, its time is up to the error\n");
+    }
+
+    // ---- bulk spawn -------------------------------------------------
+    std::vector<Transform3D> transforms((size_t)cfg.spawn);
+    std::vector<cube_t> cubes((size_t)cfg.spawn);
+    for (int32_t i = 0; i < cfg.spawn; i++) {
+        transforms[i].position = { (float)(i % 500), 0.0f, (float)(i / 500) };
+        cubes[i] = { { 1.0f, 1.0f, 1.0f }, Color{ (unsigned char)i, 120, 200, 255 } };
+    }
+
+    double spawn_ms = 0.0;
+    {
+        flecs::world dst;
+        setup(dst);
+        start = std::chrono::steady_clock::now();
+        const std::vector<flecs::entity_t> ids = scene::spawn(dst, {
+            .count = cfg.spawn,
+            .transforms = transforms.data(),
+            .cubes = cubes.data()
+        });
+        spawn_ms = ms_since(start);
+        check((int32_t)ids.size() == cfg.spawn && dst.count<cube_t>() == cfg.spawn, "scene::spawn count");
+    }
+
+    double chained_ms = 0.0;
+    {
+        flecs::world dst;
+        setup(dst);
+        start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < cfg.spawn; i++) {
+            dst.entity().set<Transform3D>(transforms[i]).set<cube_t>(cubes[i]);
+        }
+        chained_ms = ms_since(start);
+    }
+
+    printf("\n%10s %10s %10s %12s\n", "format", "save ms", "load ms", "bytes");
+    printf("%10s %10.2f %10.2f %12zu\n", "snapshot", save_ms, load_ms, file.size());
+    printf("%10s %10.2f %10.2f %12zu\n", "json", to_json_ms, from_json_ms, json.size());
+
+    printf("\n%10s %10s %12s\n", "create", "ms", "entities");
+    printf("%10s %10.2f %12d\n", "spawn", spawn_ms, cfg.spawn);
+    printf("%10s %10.2f %12d\n", "chained", chained_ms, cfg.spawn);
+
+    printf("\n%s\n", g_failures ? "FAILED" : "passed");
+    return g_failures ? 1 : 0;
+}
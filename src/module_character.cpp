@@ -0,0 +1,407 @@
+#include "module_character.hpp"
+#include "module_fixed_step.hpp"
+#include "job_system.hpp"
+#include "shape_cache.hpp"
+
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Geometry/RayAABox.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Collision/CollideShape.h>
+#include <Jolt/Physics/Collision/CollisionDispatch.h>
+#include <Jolt/Physics/Collision/ShapeCast.h>
+#include <Jolt/Physics/Collision/Shape/CapsuleShape.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+JPH_SUPPRESS_WARNINGS
+
+namespace character {
+
+    static constexpr size_t TEMP_ALLOCATOR_SIZE = 2u << 20;   // per thread
+
+    // ------------------------------------------------------------
+    //  grid
+    // ------------------------------------------------------------
+    struct item_t {
+        JPH::CharacterVirtual* character;
+        flecs::entity_t        entity;
+        JPH::Vec3              desired;
+        bool                   jump;
+        uint64_t               key;      // cell
+        uint8_t                color;    // (x & 1) | (z & 1) << 1
+    };
+
+    struct cell_t {
+        int32_t  x, z;
+        uint32_t begin, end;             // into grid_t::items
+    };
+
+    struct grid_t {
+        float cell_size = 1.0f;
+        std::vector<item_t> items;       // sorted by colour, then cell
+        std::vector<cell_t> cells;       // same order
+        uint32_t color_begin[5] = {};    // cells of colour c: [color_begin[c], color_begin[c + 1])
+        std::unordered_map<uint64_t, uint32_t> lookup;   // cell key -> index in cells
+
+        static uint64_t key(int32_t x, int32_t z) {
+            return ((uint64_t)(uint32_t)x << 32) | (uint32_t)z;
+        }
+
+        int32_t coord(float v) const {
+            return (int32_t)std::floor(v / cell_size);
+        }
+
+        void build(float dt, float margin);
+    };
+
+    // Two characters can touch when their start positions are closer than
+    // 2 * (reach + margin) plus what both can move in the tick, twice over
+    // for the 3x3 lookup from the start cell. Cells that wide keep every
+    // contact inside the 3x3 block, and same coloured cells out of it.
+    void grid_t::build(float dt, float margin) {
+        float reach = 0.0f;
+        float move = 0.0f;
+        for (const item_t& it : items) {
+            const JPH::AABox b = it.character->GetShape()->GetLocalBounds();
+            const float x = std::max(std::abs(b.mMin.GetX()), std::abs(b.mMax.GetX()));
+            const float z = std::max(std::abs(b.mMin.GetZ()), std::abs(b.mMax.GetZ()));
+            reach = std::max(reach, std::sqrt(x * x + z * z) + it.character->GetCharacterPadding());
+
+            const JPH::Vec3 v = it.character->GetLinearVelocity();
+            const JPH::Vec3 g = it.character->GetGroundVelocity();
+            const float speed = std::sqrt(v.GetX() * v.GetX() + v.GetZ() * v.GetZ())
+                              + std::sqrt(g.GetX() * g.GetX() + g.GetZ() * g.GetZ())
+                              + it.desired.Length();
+            move = std::max(move, speed * dt);
+        }
+        cell_size = std::max(0.01f, 2.0f * (reach + margin) + 4.0f * move);
+
+        for (item_t& it : items) {
+            const JPH::RVec3 p = it.character->GetPosition();
+            const int32_t x = coord((float)p.GetX());
+            const int32_t z = coord((float)p.GetZ());
+            it.key = key(x, z);
+            it.color = (uint8_t)((x & 1) | ((z & 1) << 1));
+        }
+        std::sort(items.begin(), items.end(), [](const item_t& a, const item_t& b) {
+            return a.color != b.color ? a.color < b.color : a.key < b.key;
+        });
+
+        cells.clear();
+        lookup.clear();
+        uint32_t i = 0;
+        for (uint8_t c = 0; c < 4; c++) {
+            color_begin[c] = (uint32_t)cells.size();
+            while (i < items.size() && items[i].color == c) {
+                const uint32_t begin = i;
+                const uint64_t k = items[i].key;
+                while (i < items.size() && items[i].key == k) i++;
+                cells.push_back({ (int32_t)(uint32_t)(k >> 32), (int32_t)(uint32_t)k, begin, i });
+                lookup.emplace(k, (uint32_t)cells.size() - 1);
+            }
+        }
+        color_begin[4] = (uint32_t)cells.size();
+    }
+
+    // ------------------------------------------------------------
+    //  character vs character
+    // ------------------------------------------------------------
+    // CharacterVsCharacterCollisionSimple, but over the 3x3 cells around the
+    // cell being updated. One per worker; x / z are set per cell.
+    class grid_collision_t final : public JPH::CharacterVsCharacterCollision {
+    public:
+        explicit grid_collision_t(const grid_t& grid) : grid_(grid) {}
+
+        void CollideCharacter(const JPH::CharacterVirtual* character, JPH::RMat44Arg com_transform,
+                              const JPH::CollideShapeSettings& collide_settings, JPH::RVec3Arg base_offset,
+                              JPH::CollideShapeCollector& collector) const override
+        {
+            const JPH::Mat44 transform1 = com_transform.PostTranslated(-base_offset).ToMat44();
+            const JPH::Shape* shape = character->GetShape();
+            const JPH::AABox bounds = shape->GetWorldSpaceBounds(transform1, JPH::Vec3::sOne());
+            JPH::CollideShapeSettings settings = collide_settings;
+
+            for_each_near([&](const JPH::CharacterVirtual* other) {
+                if (other == character || collector.ShouldEarlyOut()) return;
+
+                // padding of the other character, to hit its outer shell
+                const JPH::Mat44 transform2 = other->GetCenterOfMassTransform().PostTranslated(-base_offset).ToMat44();
+                settings.mMaxSeparationDistance = collide_settings.mMaxSeparationDistance + other->GetCharacterPadding();
+                JPH::AABox bounds2 = other->GetShape()->GetWorldSpaceBounds(transform2, JPH::Vec3::sOne());
+                bounds2.ExpandBy(JPH::Vec3::sReplicate(settings.mMaxSeparationDistance));
+                if (!bounds.Overlaps(bounds2)) return;
+
+                collector.SetUserData(reinterpret_cast<JPH::uint64>(other));
+                JPH::CollisionDispatch::sCollideShapeVsShape(shape, other->GetShape(), JPH::Vec3::sOne(), JPH::Vec3::sOne(),
+                                                             transform1, transform2, JPH::SubShapeIDCreator(),
+                                                             JPH::SubShapeIDCreator(), settings, collector);
+            });
+            collector.SetUserData(0);
+        }
+
+        void CastCharacter(const JPH::CharacterVirtual* character, JPH::RMat44Arg com_transform,
+                           JPH::Vec3Arg direction, const JPH::ShapeCastSettings& cast_settings,
+                           JPH::RVec3Arg base_offset, JPH::CastShapeCollector& collector) const override
+        {
+            const JPH::Mat44 transform1 = com_transform.PostTranslated(-base_offset).ToMat44();
+            const JPH::ShapeCast shape_cast(character->GetShape(), JPH::Vec3::sOne(), transform1, direction);
+            const JPH::Vec3 origin = shape_cast.mShapeWorldBounds.GetCenter();
+            const JPH::Vec3 extents = shape_cast.mShapeWorldBounds.GetExtent();
+
+            for_each_near([&](const JPH::CharacterVirtual* other) {
+                if (other == character || collector.ShouldEarlyOut()) return;
+
+                const JPH::Mat44 transform2 = other->GetCenterOfMassTransform().PostTranslated(-base_offset).ToMat44();
+                JPH::AABox bounds2 = other->GetShape()->GetWorldSpaceBounds(transform2, JPH::Vec3::sOne());
+                bounds2.ExpandBy(extents);
+                if (!JPH::RayAABoxHits(origin, direction, bounds2.mMin, bounds2.mMax)) return;
+
+                collector.SetUserData(reinterpret_cast<JPH::uint64>(other));
+                JPH::CollisionDispatch::sCastShapeVsShapeWorldSpace(shape_cast, cast_settings, other->GetShape(),
+                                                                    JPH::Vec3::sOne(), {}, transform2,
+                                                                    JPH::SubShapeIDCreator(), JPH::SubShapeIDCreator(),
+                                                                    collector);
+            });
+            collector.SetUserData(0);
+        }
+
+        int32_t x = 0;
+        int32_t z = 0;
+
+    private:
+        template <typename F>
+        void for_each_near(F&& fn) const {
+            for (int32_t dz = -1; dz <= 1; dz++) {
+                for (int32_t dx = -1; dx <= 1; dx++) {
+                    const auto found = grid_.lookup.find(grid_t::key(x + dx, z + dz));
+                    if (found == grid_.lookup.end()) continue;
+                    const cell_t& cell = grid_.cells[found->second];
+                    for (uint32_t i = cell.begin; i < cell.end; i++) fn(grid_.items[i].character);
+                }
+            }
+        }
+
+        const grid_t& grid_;
+    };
+
+    // ------------------------------------------------------------
+    //  context
+    // ------------------------------------------------------------
+    struct context_t {
+        explicit context_t(int32_t workers) {
+            for (int32_t i = 0; i <= workers; i++) {
+                temp.push_back(std::make_unique<JPH::TempAllocatorImplWithMallocFallback>(TEMP_ALLOCATOR_SIZE));
+                collision.push_back(std::make_unique<grid_collision_t>(grid));
+            }
+        }
+
+        grid_t grid;
+
+        // one per worker, the last one for the calling thread
+        std::vector<std::unique_ptr<JPH::TempAllocatorImplWithMallocFallback>> temp;   // heap past 2 MB
+        std::vector<std::unique_ptr<grid_collision_t>>                         collision;
+
+        JPH::CharacterVirtual::ExtendedUpdateSettings update_settings;
+    };
+
+    character_world_t::character_world_t()
+        : ctx(std::make_unique<context_t>(jobs::shared().worker_count()))
+    {
+    }
+
+    character_world_t::~character_world_t() = default;
+    character_world_t::character_world_t(character_world_t&&) noexcept = default;
+    character_world_t& character_world_t::operator=(character_world_t&&) noexcept = default;
+
+    // ------------------------------------------------------------
+    //  characters
+    // ------------------------------------------------------------
+    JPH::Ref<JPH::CharacterVirtualSettings> capsule_settings(float height, float radius) {
+        JPH::Ref<JPH::CharacterVirtualSettings> settings = new JPH::CharacterVirtualSettings();
+        settings->mShape = shapes::shared().capsule(0.5f * height, radius);   // one shape per size
+        settings->mMaxSlopeAngle = JPH::DegreesToRadians(45.0f);
+        // contacts below the centre of the lower hemisphere can support
+        settings->mSupportingVolume = JPH::Plane(JPH::Vec3::sAxisY(), 0.5f * height);
+        settings->mMass = 70.0f;
+        return settings;
+    }
+
+    bool add_character(flecs::world& world, flecs::entity e, const JPH::CharacterVirtualSettings& settings) {
+        if (settings.mShape == nullptr) {
+            TraceLog(LOG_WARNING, "CHARACTER: settings without a shape, no character for entity %llu",
+                     (unsigned long long)e.id());
+            return false;
+        }
+
+        JPH::RVec3 position = JPH::RVec3::sZero();
+        JPH::Quat rotation = JPH::Quat::sIdentity();
+        if (const Transform3D* t = e.try_get<Transform3D>()) {
+            position = JPH::RVec3(t->position.x, t->position.y, t->position.z);
+            rotation = JPH::Quat(t->rotation.x, t->rotation.y, t->rotation.z, t->rotation.w).Normalized();
+        }
+
+        JPH::Ref<JPH::CharacterVirtual> character = new JPH::CharacterVirtual(
+            &settings, position, rotation, (JPH::uint64)e.id(), &physics::system(world));
+        e.set<Character>({ character });
+        if (!e.has<CharacterMove>()) e.set<CharacterMove>({});
+        return true;
+    }
+
+    void remove_character(flecs::entity e) {
+        e.remove<Character>();
+    }
+
+    // ------------------------------------------------------------
+    //  update
+    // ------------------------------------------------------------
+    struct pass_t {
+        context_t*                        ctx;
+        uint32_t                          first_cell;
+        float                             dt;
+        float                             jump_speed;
+        JPH::Vec3                         gravity;
+        const JPH::BroadPhaseLayerFilter* broadphase_filter;
+        const JPH::ObjectLayerFilter*     layer_filter;
+    };
+
+    static void update_character(const item_t& item, const pass_t& pass, grid_collision_t& collision,
+                                 JPH::TempAllocator& temp)
+    {
+        JPH::CharacterVirtual& c = *item.character;
+        const JPH::Vec3 up = c.GetUp();
+        const JPH::Vec3 velocity = c.GetLinearVelocity();
+        const JPH::Vec3 vertical = up * velocity.Dot(up);
+        const JPH::Vec3 ground = c.GetGroundVelocity();
+
+        JPH::Vec3 v;
+        if (c.GetGroundState() == JPH::CharacterVirtual::EGroundState::OnGround) {
+            v = ground;
+            // not while still moving up from the last jump
+            if (item.jump && (vertical - ground).Dot(up) < 0.1f) v += up * pass.jump_speed;
+        } else {
+            v = vertical;
+        }
+        v += pass.gravity * pass.dt;
+        v += item.desired;
+        c.SetLinearVelocity(v);
+
+        c.SetCharacterVsCharacterCollision(&collision);
+        c.ExtendedUpdate(pass.dt, -up * pass.gravity.Length(), pass.ctx->update_settings,
+                         *pass.broadphase_filter, *pass.layer_filter, {}, {}, temp);
+        c.SetCharacterVsCharacterCollision(nullptr);
+    }
+
+    static void update_cells(void* arg, int32_t begin, int32_t end) {
+        const pass_t& pass = *(const pass_t*)arg;
+        context_t& ctx = *pass.ctx;
+        const int32_t w = jobs::shared().worker_index();
+        const size_t slot = w >= 0 ? (size_t)w : ctx.temp.size() - 1;
+        grid_collision_t& collision = *ctx.collision[slot];
+        JPH::TempAllocator& temp = *ctx.temp[slot];
+
+        for (int32_t i = begin; i < end; i++) {
+            const cell_t& cell = ctx.grid.cells[pass.first_cell + i];
+            collision.x = cell.x;
+            collision.z = cell.z;
+            for (uint32_t k = cell.begin; k < cell.end; k++) {
+                update_character(ctx.grid.items[k], pass, collision, temp);
+            }
+        }
+    }
+
+    // ------------------------------------------------------------
+    //  systems
+    // ------------------------------------------------------------
+    static void character_update_system(flecs::iter& it) {
+        flecs::world world = it.world();
+        character_world_t& cw = world.get_mut<character_world_t>();
+        context_t& ctx = *cw.ctx;
+        grid_t& grid = ctx.grid;
+        const float dt = it.delta_time();
+
+        const auto start = std::chrono::steady_clock::now();
+
+        grid.items.clear();
+        while (it.next()) {
+            auto ch = it.field<const Character>(0);
+            auto mv = it.field<CharacterMove>(1);
+            for (auto i : it) {
+                if (ch[i].character == nullptr) continue;
+                const Vector3 v = mv[i].velocity;
+                grid.items.push_back({ ch[i].character.GetPtr(), it.entity(i).id(),
+                                       JPH::Vec3(v.x, 0.0f, v.z), mv[i].jump, 0, 0 });
+                mv[i].jump = false;
+            }
+        }
+        cw.stats.characters = (int32_t)grid.items.size();
+        if (grid.items.empty()) {
+            cw.stats.cells = 0;
+            cw.stats.supported = 0;
+            cw.stats.update_ms = 0.0;
+            return;
+        }
+
+        // pre-step system: the last step is collected and the next one not
+        // started, so this does not wait
+        JPH::PhysicsSystem& system = physics::system(world);
+        grid.build(dt, cw.margin);
+
+        const JPH::DefaultBroadPhaseLayerFilter broadphase_filter = system.GetDefaultBroadPhaseLayerFilter(cw.layer);
+        const JPH::DefaultObjectLayerFilter layer_filter = system.GetDefaultLayerFilter(cw.layer);
+        pass_t pass{ &ctx, 0, dt, cw.jump_speed, system.GetGravity(), &broadphase_filter, &layer_filter };
+
+        // one pass per colour, cells of a pass never touch each other
+        for (int32_t c = 0; c < 4; c++) {
+            pass.first_cell = grid.color_begin[c];
+            const int32_t count = (int32_t)(grid.color_begin[c + 1] - grid.color_begin[c]);
+            if (cw.parallel) {
+                jobs::parallel_for(jobs::shared(), count, 1, update_cells, &pass, jobs::priority_t::physics);
+            } else {
+                update_cells(&pass, 0, count);
+            }
+        }
+
+        const flecs::entity_t transform_id = world.id<Transform3D>();
+        int32_t supported = 0;
+        for (const item_t& item : grid.items) {
+            if (item.character->IsSupported()) supported++;
+            if (!ecs_is_alive(world, item.entity)) continue;
+            Transform3D* t = (Transform3D*)ecs_get_mut_id(world, item.entity, transform_id);
+            if (t == nullptr) continue;
+            const JPH::RVec3 p = item.character->GetPosition();
+            t->position = { (float)p.GetX(), (float)p.GetY(), (float)p.GetZ() };
+            t->isDirty = true;
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+        cw.stats.supported = supported;
+        cw.stats.cells = (int32_t)grid.cells.size();
+        cw.stats.cell_size = grid.cell_size;
+        cw.stats.update_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // ------------------------------------------------------------
+    //  module
+    // ------------------------------------------------------------
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.import<fixed_step::module>();
+        world.import<physics::module>();
+
+        // CharacterVirtual keeps &physics::system(), configure() must not swap it
+        physics::add_system_holder(world, world.component<Character>());
+        world.component<CharacterMove>();
+        world.component<character_world_t>().add(flecs::Singleton);
+        world.add<character_world_t>();
+
+        flecs::entity update = world.system<const Character, CharacterMove>("character_update_system")
+            .kind(0)
+            .run(character_update_system);
+        physics::add_pre_step_system(world, update);
+    }
+}
@@ -0,0 +1,104 @@
+#include "module_event_bus.hpp"
+#include "module_raylib.hpp"
+#include <chrono>
+#include <cstring>
+
+namespace event_bus {
+
+    static uint32_t align_payload(size_t offset) {
+        return (uint32_t)((offset + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1));
+    }
+
+    void event_bus_t::post_raw(flecs::entity_t event, flecs::entity_t target,
+                               const void* payload, size_t size, coalesce_t mode)
+    {
+        stats_.posted++;
+
+        if (mode != coalesce_t::none) {
+            auto it = index_.find({ event, target });
+            if (it != index_.end()) {
+                stats_.coalesced++;
+                pending_t& p = queue_[it->second];
+                if (mode == coalesce_t::last && size) {
+                    std::memcpy(data_.data() + p.offset, payload, size);
+                }
+                return;
+            }
+            index_[{ event, target }] = (uint32_t)queue_.size();
+        }
+
+        pending_t p;
+        p.event = event;
+        p.target = target;
+        p.size = (uint32_t)size;
+        p.offset = align_payload(data_.size());
+        if (size) {
+            data_.resize(p.offset + size);
+            std::memcpy(data_.data() + p.offset, payload, size);
+        }
+        queue_.push_back(p);
+    }
+
+    void event_bus_t::dispatch(flecs::world& world) {
+        if (queue_.empty()) {
+            stats_.last_batch = 0;
+            return;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+
+        // observers may post again, those land in the fresh queue
+        batch_.swap(queue_);
+        batch_data_.swap(data_);
+        queue_.clear();
+        data_.clear();
+        index_.clear();
+
+        ecs_id_t any = flecs::Any;
+        ecs_type_t ids = { &any, 1 };
+
+        uint32_t count = 0;
+        for (const pending_t& p : batch_) {
+            if (!ecs_is_alive(world, p.target)) {
+                stats_.dropped++;
+                continue;
+            }
+            ecs_event_desc_t desc = {};
+            desc.event = p.event;
+            desc.ids = &ids;
+            desc.entity = p.target;
+            desc.const_param = p.size ? batch_data_.data() + p.offset : nullptr;
+            ecs_emit(world, &desc);
+            count++;
+        }
+        batch_.clear();
+        batch_data_.clear();
+
+        const auto end = std::chrono::steady_clock::now();
+        stats_.dispatched += count;
+        stats_.batches++;
+        stats_.last_batch = count;
+        if (count > stats_.peak_batch) stats_.peak_batch = count;
+        stats_.last_dispatch_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.import<raylib::module>();
+
+        world.component<event_bus_t>().add(flecs::Singleton);
+        world.add<event_bus_t>();
+
+        world.entity<RLDispatchEvents>()
+            .add(flecs::Phase)
+            .depends_on<raylib::RLEndDrawing>();
+
+        world.system("event_bus_dispatch_system")
+            .kind<RLDispatchEvents>()
+            .run([](flecs::iter& it) {
+                flecs::world world = it.world();
+                world.get_mut<event_bus_t>().dispatch(world);
+            });
+    }
+}
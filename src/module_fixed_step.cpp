@@ -0,0 +1,61 @@
+#include "module_fixed_step.hpp"
+#include <cmath>
+
+namespace fixed_step {
+
+    bool progress(flecs::world& world, float frame_dt) {
+        flecs::entity_t pipeline = world.get<fixed_pipeline_t>().pipeline;
+
+        const fixed_time_t& cfg = world.get<fixed_time_t>();
+        const double dt = 1.0 / (double)cfg.tick_rate;
+        const int32_t max_steps = cfg.max_catch_up;
+        double accumulator = cfg.accumulator + (double)frame_dt;
+
+        int32_t steps = 0;
+        while (accumulator >= dt && steps < max_steps) {
+            world.run_pipeline(pipeline, (float)dt);
+            world.get_mut<fixed_time_t>().tick++;   // systems of the tick see its index
+            accumulator -= dt;
+            steps++;
+        }
+
+        // fetch again, systems in the fixed pipeline may have moved the singleton
+        fixed_time_t& ft = world.get_mut<fixed_time_t>();
+        if (accumulator >= dt) {
+            // too far behind, drop the backlog instead of spiralling
+            ft.dropped += (uint64_t)(accumulator / dt);
+            accumulator = std::fmod(accumulator, dt);
+        }
+        ft.accumulator = accumulator;
+        ft.alpha = (float)(accumulator / dt);
+        ft.steps = steps;
+
+        return world.progress(frame_dt);
+    }
+
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.component<FixedPhase>();
+        world.component<fixed_time_t>().add(flecs::Singleton);
+        world.component<fixed_pipeline_t>().add(flecs::Singleton);
+
+        // Not flecs::Phase on purpose, so the builtin pipeline skips them.
+        world.entity<RLFixedPreUpdate>()
+            .add<FixedPhase>();
+        world.entity<RLFixedUpdate>()
+            .add<FixedPhase>()
+            .depends_on<RLFixedPreUpdate>();
+        world.entity<RLFixedPostUpdate>()
+            .add<FixedPhase>()
+            .depends_on<RLFixedUpdate>();
+
+        flecs::entity pipeline = world.pipeline()
+            .with(flecs::System)
+            .with<FixedPhase>().cascade(flecs::DependsOn)
+            .build();
+
+        world.set<fixed_pipeline_t>({ pipeline });
+        world.set<fixed_time_t>({});
+    }
+}
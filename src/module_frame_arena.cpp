@@ -0,0 +1,148 @@
+#include "module_frame_arena.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace frame_arena {
+
+    static size_t align_up(size_t value, size_t align) {
+        return (value + align - 1) & ~(align - 1);
+    }
+
+    // ------------------------------------------------------------
+    //  linear_arena
+    // ------------------------------------------------------------
+    // A block whose malloc failed is kept with size 0: nothing fits, so
+    // allocate() goes to next_block() and tries the heap again.
+    linear_arena::block_t linear_arena::make_block(size_t size) {
+        unsigned char* data = static_cast<unsigned char*>(std::malloc(size));
+        return { data, data ? size : 0 };
+    }
+
+    linear_arena::linear_arena(size_t block_size)
+        : block_size_(block_size) {
+        blocks_.push_back(make_block(block_size_));
+    }
+
+    linear_arena::~linear_arena() {
+        for (block_t& b : blocks_) {
+            std::free(b.data);
+        }
+    }
+
+    size_t linear_arena::capacity() const {
+        size_t total = 0;
+        for (const block_t& b : blocks_) total += b.size;
+        return total;
+    }
+
+    bool linear_arena::next_block(size_t size, size_t align) {
+        // reuse a block that is already reserved
+        while (current_ + 1 < blocks_.size()) {
+            current_++;
+            offset_ = 0;
+            if (size + align <= blocks_[current_].size) return true;
+        }
+        // out of blocks → hit the heap (counted so it shows up in stats)
+        size_t bytes = size + align > block_size_ ? size + align : block_size_;
+        unsigned char* data = static_cast<unsigned char*>(std::malloc(bytes));
+        if (!data) return false;
+        blocks_.push_back({ data, bytes });
+        current_ = blocks_.size() - 1;
+        offset_ = 0;
+        heap_allocs_++;
+        total_heap_allocs_++;
+        return true;
+    }
+
+    void* linear_arena::allocate(size_t size, size_t align) {
+        if (size == 0) size = 1;
+
+        block_t* b = &blocks_[current_];
+        uintptr_t base = reinterpret_cast<uintptr_t>(b->data);
+        size_t start = align_up(base + offset_, align) - base;
+
+        if (start + size > b->size) {
+            if (!next_block(size, align)) return nullptr;
+            b = &blocks_[current_];
+            base = reinterpret_cast<uintptr_t>(b->data);
+            start = align_up(base, align) - base;
+        }
+
+        // alignment padding is consumed too, so the high-water mark (and the
+        // folded block sized from it) fits the same frame again
+        used_ += start + size - offset_;
+        offset_ = start + size;
+        return b->data + start;
+    }
+
+    void linear_arena::reset() {
+        if (used_ > high_water_) high_water_ = used_;
+
+        // fold an overflowing frame into one block big enough for the next one;
+        // that malloc is charged to the frame that starts now
+        uint32_t folded = 0;
+        if (blocks_.size() > 1) {
+            for (block_t& b : blocks_) {
+                std::free(b.data);
+            }
+            blocks_.clear();
+            block_size_ = align_up(high_water_ + high_water_ / 4, 4096);
+            blocks_.push_back(make_block(block_size_));
+            if (blocks_[0].data) {
+                folded = 1;
+                total_heap_allocs_++;
+            }
+        }
+
+        current_ = 0;
+        offset_ = 0;
+        used_ = 0;
+        heap_allocs_ = folded;
+    }
+
+    // ------------------------------------------------------------
+    //  flecs glue
+    // ------------------------------------------------------------
+    // Each stage only ever touches its own slot, so a worker may fill it.
+    linear_arena& frame_arena_t::for_stage(int32_t stage_id) {
+        if (stage_id < 0 || stage_id >= MAX_STAGES) {
+            TraceLog(LOG_FATAL, "FRAME_ARENA: stage %d, only %d supported", stage_id, MAX_STAGES);
+        }
+        std::unique_ptr<linear_arena>& slot = arenas[static_cast<size_t>(stage_id)];
+        if (!slot) slot = std::make_unique<linear_arena>(block_size);
+        return *slot;
+    }
+
+    linear_arena& get(flecs::iter& it) {
+        flecs::world stage = it.world();
+        const frame_arena_t& fa = stage.get<frame_arena_t>();
+        return const_cast<frame_arena_t&>(fa).for_stage(stage.get_stage_id());
+    }
+
+    void reset(flecs::world& world) {
+        frame_arena_t& fa = world.get_mut<frame_arena_t>();
+
+        // the stages known now get their arena here, not in the first frame
+        const int32_t stages = std::min(std::max(world.get_stage_count(), 1), MAX_STAGES);
+        for (int32_t i = 0; i < stages; i++) fa.for_stage(i);
+
+        for (auto& arena : fa.arenas) {
+            if (arena) arena->reset();
+        }
+    }
+
+    void reset_system(flecs::iter& it) {
+        flecs::world world = it.world();
+        if (!world.has<frame_arena_t>()) return;
+        reset(world);
+    }
+
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.component<frame_arena_t>().add(flecs::Singleton);
+        world.add<frame_arena_t>();
+        // make sure stage 0 has an arena before the first frame runs
+        reset(world);
+    }
+}
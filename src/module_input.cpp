@@ -0,0 +1,253 @@
+#include "module_input.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace input {
+
+    // recording file: header, then one input_frame_t per frame
+    struct recording_header_t {
+        char     magic[4];        // "RLIN"
+        uint32_t version;
+        uint32_t frame_size;      // sizeof(input_frame_t), guards layout changes
+        uint32_t reserved;
+    };
+
+    static constexpr uint32_t RECORDING_VERSION = 2;
+
+    // ------------------------------------------------------------
+    //  sampling
+    // ------------------------------------------------------------
+    void sample_raylib(input_frame_t& out, float dt) {
+        std::memset(&out, 0, sizeof(out));
+        for (int32_t key = 1; key < KEY_COUNT; key++) {
+            if (IsKeyDown(key)) out.keys[key >> 6] |= 1ull << (key & 63);
+        }
+        for (int32_t button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_BACK; button++) {
+            if (IsMouseButtonDown(button)) out.mouse_buttons |= 1u << button;
+        }
+        out.mouse_position = GetMousePosition();
+        out.mouse_delta = GetMouseDelta();
+        out.wheel = GetMouseWheelMove();
+
+        if (IsGamepadAvailable(0)) {
+            for (int32_t button = GAMEPAD_BUTTON_LEFT_FACE_UP; button <= GAMEPAD_BUTTON_RIGHT_THUMB; button++) {
+                if (IsGamepadButtonDown(0, button)) out.gamepad_buttons |= 1u << button;
+            }
+            for (int32_t axis = 0; axis < GAMEPAD_AXES; axis++) {
+                out.gamepad_axes[axis] = GetGamepadAxisMovement(0, axis);
+            }
+        }
+        out.dt = dt;
+    }
+
+    // ------------------------------------------------------------
+    //  action mapping
+    // ------------------------------------------------------------
+    action_map_t& action_map_t::bind_action(int32_t action, source_t source, int32_t code, float direction) {
+        if (action < 0 || action >= MAX_ACTIONS) {
+            TraceLog(LOG_WARNING, "INPUT: action %d out of range", action);
+            return *this;
+        }
+        bindings.push_back({ source, false, code, action, direction });
+        return *this;
+    }
+
+    action_map_t& action_map_t::bind_axis(int32_t axis, source_t source, int32_t code, float scale) {
+        if (axis < 0 || axis >= MAX_AXES) {
+            TraceLog(LOG_WARNING, "INPUT: axis %d out of range", axis);
+            return *this;
+        }
+        bindings.push_back({ source, true, code, axis, scale });
+        return *this;
+    }
+
+    static float source_value(const action_map_t& map, const input_frame_t& f, const binding_t& b) {
+        switch (b.source) {
+        case source_t::key:            return f.key_down(b.code) ? 1.0f : 0.0f;
+        case source_t::mouse_button:   return f.mouse_down(b.code) ? 1.0f : 0.0f;
+        case source_t::gamepad_button: return f.gamepad_down(b.code) ? 1.0f : 0.0f;
+        case source_t::gamepad_axis: {
+            if (b.code < 0 || b.code >= GAMEPAD_AXES) return 0.0f;
+            const float v = f.gamepad_axes[b.code];
+            return std::fabs(v) < map.deadzone ? 0.0f : v;
+        }
+        case source_t::mouse_delta_x:  return f.mouse_delta.x;
+        case source_t::mouse_delta_y:  return f.mouse_delta.y;
+        case source_t::mouse_wheel:    return f.wheel;
+        }
+        return 0.0f;
+    }
+
+    void step(input_state_t& state, const action_map_t& map, const input_frame_t& frame) {
+        state.previous = state.current;
+        state.current = frame;
+        state.actions_previous = state.actions;
+
+        uint64_t actions = 0;
+        float axes[MAX_AXES] = {};
+        for (const binding_t& b : map.bindings) {
+            const float v = source_value(map, frame, b);
+            if (b.is_axis) {
+                axes[b.target] += v * b.scale;
+            } else if (v * b.scale >= map.press_threshold) {
+                actions |= 1ull << b.target;
+            }
+        }
+
+        state.actions = actions;
+        std::memcpy(state.axes, axes, sizeof(axes));
+        state.frame++;
+    }
+
+    // ------------------------------------------------------------
+    //  record / replay
+    // ------------------------------------------------------------
+    bool start_recording(flecs::world& world, const char* path) {
+        stop(world);
+
+        std::FILE* f = std::fopen(path, "wb");
+        if (!f) {
+            TraceLog(LOG_WARNING, "INPUT: could not open %s for recording", path);
+            return false;
+        }
+
+        recording_header_t header = {};
+        std::memcpy(header.magic, "RLIN", 4);
+        header.version = RECORDING_VERSION;
+        header.frame_size = sizeof(input_frame_t);
+        if (std::fwrite(&header, sizeof(header), 1, f) != 1) {
+            std::fclose(f);
+            TraceLog(LOG_WARNING, "INPUT: could not write %s", path);
+            return false;
+        }
+
+        input_state_t& state = world.get_mut<input_state_t>();
+        state.file.reset(f);
+        state.mode = mode_t::record;
+        state.frame = 0;
+        state.current = {};
+        state.actions = 0;
+        TraceLog(LOG_INFO, "INPUT: recording to %s", path);
+        return true;
+    }
+
+    bool start_replay(flecs::world& world, const char* path) {
+        stop(world);
+
+        std::FILE* f = std::fopen(path, "rb");
+        if (!f) {
+            TraceLog(LOG_WARNING, "INPUT: could not open %s for replay", path);
+            return false;
+        }
+
+        recording_header_t header;
+        if (std::fread(&header, sizeof(header), 1, f) != 1 ||
+            std::memcmp(header.magic, "RLIN", 4) != 0 ||
+            header.version != RECORDING_VERSION ||
+            header.frame_size != sizeof(input_frame_t)) {
+            std::fclose(f);
+            TraceLog(LOG_WARNING, "INPUT: %s is not a compatible recording", path);
+            return false;
+        }
+
+        input_state_t& state = world.get_mut<input_state_t>();
+        state.file.reset(f);
+        state.mode = mode_t::replay;
+        state.frame = 0;
+        state.current = {};
+        state.actions = 0;
+        state.replay_finished = false;
+        TraceLog(LOG_INFO, "INPUT: replaying %s", path);
+        return true;
+    }
+
+    void feed_frame(flecs::world& world, const input_frame_t& frame) {
+        input_state_t& state = world.get_mut<input_state_t>();
+        state.fed = frame;
+        state.has_fed = true;
+    }
+
+    void stop(flecs::world& world) {
+        input_state_t& state = world.get_mut<input_state_t>();
+        if (state.file) {
+            TraceLog(LOG_INFO, "INPUT: %s stopped after %llu frames",
+                     state.mode == mode_t::record ? "recording" : "replay",
+                     (unsigned long long)state.frame);
+        }
+        state.file.reset();
+        state.mode = mode_t::live;
+    }
+
+    // the only reader of raylib input
+    static void input_sample_system(flecs::iter& it) {
+        flecs::world world = it.world();
+        input_state_t& state = world.get_mut<input_state_t>();
+        const action_map_t& map = world.get<action_map_t>();
+
+        input_frame_t frame;
+        const bool fed = state.has_fed;
+        state.has_fed = false;
+        if (state.mode == mode_t::replay) {
+            if (std::fread(&frame, sizeof(frame), 1, state.file.get()) != 1) {
+                stop(world);
+                state.replay_finished = true;
+                return;
+            }
+        } else {
+            if (fed) frame = state.fed;
+            else sample_raylib(frame, state.live_dt);
+            if (state.mode == mode_t::record &&
+                std::fwrite(&frame, sizeof(frame), 1, state.file.get()) != 1) {
+                TraceLog(LOG_WARNING, "INPUT: write failed, recording stopped");
+                stop(world);
+            }
+        }
+        step(state, map, frame);
+    }
+
+    bool begin_frame(flecs::world& world, float live_dt) {
+        world.get_mut<input_state_t>().live_dt = live_dt;
+
+        world.run_pipeline(world.get<input_pipeline_t>().pipeline, live_dt);
+
+        // fetch again, the pipeline may have moved the singleton
+        input_state_t& state = world.get_mut<input_state_t>();
+        if (state.replay_finished) {
+            state.replay_finished = false;
+            return false;
+        }
+        return true;
+    }
+
+    float frame_dt(const flecs::world& world) {
+        return world.get<input_state_t>().current.dt;
+    }
+
+    // ------------------------------------------------------------
+    //  module
+    // ------------------------------------------------------------
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.component<InputPhase>();
+        world.component<input_state_t>().add(flecs::Singleton);
+        world.component<action_map_t>().add(flecs::Singleton);
+        world.component<input_pipeline_t>().add(flecs::Singleton);
+        world.add<input_state_t>();
+        world.add<action_map_t>();
+
+        // Not flecs::Phase, runs from begin_frame() ahead of the fixed ticks.
+        world.entity<RLInput>()
+            .add<InputPhase>();
+
+        flecs::entity pipeline = world.pipeline()
+            .with(flecs::System)
+            .with<InputPhase>().cascade(flecs::DependsOn)
+            .build();
+        world.set<input_pipeline_t>({ pipeline });
+
+        world.system("input_sample_system")
+            .kind<RLInput>()
+            .run(input_sample_system);
+    }
+}
@@ -0,0 +1,169 @@
+#include "module_input_events.hpp"
+#include "module_input.hpp"
+#include "module_frame_arena.hpp"
+#include "module_raylib.hpp"
+#include "spsc_queue.hpp"
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+namespace input_events {
+
+    // ------------------------------------------------------------
+    //  GLFW side
+    // ------------------------------------------------------------
+    // GLFW callbacks carry no user data we can own (raylib may use the
+    // window user pointer), so the collector is file-local. One window.
+    struct collector_t {
+        spsc_queue<input_event_t, 4096> queue;
+        uint64_t dropped = 0;
+        GLFWwindow* window = nullptr;
+        GLFWkeyfun         prev_key = nullptr;
+        GLFWmousebuttonfun prev_button = nullptr;
+        GLFWcursorposfun   prev_cursor = nullptr;
+        GLFWscrollfun      prev_scroll = nullptr;
+    };
+
+    static collector_t g_collector;
+
+    static void push(event_type_t type, int32_t code, int action, int mods, double x, double y) {
+        input_event_t e;
+        e.time = glfwGetTime();
+        e.type = type;
+        e.action = (uint8_t)action;
+        e.mods = (uint16_t)mods;
+        e.code = code;
+        e.x = (float)x;
+        e.y = (float)y;
+        if (!g_collector.queue.push(e)) g_collector.dropped++;
+    }
+
+    static void key_callback(GLFWwindow* w, int key, int scancode, int action, int mods) {
+        push(event_type_t::key, key, action, mods, 0.0, 0.0);
+        if (g_collector.prev_key) g_collector.prev_key(w, key, scancode, action, mods);
+    }
+
+    static void button_callback(GLFWwindow* w, int button, int action, int mods) {
+        push(event_type_t::mouse_button, button, action, mods, 0.0, 0.0);
+        if (g_collector.prev_button) g_collector.prev_button(w, button, action, mods);
+    }
+
+    static void cursor_callback(GLFWwindow* w, double x, double y) {
+        push(event_type_t::cursor, 0, 0, 0, x, y);
+        if (g_collector.prev_cursor) g_collector.prev_cursor(w, x, y);
+    }
+
+    static void scroll_callback(GLFWwindow* w, double x, double y) {
+        push(event_type_t::scroll, 0, 0, 0, x, y);
+        if (g_collector.prev_scroll) g_collector.prev_scroll(w, x, y);
+    }
+
+    bool install(flecs::world& world) {
+        if (g_collector.window) return true;
+
+        GLFWwindow* window = static_cast<GLFWwindow*>(GetWindowHandle());
+        if (!window) {
+            TraceLog(LOG_WARNING, "INPUT: no GLFW window, timestamped input disabled");
+            return false;
+        }
+
+        g_collector.window = window;
+        g_collector.prev_key = glfwSetKeyCallback(window, key_callback);
+        g_collector.prev_button = glfwSetMouseButtonCallback(window, button_callback);
+        g_collector.prev_cursor = glfwSetCursorPosCallback(window, cursor_callback);
+        g_collector.prev_scroll = glfwSetScrollCallback(window, scroll_callback);
+
+        world.get_mut<input_events_t>().installed = true;
+        return true;
+    }
+
+    void uninstall(flecs::world& world) {
+        if (!g_collector.window) return;
+
+        glfwSetKeyCallback(g_collector.window, g_collector.prev_key);
+        glfwSetMouseButtonCallback(g_collector.window, g_collector.prev_button);
+        glfwSetCursorPosCallback(g_collector.window, g_collector.prev_cursor);
+        glfwSetScrollCallback(g_collector.window, g_collector.prev_scroll);
+        g_collector.window = nullptr;
+
+        input_events_t& ev = world.get_mut<input_events_t>();
+        ev = input_events_t{};
+    }
+
+    // Callbacks fire on the main thread inside raylib's poll, so nothing is
+    // pushed while this runs and size() is exact.
+    static int32_t drain(frame_arena::linear_arena& arena, const input_event_t*& out) {
+        const size_t pending = g_collector.queue.size();
+        if (pending == 0) return 0;
+        input_event_t* events = arena.allocate_array<input_event_t>(pending);
+        if (!events) return 0;
+
+        int32_t count = 0;
+        while ((size_t)count < pending && g_collector.queue.pop(events[count])) count++;
+        out = events;
+        return count;
+    }
+
+    // ------------------------------------------------------------
+    //  systems
+    // ------------------------------------------------------------
+    // RLInput, after input_sample_system: everything up to the snapshot
+    static void input_events_drain_system(flecs::iter& it) {
+        flecs::world world = it.world();
+        input_events_t& ev = world.get_mut<input_events_t>();
+        const input::input_state_t& in = world.get<input::input_state_t>();
+        const bool latch = ev.installed && in.mode != input::mode_t::replay;
+
+        ev.events = nullptr;
+        ev.event_count = 0;
+        ev.carried_delta = latch ? ev.late_mouse_delta : Vector2{ 0, 0 };
+        ev.late_mouse_delta = { 0, 0 };
+        ev.look_delta = Vector2Subtract(in.current.mouse_delta, ev.carried_delta);
+        if (!ev.installed) return;
+
+        ev.frame_time = glfwGetTime();
+        ev.event_count = drain(frame_arena::get(it), ev.events);
+        ev.dropped = g_collector.dropped;
+    }
+
+    // RLLateLatch: read the cursor again, without polling events
+    static void input_events_latch_system(flecs::iter& it) {
+        flecs::world world = it.world();
+        input_events_t& ev = world.get_mut<input_events_t>();
+        if (!ev.installed) return;
+
+        const input::input_state_t& in = world.get<input::input_state_t>();
+        if (in.mode == input::mode_t::replay) return;
+
+        double x = 0.0, y = 0.0;
+        glfwGetCursorPos(g_collector.window, &x, &y);
+        ev.latch_time = glfwGetTime();
+        ev.late_mouse_delta = { (float)x - in.current.mouse_position.x,
+                                (float)y - in.current.mouse_position.y };
+        ev.look_delta = Vector2Add(Vector2Subtract(in.current.mouse_delta, ev.carried_delta),
+                                   ev.late_mouse_delta);
+    }
+
+    // ------------------------------------------------------------
+    //  module
+    // ------------------------------------------------------------
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.import<raylib::module>();
+        world.import<input::module>();
+
+        world.component<input_events_t>().add(flecs::Singleton);
+        world.add<input_events_t>();
+
+        // created after input_sample_system, so it runs after it in RLInput
+        world.system("input_events_drain_system")
+            .kind<input::RLInput>()
+            .run(input_events_drain_system);
+
+        // created before user systems, so it runs first in RLLateLatch
+        world.system("input_events_latch_system")
+            .kind<raylib::RLLateLatch>()
+            .run(input_events_latch_system);
+    }
+}
@@ -0,0 +1,1487 @@
+#include "module_physics.hpp"
+#include "module_fixed_step.hpp"
+#include "job_system.hpp"
+
+#include <Jolt/RegisterTypes.h>
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Body/BodyActivationListener.h>
+#include <Jolt/Physics/Body/BodyLockMulti.h>
+#include <Jolt/Physics/Collision/ContactListener.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/ShapeCast.h>
+#include <Jolt/Physics/Body/BodyFilter.h>
+#ifdef JPH_TRACK_NARROWPHASE_STATS
+#include <Jolt/Physics/Collision/NarrowPhaseStats.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+JPH_SUPPRESS_WARNINGS
+
+namespace physics {
+
+    // ------------------------------------------------------------
+    //  Jolt globals (shared by every world)
+    // ------------------------------------------------------------
+    static void trace_impl(const char* fmt, ...) {
+        va_list list;
+        va_start(list, fmt);
+        char buffer[1024];
+        vsnprintf(buffer, sizeof(buffer), fmt, list);
+        va_end(list);
+        TraceLog(LOG_INFO, "JOLT: %s", buffer);
+    }
+
+#ifdef JPH_ENABLE_ASSERTS
+    static bool assert_failed_impl(const char* expression, const char* message,
+                                   const char* file, JPH::uint line)
+    {
+        TraceLog(LOG_WARNING, "JOLT: %s:%u: (%s) %s", file, line, expression,
+                 message != nullptr ? message : "");
+        return true;
+    }
+#endif
+
+    // ------------------------------------------------------------
+    //  heap
+    // ------------------------------------------------------------
+    // Jolt's Allocate / Free hooks, counting every byte Jolt holds (bodies,
+    // shapes, broadphase, contact caches). Free gets no size, so each block
+    // carries a header in front of the aligned pointer with the size and
+    // the address malloc returned. The hooks are process wide and stay
+    // installed, blocks may be freed after the last world is gone.
+#ifndef JPH_DISABLE_CUSTOM_ALLOCATOR
+    struct heap_header_t {
+        void*  raw;
+        size_t size;
+    };
+
+    static std::atomic<size_t>   g_heap_bytes{ 0 };
+    static std::atomic<size_t>   g_heap_peak{ 0 };
+    static std::atomic<int64_t>  g_heap_blocks{ 0 };
+    static std::atomic<uint64_t> g_heap_allocations{ 0 };
+
+    static void* heap_aligned_allocate(size_t size, size_t alignment) {
+        alignment = std::max(alignment, alignof(heap_header_t));
+        uint8_t* raw = (uint8_t*)malloc(size + alignment + sizeof(heap_header_t));
+        if (raw == nullptr) return nullptr;
+        const uintptr_t first = (uintptr_t)(raw + sizeof(heap_header_t));
+        uint8_t* p = (uint8_t*)((first + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        ((heap_header_t*)p)[-1] = { raw, size };
+
+        const size_t bytes = g_heap_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+        size_t peak = g_heap_peak.load(std::memory_order_relaxed);
+        while (bytes > peak && !g_heap_peak.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {}
+        g_heap_blocks.fetch_add(1, std::memory_order_relaxed);
+        g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+        return p;
+    }
+
+    static void heap_aligned_free(void* block) {
+        if (block == nullptr) return;
+        const heap_header_t header = ((heap_header_t*)block)[-1];
+        g_heap_bytes.fetch_sub(header.size, std::memory_order_relaxed);
+        g_heap_blocks.fetch_sub(1, std::memory_order_relaxed);
+        free(header.raw);
+    }
+
+    static void* heap_allocate(size_t size) {
+        return heap_aligned_allocate(size, 16);   // what malloc gives on 64 bit
+    }
+
+    static void* heap_reallocate(void* block, size_t old_size, size_t new_size) {
+        void* p = heap_allocate(new_size);
+        if (p != nullptr && block != nullptr) memcpy(p, block, std::min(old_size, new_size));
+        heap_aligned_free(block);
+        return p;
+    }
+
+    static void install_heap_hooks() {
+        JPH::Allocate = heap_allocate;
+        JPH::Reallocate = heap_reallocate;
+        JPH::Free = heap_aligned_free;
+        JPH::AlignedAllocate = heap_aligned_allocate;
+        JPH::AlignedFree = heap_aligned_free;
+    }
+#endif
+
+    heap_stats_t heap_stats() {
+        heap_stats_t st;
+#ifndef JPH_DISABLE_CUSTOM_ALLOCATOR
+        st.bytes = g_heap_bytes.load(std::memory_order_relaxed);
+        st.peak = g_heap_peak.load(std::memory_order_relaxed);
+        st.blocks = g_heap_blocks.load(std::memory_order_relaxed);
+        st.allocations = g_heap_allocations.load(std::memory_order_relaxed);
+#endif
+        return st;
+    }
+
+    void install_jolt_hooks() {
+        static const bool installed = [] {
+#ifndef JPH_DISABLE_CUSTOM_ALLOCATOR
+            install_heap_hooks();
+#else
+            JPH::RegisterDefaultAllocator();
+#endif
+            JPH::Trace = trace_impl;
+            JPH_IF_ENABLE_ASSERTS(JPH::AssertFailed = assert_failed_impl;)
+            return true;
+        }();
+        (void)installed;
+    }
+
+    // The mutex keeps a second world from using the factory before the
+    // first acquire has finished registering the types.
+    static std::atomic<int32_t> g_jolt_users{ 0 };
+    static std::mutex g_jolt_mutex;
+
+    static void jolt_acquire() {
+        std::lock_guard<std::mutex> lock(g_jolt_mutex);
+        if (g_jolt_users.fetch_add(1) > 0) return;
+        install_jolt_hooks();
+        JPH::Factory::sInstance = new JPH::Factory();
+        JPH::RegisterTypes();
+    }
+
+    static void jolt_release() {
+        std::lock_guard<std::mutex> lock(g_jolt_mutex);
+        if (g_jolt_users.fetch_sub(1) > 1) return;
+        JPH::UnregisterTypes();
+        delete JPH::Factory::sInstance;
+        JPH::Factory::sInstance = nullptr;
+    }
+
+    // ------------------------------------------------------------
+    //  layers
+    // ------------------------------------------------------------
+    int32_t layer_config_t::add_broadphase(const char* name) {
+        if (broadphase_count >= MAX_BROADPHASE_LAYERS) return -1;
+        broadphase_names[broadphase_count] = name;
+        return broadphase_count++;
+    }
+
+    int32_t layer_config_t::add_layer(const char* name, int32_t broadphase) {
+        if (layer_count >= MAX_LAYERS || broadphase < 0 || broadphase >= broadphase_count) return -1;
+        layer_names[layer_count] = name;
+        broadphase_of[layer_count] = (uint8_t)broadphase;
+        collides[layer_count] = 0;
+        return layer_count++;
+    }
+
+    void layer_config_t::collide(int32_t a, int32_t b) {
+        if (a < 0 || b < 0 || a >= layer_count || b >= layer_count) return;
+        collides[a] |= 1u << b;
+        collides[b] |= 1u << a;
+    }
+
+    int32_t layer_config_t::find_layer(const char* name) const {
+        for (int32_t i = 0; i < layer_count; i++) {
+            if (layer_names[i] == name) return i;
+        }
+        return -1;
+    }
+
+    int32_t layer_config_t::find_broadphase(const char* name) const {
+        for (int32_t i = 0; i < broadphase_count; i++) {
+            if (broadphase_names[i] == name) return i;
+        }
+        return -1;
+    }
+
+    layer_config_t layer_config_t::defaults() {
+        layer_config_t c;
+        const int32_t bp_static = c.add_broadphase("NON_MOVING");
+        const int32_t bp_moving = c.add_broadphase("MOVING");
+        const int32_t bp_debris = c.add_broadphase("DEBRIS");
+
+        const int32_t non_moving = c.add_layer("NON_MOVING", bp_static);
+        const int32_t moving     = c.add_layer("MOVING", bp_moving);
+        const int32_t debris     = c.add_layer("DEBRIS", bp_debris);
+        const int32_t trigger    = c.add_layer("TRIGGER", bp_moving);
+        const int32_t character  = c.add_layer("CHARACTER", bp_moving);
+
+        c.collide(non_moving, moving);
+        c.collide(non_moving, debris);
+        c.collide(non_moving, character);
+        c.collide(moving, moving);
+        c.collide(moving, debris);
+        c.collide(moving, trigger);
+        c.collide(moving, character);
+        c.collide(trigger, character);
+        c.collide(character, character);
+        // debris: not with itself, triggers or characters
+        return c;
+    }
+
+    bool load_layers(const char* path, layer_config_t& out) {
+        std::FILE* f = std::fopen(path, "rb");
+        if (!f) {
+            TraceLog(LOG_WARNING, "PHYSICS: cannot open layer file %s", path);
+            return false;
+        }
+
+        layer_config_t c;
+        char line[512];
+        int32_t line_no = 0;
+        bool ok = true;
+        while (ok && std::fgets(line, sizeof(line), f)) {
+            line_no++;
+            if (char* comment = std::strchr(line, '#')) *comment = '\0';
+
+            char* words[layer_config_t::MAX_LAYERS + 2];
+            int32_t count = 0;
+            for (char* w = std::strtok(line, " \t\r\n"); w && count < (int32_t)(sizeof(words) / sizeof(words[0]));
+                 w = std::strtok(nullptr, " \t\r\n")) {
+                words[count++] = w;
+            }
+            if (count == 0) continue;
+
+            if (std::strcmp(words[0], "broadphase") == 0 && count == 2) {
+                ok = c.add_broadphase(words[1]) >= 0;
+            } else if (std::strcmp(words[0], "layer") == 0 && count == 3) {
+                ok = c.add_layer(words[1], c.find_broadphase(words[2])) >= 0;
+            } else if (std::strcmp(words[0], "collide") == 0 && count >= 3) {
+                const int32_t a = c.find_layer(words[1]);
+                ok = a >= 0;
+                for (int32_t i = 2; ok && i < count; i++) {
+                    const int32_t b = c.find_layer(words[i]);
+                    ok = b >= 0;
+                    c.collide(a, b);
+                }
+            } else {
+                ok = false;
+            }
+        }
+        std::fclose(f);
+
+        if (!ok) {
+            TraceLog(LOG_WARNING, "PHYSICS: %s:%d: bad layer entry (unknown name or too many layers)", path, line_no);
+            return false;
+        }
+        if (c.layer_count == 0) {
+            TraceLog(LOG_WARNING, "PHYSICS: %s: no layers", path);
+            return false;
+        }
+        out = c;
+        return true;
+    }
+
+    layer_tables_t::layer_tables_t(const layer_config_t& config)
+        : config_(config)
+    {
+        // object layer -> every broadphase layer holding something it collides with
+        for (int32_t a = 0; a < config_.layer_count; a++) {
+            uint32_t mask = 0;
+            for (int32_t b = 0; b < config_.layer_count; b++) {
+                if (config_.collides[a] & (1u << b)) mask |= 1u << config_.broadphase_of[b];
+            }
+            broadphase_mask_[a] = mask;
+        }
+    }
+
+    JPH::uint layer_tables_t::broadphase_interface_t::GetNumBroadPhaseLayers() const {
+        return (JPH::uint)t_.config_.broadphase_count;
+    }
+
+    JPH::BroadPhaseLayer layer_tables_t::broadphase_interface_t::GetBroadPhaseLayer(JPH::ObjectLayer layer) const {
+        JPH_ASSERT(layer < t_.config_.layer_count);
+        return JPH::BroadPhaseLayer(t_.config_.broadphase_of[layer]);
+    }
+
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+    const char* layer_tables_t::broadphase_interface_t::GetBroadPhaseLayerName(JPH::BroadPhaseLayer layer) const {
+        const JPH::uint i = (JPH::BroadPhaseLayer::Type)layer;
+        return i < (JPH::uint)t_.config_.broadphase_count ? t_.config_.broadphase_names[i].c_str() : "INVALID";
+    }
+#endif
+
+    bool layer_tables_t::object_vs_broadphase_t::ShouldCollide(JPH::ObjectLayer layer, JPH::BroadPhaseLayer bp) const {
+        return (t_.broadphase_mask_[layer] >> (JPH::BroadPhaseLayer::Type)bp) & 1u;
+    }
+
+    bool layer_tables_t::object_pair_t::ShouldCollide(JPH::ObjectLayer a, JPH::ObjectLayer b) const {
+        return (t_.config_.collides[a] >> b) & 1u;
+    }
+
+    // ------------------------------------------------------------
+    //  active set
+    // ------------------------------------------------------------
+    // Jolt calls the listener from its workers while stepping, so the set is
+    // two atomic bitsets indexed by body index: awake bodies, and bodies that
+    // fell asleep since the last sync (their final pose still has to be
+    // written once). Sleeping bodies cost one zero word per 64 bodies.
+    class active_set_t final : public JPH::BodyActivationListener {
+    public:
+        explicit active_set_t(JPH::uint capacity)
+            : words_((capacity + 63) / 64)
+            , awake_(new std::atomic<uint64_t>[words_]())
+            , slept_(new std::atomic<uint64_t>[words_]())
+            , ids_(new JPH::uint32[capacity])
+        {
+        }
+
+        void OnBodyActivated(const JPH::BodyID& id, JPH::uint64) override {
+            const JPH::uint32 i = id.GetIndex();
+            ids_[i] = id.GetIndexAndSequenceNumber();
+            awake_[i >> 6].fetch_or(uint64_t(1) << (i & 63), std::memory_order_release);
+            count_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void OnBodyDeactivated(const JPH::BodyID& id, JPH::uint64) override {
+            const JPH::uint32 i = id.GetIndex();
+            const uint64_t bit = uint64_t(1) << (i & 63);
+            awake_[i >> 6].fetch_and(~bit, std::memory_order_release);
+            slept_[i >> 6].fetch_or(bit, std::memory_order_release);
+            count_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // Awake bodies plus the ones that fell asleep since the last call.
+        // Returns how many of them are asleep. Call between steps.
+        int32_t collect(JPH::BodyIDVector& out) {
+            int32_t slept = 0;
+            for (size_t w = 0; w < words_; w++) {
+                const uint64_t gone = slept_[w].load(std::memory_order_relaxed)
+                    ? slept_[w].exchange(0, std::memory_order_acquire) : 0;
+                uint64_t bits = awake_[w].load(std::memory_order_acquire) | gone;
+                slept += popcount(gone & ~awake_[w].load(std::memory_order_relaxed));
+                while (bits) {
+                    const uint32_t b = ctz(bits);
+                    bits &= bits - 1;
+                    out.push_back(JPH::BodyID(ids_[w * 64 + b]));
+                }
+            }
+            return slept;
+        }
+
+        int32_t count() const { return count_.load(std::memory_order_relaxed); }
+
+        // Start over from `active`. RestoreState moves bodies between awake
+        // and asleep without calling the listener. Between steps.
+        void rebuild(const JPH::BodyIDVector& active) {
+            for (size_t w = 0; w < words_; w++) {
+                awake_[w].store(0, std::memory_order_relaxed);
+                slept_[w].store(0, std::memory_order_relaxed);
+            }
+            for (const JPH::BodyID& id : active) {
+                const JPH::uint32 i = id.GetIndex();
+                ids_[i] = id.GetIndexAndSequenceNumber();
+                awake_[i >> 6].fetch_or(uint64_t(1) << (i & 63), std::memory_order_relaxed);
+            }
+            count_.store((int32_t)active.size(), std::memory_order_release);
+        }
+
+    private:
+        static int32_t popcount(uint64_t v) {
+            int32_t n = 0;
+            for (; v; v &= v - 1) n++;
+            return n;
+        }
+
+        static uint32_t ctz(uint64_t v) {
+#if defined(_MSC_VER)
+            unsigned long i;
+            _BitScanForward64(&i, v);
+            return (uint32_t)i;
+#else
+            return (uint32_t)__builtin_ctzll(v);
+#endif
+        }
+
+        size_t words_;
+        std::unique_ptr<std::atomic<uint64_t>[]> awake_;
+        std::unique_ptr<std::atomic<uint64_t>[]> slept_;
+        std::unique_ptr<JPH::uint32[]> ids_;          // full id (with sequence) per index
+        std::atomic<int32_t> count_{0};
+    };
+
+    // ------------------------------------------------------------
+    //  contact listener
+    // ------------------------------------------------------------
+    // Called from the job workers and the thread inside PhysicsSystem::Update,
+    // with the bodies locked. Every thread appends to its own buffer (jobs
+    // worker index, the last one for the updating thread), so a callback is a
+    // push_back: no lock, no shared cache line. Entities are resolved later,
+    // on the main thread.
+    class contact_buffers_t final : public JPH::ContactListener {
+    public:
+        explicit contact_buffers_t(int32_t workers) : buffers_(workers + 1) {}
+
+        void OnContactAdded(const JPH::Body& b1, const JPH::Body& b2, const JPH::ContactManifold& m,
+                            JPH::ContactSettings&) override {
+            push(b1, b2, m, contact_state_t::added);
+        }
+
+        void OnContactPersisted(const JPH::Body& b1, const JPH::Body& b2, const JPH::ContactManifold& m,
+                                JPH::ContactSettings&) override {
+            if (persisted) push(b1, b2, m, contact_state_t::persisted);
+        }
+
+        // the bodies may be gone already, only the ids are safe
+        void OnContactRemoved(const JPH::SubShapeIDPair& pair) override {
+            contact_t c;
+            c.body_a = pair.GetBody1ID();
+            c.body_b = pair.GetBody2ID();
+            c.state = contact_state_t::removed;
+            buffer().records.push_back(c);
+        }
+
+        // Move the records of the finished step to out. Between steps.
+        void merge(std::vector<contact_t>& out) {
+            for (buffer_t& b : buffers_) {
+                out.insert(out.end(), b.records.begin(), b.records.end());
+                b.records.clear();
+            }
+        }
+
+        // Drop the records of a step nobody will collect. Between steps.
+        void clear() {
+            for (buffer_t& b : buffers_) b.records.clear();
+        }
+
+        bool persisted = false;   // set by the main thread between steps
+
+    private:
+        struct alignas(64) buffer_t {
+            std::vector<contact_t> records;
+        };
+
+        buffer_t& buffer() {
+            const int32_t w = jobs::shared().worker_index();
+            return buffers_[w >= 0 ? w : (int32_t)buffers_.size() - 1];
+        }
+
+        void push(const JPH::Body& b1, const JPH::Body& b2, const JPH::ContactManifold& m, contact_state_t state) {
+            contact_t c;
+            c.body_a = b1.GetID();
+            c.body_b = b2.GetID();
+            c.state = state;
+
+            const JPH::uint n = (JPH::uint)m.mRelativeContactPointsOn1.size();
+            JPH::RVec3 point = m.mBaseOffset;
+            if (n > 0) {
+                JPH::RVec3 sum = JPH::RVec3::sZero();
+                for (JPH::uint i = 0; i < n; i++) sum += m.GetWorldSpaceContactPointOn1(i);
+                point = sum / (JPH::Real)n;
+            }
+            const JPH::Vec3 normal = m.mWorldSpaceNormal;
+            c.point = { (float)point.GetX(), (float)point.GetY(), (float)point.GetZ() };
+            c.normal = { normal.GetX(), normal.GetY(), normal.GetZ() };
+
+            // static and kinematic bodies count as infinite mass
+            const float inv_a = b1.IsDynamic() ? b1.GetMotionProperties()->GetInverseMass() : 0.0f;
+            const float inv_b = b2.IsDynamic() ? b2.GetMotionProperties()->GetInverseMass() : 0.0f;
+            const float approach = (b1.GetLinearVelocity() - b2.GetLinearVelocity()).Dot(normal);
+            if (approach > 0.0f && inv_a + inv_b > 0.0f) c.impulse = approach / (inv_a + inv_b);
+
+            buffer().records.push_back(c);
+        }
+
+        std::vector<buffer_t> buffers_;
+    };
+
+    // ------------------------------------------------------------
+    //  context
+    // ------------------------------------------------------------
+    // TempAllocatorImpl plus the high-water mark of a step and a heap
+    // fallback: a step that outgrows the block gets Jolt heap memory (and
+    // is counted) instead of asserting. Jolt allocates in stack order and
+    // never from two jobs at once, so plain counters do.
+    class temp_allocator_t final : public JPH::TempAllocator {
+    public:
+        explicit temp_allocator_t(size_t size) : impl_((JPH::uint)size), size_(size) {}
+
+        void* Allocate(JPH::uint size) override {
+            if (size == 0) return nullptr;
+            used_ += JPH::AlignUp(size, JPH_RVECTOR_ALIGNMENT);   // what the impl would reserve
+            high_water_ = std::max(high_water_, used_);
+            if (impl_.CanAllocate(size)) return impl_.Allocate(size);
+            fallbacks_++;
+            return JPH::AlignedAllocate(size, JPH_RVECTOR_ALIGNMENT);
+        }
+
+        void Free(void* p, JPH::uint size) override {
+            if (p == nullptr) return;
+            used_ -= JPH::AlignUp(size, JPH_RVECTOR_ALIGNMENT);
+            if (impl_.OwnsMemory(p)) impl_.Free(p, size);
+            else JPH::AlignedFree(p);
+        }
+
+        size_t  size() const { return size_; }
+        size_t  high_water() const { return high_water_; }
+        int32_t fallbacks() const { return fallbacks_; }
+
+        void begin_step() {
+            high_water_ = used_;
+            fallbacks_ = 0;
+        }
+
+    private:
+        JPH::TempAllocatorImpl impl_;
+        size_t  size_;
+        size_t  used_ = 0;
+        size_t  high_water_ = 0;
+        int32_t fallbacks_ = 0;   // this step
+    };
+
+    // pose read from a body, written to Transform3D after the lock is gone
+    struct pose_t {
+        flecs::entity_t entity;
+        Vector3         position;
+        Quaternion      rotation;
+    };
+
+    // a ray when shape is null
+    struct query_t {
+        JPH::ShapeRefC   shape;
+        Vector3          origin;
+        Quaternion       rotation;
+        Vector3          direction;
+        JPH::ObjectLayer layer;
+        JPH::BodyID      ignore;
+        uint64_t         user;
+    };
+
+    // entity of a body, kept after the body is destroyed for removed contacts
+    struct body_entity_t {
+        JPH::BodyID     id;
+        flecs::entity_t entity = 0;
+    };
+
+    struct context_t {
+        explicit context_t(const physics_config_t& cfg)
+            : config(cfg)
+            , temp_allocator(cfg.temp_allocator_size)
+            , job_system(jobs::shared(), JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers)
+            , layers(cfg.layers)
+            , active_set(cfg.max_bodies)
+            , contact_listener(jobs::shared().worker_count())
+        {
+            system.Init(cfg.max_bodies, cfg.num_body_mutexes, cfg.max_body_pairs, cfg.max_contact_constraints,
+                        layers.broadphase(), layers.object_vs_broadphase(), layers.object_pair());
+            system.SetBodyActivationListener(&active_set);
+            system.SetContactListener(&contact_listener);
+        }
+
+        ~context_t() {
+            if (!step_thread.joinable()) return;
+            {
+                std::lock_guard<std::mutex> lock(step_mutex);
+                step_quit = true;
+            }
+            step_cv.notify_all();
+            step_thread.join();   // a running step finishes first
+        }
+
+        // PhysicsSystem::Update, on whichever thread owns the step
+        void run_step(float dt, int32_t collision_steps) {
+            const auto start = std::chrono::steady_clock::now();
+            if (optimize_broadphase) {
+                system.OptimizeBroadPhase();   // after add_bodies, off the main thread when threaded
+                optimize_broadphase = false;
+            }
+            temp_allocator.begin_step();
+            step_error = system.Update(dt, collision_steps, &temp_allocator, &job_system);
+            const auto end = std::chrono::steady_clock::now();
+            step_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        }
+
+        physics_config_t              config;
+        temp_allocator_t              temp_allocator;
+        jobs::jolt_job_system_t       job_system;          // shared workers, physics priority
+        layer_tables_t                layers;              // outlives system
+        active_set_t                  active_set;          // outlives system
+        contact_buffers_t             contact_listener;    // outlives system
+        JPH::PhysicsSystem            system;
+
+        // set by add_bodies, read by the next run_step
+        bool optimize_broadphase = false;
+
+        // result of the last run_step
+        double                   step_ms = 0.0;
+        JPH::EPhysicsUpdateError step_error = JPH::EPhysicsUpdateError::None;
+
+        // pipelined step (physics_world_t::threaded)
+        std::thread             step_thread;
+        std::mutex              step_mutex;
+        std::condition_variable step_cv;
+        bool    step_busy = false;        // guarded by step_mutex
+        bool    step_quit = false;
+        float   step_dt = 0.0f;
+        int32_t step_collision_steps = 1;
+        bool    in_flight = false;        // main thread: kicked, not waited for
+        bool    uncollected = false;      // main thread: poses of a finished step not read yet
+
+        // gameplay writes, applied at the start of the next tick
+        std::mutex             command_mutex;
+        std::vector<command_t> commands;
+        std::vector<command_t> applying;
+
+        // sync scratch, kept between ticks
+        JPH::BodyIDVector   active;
+        std::vector<pose_t> poses;
+
+        // casts submitted for the next batch, hits of the last batch
+        std::mutex               query_mutex;
+        std::vector<query_t>     queries;
+        std::vector<query_t>     running;
+        std::vector<query_hit_t> query_hits;
+        uint32_t                 query_batch = 0;   // last batch run, guarded by query_mutex
+
+        // contacts of the collected step, emitted once by physics_contact_system
+        std::vector<body_entity_t> body_entities;   // by body index
+        std::vector<contact_t>     contacts;
+        bool                       contacts_pending = false;
+    };
+
+    void context_deleter_t::operator()(context_t* ctx) const {
+        delete ctx;
+        jolt_release();
+    }
+
+    // cheap: the context is built on first use (see context()), so a world
+    // that calls configure() first never builds the default one
+    physics_world_t::physics_world_t() = default;
+
+    // ------------------------------------------------------------
+    //  step thread
+    // ------------------------------------------------------------
+    static void step_thread_main(context_t* ctx) {
+        std::unique_lock<std::mutex> lock(ctx->step_mutex);
+        for (;;) {
+            ctx->step_cv.wait(lock, [ctx] { return ctx->step_busy || ctx->step_quit; });
+            if (!ctx->step_busy) break;   // quit
+
+            const float dt = ctx->step_dt;
+            const int32_t steps = ctx->step_collision_steps;
+            lock.unlock();
+            ctx->run_step(dt, steps);
+            lock.lock();
+
+            ctx->step_busy = false;
+            ctx->step_cv.notify_all();
+        }
+    }
+
+    static void kick_step(context_t& ctx, float dt, int32_t collision_steps) {
+        if (!ctx.step_thread.joinable()) {
+            ctx.step_thread = std::thread(step_thread_main, &ctx);
+        }
+        {
+            std::lock_guard<std::mutex> lock(ctx.step_mutex);
+            ctx.step_dt = dt;
+            ctx.step_collision_steps = collision_steps;
+            ctx.step_busy = true;
+        }
+        ctx.step_cv.notify_all();
+        ctx.in_flight = true;
+        ctx.uncollected = true;
+    }
+
+    // the sync point: after this no Jolt code runs off the main thread
+    static void wait_step(context_t& ctx) {
+        if (!ctx.in_flight) return;
+        std::unique_lock<std::mutex> lock(ctx.step_mutex);
+        ctx.step_cv.wait(lock, [&ctx] { return !ctx.step_busy; });
+        ctx.in_flight = false;
+    }
+
+    // bodies, temp allocator, job system and step thread of the default
+    // config, only when something needs them before configure()
+    static context_t& context(physics_world_t& pw) {
+        if (!pw.ctx) {
+            jolt_acquire();
+            pw.ctx.reset(new context_t(physics_config_t{}));
+        }
+        return *pw.ctx;
+    }
+
+    static context_t& context(flecs::world& world) {
+        return context(world.get_mut<physics_world_t>());
+    }
+
+    const std::vector<contact_t>& contacts(flecs::world& world) {
+        return context(world).contacts;
+    }
+
+    void sync(flecs::world& world) {
+        wait_step(context(world));
+    }
+
+    JPH::PhysicsSystem& system(flecs::world& world) {
+        context_t& ctx = context(world);
+        wait_step(ctx);
+        return ctx.system;
+    }
+
+    JPH::BodyInterface& body_interface(flecs::world& world) {
+        return system(world).GetBodyInterface();
+    }
+
+    void add_pre_step_system(flecs::world& world, flecs::entity_t system) {
+        world.get_mut<physics_world_t>().pre_step_systems.push_back(system);
+    }
+
+    void add_system_holder(flecs::world& world, flecs::entity_t component) {
+        world.get_mut<physics_world_t>().system_holders.push_back(component);
+    }
+
+    void resync_after_restore(flecs::world& world) {
+        physics_world_t& pw = world.get_mut<physics_world_t>();
+        context_t& ctx = context(pw);
+        wait_step(ctx);
+
+        ctx.active.clear();
+        ctx.system.GetActiveBodies(JPH::EBodyType::RigidBody, ctx.active);
+        ctx.active_set.rebuild(ctx.active);
+        ctx.active.clear();
+
+        // poses and contacts of the step before the restore
+        ctx.uncollected = false;
+        ctx.poses.clear();
+        ctx.contact_listener.clear();
+        ctx.contacts.clear();
+        ctx.contacts_pending = false;
+        pw.stats.active = ctx.active_set.count();
+        pw.stats.slept = 0;
+        pw.stats.contacts = 0;
+    }
+
+    bool configure(flecs::world& world, const physics_config_t& config) {
+        physics_world_t& pw = world.get_mut<physics_world_t>();
+        if (pw.ctx) {
+            wait_step(*pw.ctx);
+            if (pw.ctx->system.GetNumBodies() > 0) {
+                TraceLog(LOG_WARNING, "PHYSICS: configure with %u bodies in the system, ignored",
+                         pw.ctx->system.GetNumBodies());
+                return false;
+            }
+        }
+        // characters and the like keep a pointer to the PhysicsSystem
+        for (flecs::entity_t holder : pw.system_holders) {
+            const int32_t n = world.count(holder);
+            if (n > 0) {
+                TraceLog(LOG_WARNING, "PHYSICS: configure with %d %s holding the system, ignored",
+                         n, world.entity(holder).name().c_str());
+                return false;
+            }
+        }
+        if (config.layers.layer_count == 0 || config.layers.broadphase_count == 0) {
+            TraceLog(LOG_WARNING, "PHYSICS: configure with an empty layer config, ignored");
+            return false;
+        }
+        if (config.max_bodies == 0 || config.max_bodies > JPH::BodyID::cMaxBodyIndex + 1
+            || config.temp_allocator_size == 0) {
+            TraceLog(LOG_WARNING, "PHYSICS: configure with %u bodies / %zu temp bytes, ignored",
+                     config.max_bodies, config.temp_allocator_size);
+            return false;
+        }
+        // the new context's reference is taken first, so the Jolt globals
+        // survive the old one being released
+        jolt_acquire();
+        pw.ctx.reset();
+        pw.ctx.reset(new context_t(config));
+        for (int32_t& n : pw.stats.layer_bodies) n = 0;
+        pw.stats.temp_high_water = 0;
+        pw.stats.temp_peak = 0;
+        pw.stats.temp_fallbacks = 0;
+        pw.stats.temp_fallbacks_total = 0;
+        return true;
+    }
+
+    bool set_layers(flecs::world& world, const layer_config_t& config) {
+        physics_config_t cfg = config_of(world);
+        cfg.layers = config;
+        return configure(world, cfg);
+    }
+
+    // no context yet: the defaults it would be built with, without building it
+    const physics_config_t& config_of(flecs::world& world) {
+        const physics_world_t& pw = world.get<physics_world_t>();
+        if (!pw.ctx) {
+            static const physics_config_t defaults{};
+            return defaults;
+        }
+        return pw.ctx->config;
+    }
+
+    const layer_config_t& layers_of(flecs::world& world) {
+        const physics_world_t& pw = world.get<physics_world_t>();
+        if (!pw.ctx) return config_of(world).layers;
+        return pw.ctx->layers.config();
+    }
+
+    void report_stats(flecs::world& world) {
+        physics_world_t& pw = world.get_mut<physics_world_t>();
+        context_t& ctx = context(pw);
+        wait_step(ctx);
+        const layer_config_t& cfg = ctx.layers.config();
+        const physics_stats_t& st = pw.stats;
+
+        TraceLog(LOG_INFO, "PHYSICS: %d bodies, %d awake, step %.2f ms, sync %.2f ms",
+                 st.bodies, st.active, st.step_ms, st.sync_ms);
+        TraceLog(LOG_INFO, "PHYSICS: capacity %u bodies, %u pairs, %u constraints, temp %.1f MB (step %.1f MB, peak %.1f MB)",
+                 ctx.config.max_bodies, ctx.config.max_body_pairs, ctx.config.max_contact_constraints,
+                 ctx.temp_allocator.size() / 1048576.0, st.temp_high_water / 1048576.0, st.temp_peak / 1048576.0);
+        const heap_stats_t heap = heap_stats();
+        TraceLog(LOG_INFO, "PHYSICS: temp fallbacks %d last step, %llu total; Jolt heap %.1f MB (peak %.1f MB) in %lld blocks",
+                 st.temp_fallbacks, (unsigned long long)st.temp_fallbacks_total, heap.bytes / 1048576.0,
+                 heap.peak / 1048576.0, (long long)heap.blocks);
+        for (int32_t i = 0; i < cfg.layer_count; i++) {
+            TraceLog(LOG_INFO, "PHYSICS:   layer %-12s bp %-12s bodies %d", cfg.layer_names[i].c_str(),
+                     cfg.broadphase_names[cfg.broadphase_of[i]].c_str(), st.layer_bodies[i]);
+        }
+#ifdef JPH_TRACK_BROADPHASE_STATS
+        ctx.system.ReportBroadphaseStats();
+#endif
+#ifdef JPH_TRACK_NARROWPHASE_STATS
+        JPH::NarrowPhaseStat::sReportStats();
+#endif
+    }
+
+    // ------------------------------------------------------------
+    //  bodies
+    // ------------------------------------------------------------
+    static void bind_entity(context_t& ctx, JPH::BodyID id, flecs::entity_t e) {
+        const JPH::uint32 i = id.GetIndex();
+        if (i >= ctx.body_entities.size()) ctx.body_entities.resize(i + 1);
+        ctx.body_entities[i] = { id, e };
+    }
+
+    static flecs::entity_t entity_of(const context_t& ctx, JPH::BodyID id) {
+        const JPH::uint32 i = id.GetIndex();
+        if (i >= ctx.body_entities.size() || ctx.body_entities[i].id != id) return 0;
+        return ctx.body_entities[i].entity;
+    }
+
+    JPH::BodyID add_body(flecs::world& world, flecs::entity e, JPH::BodyCreationSettings settings,
+                         JPH::EActivation activation)
+    {
+        // one body per entity: the old one goes, or it would stay in the
+        // simulation once set<RigidBody> overwrote its id
+        if (e.has<RigidBody>()) remove_body(e);
+
+        if (const Transform3D* t = e.try_get<Transform3D>()) {
+            settings.mPosition = JPH::RVec3(t->position.x, t->position.y, t->position.z);
+            settings.mRotation = JPH::Quat(t->rotation.x, t->rotation.y, t->rotation.z, t->rotation.w).Normalized();
+        }
+        settings.mUserData = (JPH::uint64)e.id();
+
+        JPH::BodyID id = body_interface(world).CreateAndAddBody(settings, activation);
+        if (id.IsInvalid()) {
+            TraceLog(LOG_WARNING, "PHYSICS: body limit reached, no body for entity %llu",
+                     (unsigned long long)e.id());
+            return id;
+        }
+
+        e.set<RigidBody>({ id });
+        bind_entity(context(world), id, e.id());
+        if (settings.mObjectLayer < layer_config_t::MAX_LAYERS) {
+            world.get_mut<physics_world_t>().stats.layer_bodies[settings.mObjectLayer]++;
+        }
+        if (settings.mMotionType == JPH::EMotionType::Kinematic) {
+            e.add<Kinematic>();
+        }
+        return id;
+    }
+
+    struct create_batch_t {
+        JPH::BodyInterface*              bi;
+        const JPH::BodyCreationSettings* settings;
+        bool                             shared;
+        const flecs::entity_t*           entities;
+        const pose_t*                    poses;       // entity 0 = no Transform3D
+        JPH::BodyID*                     ids;
+    };
+
+    static void create_bodies(void* ctx, int32_t begin, int32_t end) {
+        create_batch_t& b = *(create_batch_t*)ctx;
+        for (int32_t i = begin; i < end; i++) {
+            JPH::BodyCreationSettings settings = b.settings[b.shared ? 0 : i];
+            const pose_t& pose = b.poses[i];
+            if (pose.entity != 0) {
+                settings.mPosition = JPH::RVec3(pose.position.x, pose.position.y, pose.position.z);
+                settings.mRotation = JPH::Quat(pose.rotation.x, pose.rotation.y, pose.rotation.z, pose.rotation.w).Normalized();
+            }
+            settings.mUserData = (JPH::uint64)b.entities[i];
+
+            // The settings only hold built shapes (see resolve_shapes), so
+            // CreateBody reads them and builds mass properties, no shared writes.
+            if (settings.GetShape() == nullptr) {
+                b.ids[i] = JPH::BodyID();
+                continue;
+            }
+            JPH::Body* body = b.bi->CreateBody(settings);
+            b.ids[i] = body != nullptr ? body->GetID() : JPH::BodyID();
+        }
+    }
+
+    // GetShape() on settings that hold a ShapeSettings calls its Create(),
+    // which writes the settings' cached result unguarded. Copies of one
+    // template share that ShapeSettings, so the workers would race on it.
+    // Every entry is converted here, on the calling thread, and the copies
+    // handed to the workers hold only the built shape. Returns null when
+    // nothing needed converting (use the caller's array as is).
+    static const JPH::BodyCreationSettings* resolve_shapes(const add_bodies_desc_t& desc,
+                                                           std::vector<JPH::BodyCreationSettings>& resolved)
+    {
+        const int32_t n = desc.shared_settings ? 1 : desc.count;
+        bool convert = false;
+        for (int32_t i = 0; i < n && !convert; i++) {
+            convert = desc.settings[i].GetShapeSettings() != nullptr;
+        }
+        if (!convert) return nullptr;
+
+        resolved.assign(desc.settings, desc.settings + n);
+        for (JPH::BodyCreationSettings& settings : resolved) {
+            if (settings.GetShapeSettings() == nullptr) continue;
+            const JPH::Shape::ShapeResult result = settings.ConvertShapeSettings();
+            if (result.HasError()) {
+                TraceLog(LOG_WARNING, "PHYSICS: add_bodies shape: %s", result.GetError().c_str());
+            }
+        }
+        return resolved.data();
+    }
+
+    int32_t add_bodies(flecs::world& world, const add_bodies_desc_t& desc, JPH::BodyID* out)
+    {
+        if (desc.count <= 0) return 0;
+        physics_world_t& pw = world.get_mut<physics_world_t>();
+        context_t& ctx = context(pw);
+        wait_step(ctx);
+        JPH::BodyInterface& bi = ctx.system.GetBodyInterface();
+
+        // replaced like in add_body, before any pose is read
+        for (int32_t i = 0; i < desc.count; i++) {
+            flecs::entity e = world.entity(desc.entities[i]);
+            if (e.has<RigidBody>()) remove_body(e);
+        }
+
+        std::vector<JPH::BodyCreationSettings> resolved;
+        const JPH::BodyCreationSettings* settings_array = resolve_shapes(desc, resolved);
+        if (!settings_array) settings_array = desc.settings;
+
+        // Transform3D is read here, the workers only touch Jolt
+        std::vector<pose_t> poses(desc.count);
+        for (int32_t i = 0; i < desc.count; i++) {
+            const Transform3D* t = world.entity(desc.entities[i]).try_get<Transform3D>();
+            poses[i] = t ? pose_t{ desc.entities[i], t->position, t->rotation } : pose_t{ 0, {}, {} };
+        }
+
+        std::vector<JPH::BodyID> ids(desc.count);
+        create_batch_t batch{ &bi, settings_array, desc.shared_settings, desc.entities, poses.data(), ids.data() };
+        jobs::parallel_for(jobs::shared(), desc.count, 256, create_bodies, &batch, jobs::priority_t::physics);
+
+        // one broadphase batch; Prepare may reorder its array, so it gets a copy
+        JPH::BodyIDVector added;
+        added.reserve(desc.count);
+        for (const JPH::BodyID& id : ids) {
+            if (!id.IsInvalid()) added.push_back(id);
+        }
+        if (!added.empty()) {
+            JPH::BodyInterface::AddState state = bi.AddBodiesPrepare(added.data(), (int)added.size());
+            bi.AddBodiesFinalize(added.data(), (int)added.size(), state, desc.activation);
+            ctx.optimize_broadphase = true;
+        }
+        if ((int32_t)added.size() < desc.count) {
+            TraceLog(LOG_WARNING, "PHYSICS: body limit reached or no shape, %d of %d bodies added",
+                     (int32_t)added.size(), desc.count);
+        }
+
+        for (int32_t i = 0; i < desc.count; i++) {
+            if (out) out[i] = ids[i];
+            if (ids[i].IsInvalid()) continue;
+            const JPH::BodyCreationSettings& settings = settings_array[desc.shared_settings ? 0 : i];
+            flecs::entity e = world.entity(desc.entities[i]);
+            e.set<RigidBody>({ ids[i] });
+            bind_entity(ctx, ids[i], e.id());
+            if (settings.mObjectLayer < layer_config_t::MAX_LAYERS) {
+                pw.stats.layer_bodies[settings.mObjectLayer]++;
+            }
+            if (settings.mMotionType == JPH::EMotionType::Kinematic) {
+                e.add<Kinematic>();
+            }
+        }
+        return (int32_t)added.size();
+    }
+
+    void remove_body(flecs::entity e) {
+        e.remove<RigidBody>();
+        e.remove<Kinematic>();
+    }
+
+    // ------------------------------------------------------------
+    //  commands
+    // ------------------------------------------------------------
+    void push_command(flecs::world& world, const command_t& cmd) {
+        context_t& ctx = context(world);
+        std::lock_guard<std::mutex> lock(ctx.command_mutex);
+        ctx.commands.push_back(cmd);
+    }
+
+    static void push_entity_command(flecs::entity e, command_type_t type, Vector3 value,
+                                    Quaternion rotation = { 0, 0, 0, 1 })
+    {
+        const RigidBody* rb = e.try_get<RigidBody>();
+        if (rb == nullptr) return;
+        flecs::world world = e.world();
+        push_command(world, { type, rb->id, value, rotation });
+    }
+
+    void set_pose(flecs::entity e, Vector3 position, Quaternion rotation) {
+        push_entity_command(e, command_type_t::set_pose, position, rotation);
+    }
+
+    void set_linear_velocity(flecs::entity e, Vector3 velocity) {
+        push_entity_command(e, command_type_t::set_linear_velocity, velocity);
+    }
+
+    void set_angular_velocity(flecs::entity e, Vector3 velocity) {
+        push_entity_command(e, command_type_t::set_angular_velocity, velocity);
+    }
+
+    void add_force(flecs::entity e, Vector3 force) {
+        push_entity_command(e, command_type_t::add_force, force);
+    }
+
+    void add_impulse(flecs::entity e, Vector3 impulse) {
+        push_entity_command(e, command_type_t::add_impulse, impulse);
+    }
+
+    static void apply_commands(context_t& ctx) {
+        {
+            std::lock_guard<std::mutex> lock(ctx.command_mutex);
+            ctx.applying.swap(ctx.commands);
+        }
+        JPH::BodyInterface& bi = ctx.system.GetBodyInterfaceNoLock();   // step not running
+        for (const command_t& c : ctx.applying) {
+            if (!bi.IsAdded(c.id)) continue;   // removed since it was queued
+            const JPH::Vec3 v(c.value.x, c.value.y, c.value.z);
+            switch (c.type) {
+            case command_type_t::set_pose:
+                bi.SetPositionAndRotation(c.id, JPH::RVec3(v),
+                                          JPH::Quat(c.rotation.x, c.rotation.y, c.rotation.z, c.rotation.w).Normalized(),
+                                          JPH::EActivation::Activate);
+                break;
+            case command_type_t::set_linear_velocity:  bi.SetLinearVelocity(c.id, v); break;
+            case command_type_t::set_angular_velocity: bi.SetAngularVelocity(c.id, v); break;
+            case command_type_t::add_force:            bi.AddForce(c.id, v); break;
+            case command_type_t::add_impulse:          bi.AddImpulse(c.id, v); break;
+            case command_type_t::activate:             bi.ActivateBody(c.id); break;
+            case command_type_t::deactivate:           bi.DeactivateBody(c.id); break;
+            }
+        }
+        ctx.applying.clear();
+    }
+
+    // ------------------------------------------------------------
+    //  queries
+    // ------------------------------------------------------------
+    static query_id_t push_query(flecs::world& world, const query_t& q) {
+        context_t& ctx = context(world);
+        std::lock_guard<std::mutex> lock(ctx.query_mutex);
+        ctx.queries.push_back(q);
+        return { ctx.query_batch + 1, (int32_t)ctx.queries.size() - 1 };
+    }
+
+    query_id_t cast_ray(flecs::world& world, const ray_query_t& query) {
+        return push_query(world, { nullptr, query.origin, { 0, 0, 0, 1 }, query.direction,
+                                   query.layer, query.ignore, query.user });
+    }
+
+    query_id_t cast_shape(flecs::world& world, const shape_query_t& query) {
+        if (query.shape == nullptr) {
+            TraceLog(LOG_WARNING, "PHYSICS: cast_shape without a shape, ignored");
+            return {};
+        }
+        return push_query(world, { query.shape, query.position, query.rotation, query.direction,
+                                   query.layer, query.ignore, query.user });
+    }
+
+    const query_hit_t* query_result(flecs::world& world, query_id_t id) {
+        const context_t& ctx = context(world);
+        if (id.batch == 0 || id.batch != ctx.query_batch) return nullptr;
+        if (id.index < 0 || id.index >= (int32_t)ctx.query_hits.size()) return nullptr;
+        return &ctx.query_hits[id.index];
+    }
+
+    // One chunk of the batch, on a worker or the main thread. The step is
+    // not running and the main thread waits for the batch, so the NoLock
+    // query and lock interfaces are safe.
+    static void run_queries(void* arg, int32_t begin, int32_t end) {
+        context_t& ctx = *(context_t*)arg;
+        const JPH::NarrowPhaseQuery& query = ctx.system.GetNarrowPhaseQueryNoLock();
+        const JPH::BodyLockInterface& locks = ctx.system.GetBodyLockInterfaceNoLock();
+
+        for (int32_t i = begin; i < end; i++) {
+            const query_t& q = ctx.running[i];
+            query_hit_t& hit = ctx.query_hits[i];
+            hit = {};
+            hit.user = q.user;
+
+            const JPH::DefaultBroadPhaseLayerFilter broadphase_filter = ctx.system.GetDefaultBroadPhaseLayerFilter(q.layer);
+            const JPH::DefaultObjectLayerFilter layer_filter = ctx.system.GetDefaultLayerFilter(q.layer);
+            const JPH::IgnoreSingleBodyFilter body_filter(q.ignore);
+            const JPH::RVec3 origin(q.origin.x, q.origin.y, q.origin.z);
+            const JPH::Vec3 direction(q.direction.x, q.direction.y, q.direction.z);
+
+            JPH::RVec3 point;
+            JPH::Vec3 normal = JPH::Vec3::sZero();
+            if (q.shape == nullptr) {
+                const JPH::RRayCast ray(origin, direction);
+                JPH::RayCastResult result;
+                if (!query.CastRay(ray, result, broadphase_filter, layer_filter, body_filter)) continue;
+                hit.body = result.mBodyID;
+                hit.fraction = result.mFraction;
+                point = ray.GetPointOnRay(result.mFraction);
+                JPH::BodyLockRead lock(locks, result.mBodyID);
+                if (lock.Succeeded()) normal = lock.GetBody().GetWorldSpaceSurfaceNormal(result.mSubShapeID2, point);
+            } else {
+                const JPH::Quat rotation(q.rotation.x, q.rotation.y, q.rotation.z, q.rotation.w);
+                const JPH::RShapeCast cast = JPH::RShapeCast::sFromWorldTransform(
+                    q.shape, JPH::Vec3::sReplicate(1.0f), JPH::RMat44::sRotationTranslation(rotation.Normalized(), origin),
+                    direction);
+                JPH::ShapeCastSettings settings;
+                JPH::ClosestHitCollisionCollector<JPH::CastShapeCollector> collector;
+                query.CastShape(cast, settings, JPH::RVec3::sZero(), collector, broadphase_filter, layer_filter, body_filter);
+                if (!collector.HadHit()) continue;
+                const JPH::ShapeCastResult& result = collector.mHit;
+                hit.body = result.mBodyID2;
+                hit.fraction = result.mFraction;
+                point = JPH::RVec3(result.mContactPointOn2);   // relative to the zero base offset
+                // penetration axis points into the hit body
+                if (result.mPenetrationAxis.LengthSq() > 0.0f) normal = -result.mPenetrationAxis.Normalized();
+            }
+
+            hit.hit = true;
+            hit.entity = entity_of(ctx, hit.body);
+            hit.point = { (float)point.GetX(), (float)point.GetY(), (float)point.GetZ() };
+            hit.normal = { normal.GetX(), normal.GetY(), normal.GetZ() };
+        }
+    }
+
+    // ------------------------------------------------------------
+    //  sync
+    // ------------------------------------------------------------
+    // Read the poses of the step that just finished. Main thread, step not
+    // running.
+    static void collect_poses(context_t& ctx, physics_stats_t& stats) {
+        const auto start = std::chrono::steady_clock::now();
+
+        if (ctx.step_error != JPH::EPhysicsUpdateError::None) {
+            TraceLog(LOG_WARNING, "PHYSICS: update error 0x%x", (unsigned)ctx.step_error);
+        }
+        stats.step_ms = ctx.step_ms;
+        stats.temp_high_water = ctx.temp_allocator.high_water();
+        stats.temp_peak = std::max(stats.temp_peak, stats.temp_high_water);
+        stats.temp_fallbacks = ctx.temp_allocator.fallbacks();
+        stats.temp_fallbacks_total += stats.temp_fallbacks;
+        if (stats.temp_fallbacks > 0 && stats.temp_fallbacks_total == (uint64_t)stats.temp_fallbacks) {
+            TraceLog(LOG_WARNING, "PHYSICS: temp allocator of %zu bytes too small (step needed %zu), using the heap",
+                     ctx.temp_allocator.size(), stats.temp_high_water);
+        }
+        ctx.uncollected = false;
+
+        // only awake bodies (and the ones that just fell asleep), the
+        // sleeping majority is never looked at
+        ctx.active.clear();
+        const int32_t slept = ctx.active_set.collect(ctx.active);
+        ctx.poses.clear();
+        ctx.poses.reserve(ctx.active.size());
+
+        // one multi-lock for the whole set instead of a lock per interface call
+        {
+            JPH::BodyLockMultiRead lock(ctx.system.GetBodyLockInterface(),
+                                        ctx.active.data(), (int)ctx.active.size());
+            for (int i = 0; i < (int)ctx.active.size(); i++) {
+                const JPH::Body* body = lock.GetBody(i);
+                if (body == nullptr || body->IsKinematic()) continue;
+
+                const JPH::RVec3 p = body->GetPosition();
+                const JPH::Quat q = body->GetRotation();
+                ctx.poses.push_back({
+                    (flecs::entity_t)body->GetUserData(),
+                    { (float)p.GetX(), (float)p.GetY(), (float)p.GetZ() },
+                    { q.GetX(), q.GetY(), q.GetZ(), q.GetW() }
+                });
+            }
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+        stats.active = ctx.active_set.count();
+        stats.slept = slept;
+        stats.sync_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // Merge the per-thread contact buffers of the step that just finished.
+    // Worker order is not deterministic, so the records are sorted by body
+    // pair; sub-shape records of one pair and state are folded into one.
+    // Main thread, step not running.
+    static void collect_contacts(context_t& ctx, physics_stats_t& stats) {
+        if (!ctx.contacts_pending) ctx.contacts.clear();   // else not emitted yet, keep
+        ctx.contact_listener.merge(ctx.contacts);
+
+        std::sort(ctx.contacts.begin(), ctx.contacts.end(), [](const contact_t& x, const contact_t& y) {
+            const JPH::uint32 xa = x.body_a.GetIndexAndSequenceNumber(), ya = y.body_a.GetIndexAndSequenceNumber();
+            if (xa != ya) return xa < ya;
+            const JPH::uint32 xb = x.body_b.GetIndexAndSequenceNumber(), yb = y.body_b.GetIndexAndSequenceNumber();
+            if (xb != yb) return xb < yb;
+            return x.state < y.state;
+        });
+
+        size_t n = 0;
+        for (size_t i = 0; i < ctx.contacts.size(); i++) {
+            const contact_t& c = ctx.contacts[i];
+            if (n > 0) {
+                contact_t& last = ctx.contacts[n - 1];
+                if (last.body_a == c.body_a && last.body_b == c.body_b && last.state == c.state) {
+                    last.impulse = std::max(last.impulse, c.impulse);
+                    continue;
+                }
+            }
+            ctx.contacts[n] = c;
+            ctx.contacts[n].a = entity_of(ctx, c.body_a);
+            ctx.contacts[n].b = entity_of(ctx, c.body_b);
+            n++;
+        }
+        ctx.contacts.resize(n);
+        ctx.contacts_pending = n > 0;
+        stats.contacts = (int32_t)n;
+    }
+
+    // ------------------------------------------------------------
+    //  systems
+    // ------------------------------------------------------------
+    // Start of the tick: finish the step in flight, take its poses and apply
+    // the queued writes.
+    static void physics_begin_system(flecs::iter& it) {
+        flecs::world world = it.world();
+        physics_world_t& pw = world.get_mut<physics_world_t>();
+        context_t& ctx = context(pw);
+
+        const auto start = std::chrono::steady_clock::now();
+        wait_step(ctx);
+        const auto end = std::chrono::steady_clock::now();
+        pw.stats.wait_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        if (ctx.uncollected) {
+            collect_poses(ctx, pw.stats);
+            collect_contacts(ctx, pw.stats);
+        }
+        apply_commands(ctx);
+    }
+
+    // Run the casts submitted since the last batch. An empty batch keeps
+    // the results of the one before.
+    static void physics_query_system(flecs::iter& it) {
+        flecs::world world = it.world();
+        physics_world_t& pw = world.get_mut<physics_world_t>();
+        context_t& ctx = context(pw);
+
+        {
+            std::lock_guard<std::mutex> lock(ctx.query_mutex);
+            if (ctx.queries.empty()) {
+                pw.stats.queries = 0;
+                pw.stats.query_hits = 0;
+                pw.stats.query_ms = 0.0;
+                return;
+            }
+            ctx.running.swap(ctx.queries);
+            ctx.query_batch++;   // new submissions belong to the batch after this one
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const int32_t count = (int32_t)ctx.running.size();
+        ctx.query_hits.resize(count);
+        jobs::parallel_for(jobs::shared(), count, 32, run_queries, &ctx, jobs::priority_t::physics);
+        ctx.running.clear();
+        const auto end = std::chrono::steady_clock::now();
+
+        int32_t hits = 0;
+        for (const query_hit_t& h : ctx.query_hits) hits += h.hit ? 1 : 0;
+        pw.stats.queries = count;
+        pw.stats.query_hits = hits;
+        pw.stats.query_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    static void physics_kinematic_system(flecs::iter& it) {
+        flecs::world world = it.world();
+        physics_world_t& pw = world.get_mut<physics_world_t>();
+        JPH::BodyInterface& bi = context(pw).system.GetBodyInterfaceNoLock();   // step not running
+        const float dt = it.delta_time();
+
+        int32_t count = 0;
+        while (it.next()) {
+            auto rb = it.field<const RigidBody>(0);
+            auto t = it.field<const Transform3D>(1);
+            for (auto i : it) {
+                const Transform3D& tr = t[i];
+                bi.MoveKinematic(rb[i].id,
+                                 JPH::RVec3(tr.position.x, tr.position.y, tr.position.z),
+                                 JPH::Quat(tr.rotation.x, tr.rotation.y, tr.rotation.z, tr.rotation.w).Normalized(),
+                                 dt);
+            }
+            count += (int32_t)it.count();
+        }
+        pw.stats.kinematic = count;
+    }
+
+    static void physics_step_system(flecs::iter& it) {
+        flecs::world world = it.world();
+        physics_world_t& pw = world.get_mut<physics_world_t>();
+        context_t& ctx = context(pw);
+
+        for (flecs::entity_t s : pw.pre_step_systems) {
+            if (ecs_is_alive(world, s)) ecs_run(world, s, it.delta_time(), nullptr);
+        }
+        pw.stats.bodies = (int32_t)ctx.system.GetNumBodies();
+        ctx.contact_listener.persisted = pw.persisted_contacts;
+        if (pw.threaded) {
+            // overlaps the rest of the frame, collected by the next tick
+            kick_step(ctx, it.delta_time(), pw.collision_steps);
+            return;
+        }
+        ctx.run_step(it.delta_time(), pw.collision_steps);
+        collect_poses(ctx, pw.stats);
+        collect_contacts(ctx, pw.stats);
+    }
+
+    // Write the collected poses to Transform3D in one pass.
+    static void physics_sync_system(flecs::iter& it) {
+        flecs::world world = it.world();
+        physics_world_t& pw = world.get_mut<physics_world_t>();
+        context_t& ctx = context(pw);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        const flecs::entity_t transform_id = world.id<Transform3D>();
+        int32_t synced = 0;
+        for (const pose_t& pose : ctx.poses) {
+            if (!ecs_is_alive(world, pose.entity)) continue;
+            Transform3D* t = (Transform3D*)ecs_get_mut_id(world, pose.entity, transform_id);
+            if (t == nullptr) continue;
+            t->position = pose.position;
+            t->rotation = pose.rotation;
+            t->isDirty = true;
+            synced++;
+        }
+        ctx.poses.clear();
+
+        const auto end = std::chrono::steady_clock::now();
+        pw.stats.synced = synced;
+        pw.stats.sync_ms += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // Emit the collected contacts to observers on both entities of each pair,
+    // once. Persisted contacts are left to the contacts() table.
+    static void physics_contact_system(flecs::iter& it) {
+        flecs::world world = it.world();
+        context_t& ctx = context(world);
+        if (!ctx.contacts_pending) return;
+        ctx.contacts_pending = false;
+
+        const flecs::entity_t added = world.id<contact_added_t>();
+        const flecs::entity_t removed = world.id<contact_removed_t>();
+        ecs_id_t any = flecs::Any;
+        ecs_type_t ids = { &any, 1 };
+
+        auto emit = [&](flecs::entity_t event, flecs::entity_t target, const void* payload) {
+            if (target == 0 || !ecs_is_alive(world, target)) return;
+            ecs_event_desc_t desc = {};
+            desc.event = event;
+            desc.ids = &ids;
+            desc.entity = target;
+            desc.const_param = payload;
+            ecs_emit(world, &desc);
+        };
+
+        for (const contact_t& c : ctx.contacts) {
+            if (c.state == contact_state_t::added) {
+                const contact_added_t on_a{ c.b, c.point, c.normal, c.impulse };
+                const contact_added_t on_b{ c.a, c.point, { -c.normal.x, -c.normal.y, -c.normal.z }, c.impulse };
+                emit(added, c.a, &on_a);
+                emit(added, c.b, &on_b);
+            } else if (c.state == contact_state_t::removed) {
+                const contact_removed_t on_a{ c.b };
+                const contact_removed_t on_b{ c.a };
+                emit(removed, c.a, &on_a);
+                emit(removed, c.b, &on_b);
+            }
+        }
+    }
+
+    // ------------------------------------------------------------
+    //  module
+    // ------------------------------------------------------------
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.import<fixed_step::module>();
+        world.import<transform_3d::module>();
+
+        world.component<RigidBody>();
+        world.component<Kinematic>();
+        world.component<contact_added_t>();
+        world.component<contact_removed_t>();
+        world.component<physics_world_t>().add(flecs::Singleton);
+        world.add<physics_world_t>();
+
+        // destroy the body with the component / entity (cell unloads included)
+        world.observer<const RigidBody>("physics_body_remove_observer")
+            .event(flecs::OnRemove)
+            .each([](flecs::entity e, const RigidBody& rb) {
+                flecs::world world = e.world();
+                physics_world_t* pw = world.try_get_mut<physics_world_t>();
+                if (pw == nullptr || !pw->ctx || rb.id.IsInvalid()) return;   // world shutting down
+                wait_step(*pw->ctx);
+                JPH::BodyInterface& bi = pw->ctx->system.GetBodyInterface();
+                const JPH::ObjectLayer layer = bi.GetObjectLayer(rb.id);
+                if (layer < layer_config_t::MAX_LAYERS) pw->stats.layer_bodies[layer]--;
+                if (bi.IsAdded(rb.id)) bi.RemoveBody(rb.id);
+                bi.DestroyBody(rb.id);
+            });
+
+        // created before user systems, so they run first in RLFixedPostUpdate
+        world.system("physics_begin_system")
+            .kind<fixed_step::RLFixedPostUpdate>()
+            .run(physics_begin_system);
+
+        world.system("physics_query_system")
+            .kind<fixed_step::RLFixedPostUpdate>()
+            .run(physics_query_system);
+
+        world.system<const RigidBody, const Transform3D>("physics_kinematic_system")
+            .with<Kinematic>()
+            .kind<fixed_step::RLFixedPostUpdate>()
+            .run(physics_kinematic_system);
+
+        world.system("physics_step_system")
+            .kind<fixed_step::RLFixedPostUpdate>()
+            .run(physics_step_system);
+
+        world.system("physics_sync_system")
+            .kind<fixed_step::RLFixedPostUpdate>()
+            .run(physics_sync_system);
+
+        world.system("physics_contact_system")
+            .kind<fixed_step::RLFixedPostUpdate>()
+            .run(physics_contact_system);
+    }
+}
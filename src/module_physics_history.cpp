@@ -0,0 +1,236 @@
+#include "module_physics_history.hpp"
+#include "module_fixed_step.hpp"
+#include "delta_codec.hpp"
+
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/StateRecorder.h>
+#include <Jolt/Physics/Body/Body.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+JPH_SUPPRESS_WARNINGS
+
+namespace physics_history {
+
+    // static bodies never move, keep them out of every snapshot
+    class skip_static_t final : public JPH::StateRecorderFilter {
+    public:
+        bool ShouldSaveBody(const JPH::Body& body) const override { return !body.IsStatic(); }
+    };
+
+    static const skip_static_t g_skip_static;
+
+    // ------------------------------------------------------------
+    //  buffer
+    // ------------------------------------------------------------
+    // StateRecorder straight into a byte vector, no stringstream. Jolt's
+    // streams are not copyable, so it lives on the stack and borrows the
+    // history's scratch vector.
+    class buffer_t final : public JPH::StateRecorder {
+    public:
+        explicit buffer_t(std::vector<uint8_t>& bytes) : bytes_(bytes) {}
+
+        void WriteBytes(const void* data, size_t size) override {
+            const uint8_t* p = (const uint8_t*)data;
+            bytes_.insert(bytes_.end(), p, p + size);
+        }
+
+        void ReadBytes(void* data, size_t size) override {
+            if (read_ + size > bytes_.size()) {
+                memset(data, 0, size);
+                failed_ = true;
+                return;
+            }
+            memcpy(data, bytes_.data() + read_, size);
+            read_ += size;
+        }
+
+        bool IsEOF() const override { return read_ >= bytes_.size(); }
+        bool IsFailed() const override { return failed_; }
+
+    private:
+        std::vector<uint8_t>& bytes_;
+        size_t read_ = 0;
+        bool   failed_ = false;
+    };
+
+    // ------------------------------------------------------------
+    //  history
+    // ------------------------------------------------------------
+    history_t::history_t(int32_t capacity, int32_t keyframe_interval)
+        : capacity_(std::max(1, capacity))
+        , keyframe_interval_(std::max(1, keyframe_interval))
+    {
+    }
+
+    void history_t::record(uint64_t tick, JPH::PhysicsSystem& system) {
+        const auto start = std::chrono::steady_clock::now();
+
+        if (!entries_.empty() && entries_.back().tick >= tick) {
+            while (!entries_.empty() && entries_.back().tick >= tick) {
+                stats_.bytes -= entries_.back().data.size();
+                stats_.full_bytes -= entries_.back().size;
+                if (entries_.back().keyframe) stats_.keyframes--;
+                entries_.pop_back();
+            }
+            force_keyframe_ = true;   // last_ is not the new back any more
+        }
+
+        scratch_.clear();
+        buffer_t buffer(scratch_);
+        system.SaveState(buffer, JPH::EStateRecorderState::All, &g_skip_static);
+        const size_t size = scratch_.size();
+
+        entry_t entry;
+        entry.tick = tick;
+        entry.size = (uint32_t)size;
+        entry.keyframe = force_keyframe_ || entries_.empty() || size != last_.size()
+                      || since_keyframe_ >= keyframe_interval_;
+        if (entry.keyframe) {
+            entry.data = scratch_;
+            since_keyframe_ = 0;
+            force_keyframe_ = false;
+            stats_.keyframes++;
+        } else {
+            delta::encode(last_.data(), scratch_.data(), size, entry.data);
+            since_keyframe_++;
+        }
+        last_.swap(scratch_);
+
+        stats_.bytes += entry.data.size();
+        stats_.full_bytes += size;
+        entries_.push_back(std::move(entry));
+        while ((int32_t)entries_.size() > capacity_) drop_front();
+
+        const auto end = std::chrono::steady_clock::now();
+        stats_.ticks = (int32_t)entries_.size();
+        stats_.last_size = size;
+        stats_.save_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // The front stays a keyframe: a delta behind it is folded into a copy
+    // of the keyframe being dropped.
+    void history_t::drop_front() {
+        entry_t front = std::move(entries_.front());
+        entries_.pop_front();
+        stats_.bytes -= front.data.size();
+        stats_.full_bytes -= front.size;
+        stats_.keyframes--;
+
+        if (entries_.empty() || entries_.front().keyframe) return;
+        entry_t& next = entries_.front();
+        stats_.bytes -= next.data.size();
+        delta::apply(next.data.data(), next.data.size(), front.data.data(), front.data.size());
+        next.data = std::move(front.data);
+        next.keyframe = true;
+        stats_.bytes += next.data.size();
+        stats_.keyframes++;
+    }
+
+    ptrdiff_t history_t::find(uint64_t tick) const {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), tick,
+                                   [](const entry_t& e, uint64_t t) { return e.tick < t; });
+        if (it == entries_.end() || it->tick != tick) return -1;
+        return it - entries_.begin();
+    }
+
+    bool history_t::contains(uint64_t tick) const {
+        return find(tick) >= 0;
+    }
+
+    bool history_t::restore(uint64_t tick, JPH::PhysicsSystem& system) {
+        const ptrdiff_t index = find(tick);
+        if (index < 0) return false;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        ptrdiff_t k = index;
+        while (!entries_[k].keyframe) k--;
+        scratch_ = entries_[k].data;
+        for (ptrdiff_t i = k + 1; i <= index; i++) {
+            const entry_t& e = entries_[i];
+            if (!delta::apply(e.data.data(), e.data.size(), scratch_.data(), scratch_.size())) {
+                TraceLog(LOG_WARNING, "PHYSICS: snapshot of tick %llu is corrupt", (unsigned long long)e.tick);
+                return false;
+            }
+        }
+
+        buffer_t buffer(scratch_);
+        const bool ok = system.RestoreState(buffer);
+        force_keyframe_ = true;
+
+        const auto end = std::chrono::steady_clock::now();
+        stats_.restore_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        return ok;
+    }
+
+    void history_t::clear() {
+        entries_.clear();
+        last_.clear();
+        since_keyframe_ = 0;
+        force_keyframe_ = true;
+        stats_ = {};
+    }
+
+    void history_t::set_capacity(int32_t capacity) {
+        capacity_ = std::max(1, capacity);
+        while ((int32_t)entries_.size() > capacity_) drop_front();
+        stats_.ticks = (int32_t)entries_.size();
+    }
+
+    // ------------------------------------------------------------
+    //  world
+    // ------------------------------------------------------------
+    bool restore(flecs::world& world, uint64_t tick) {
+        history_t& h = world.get_mut<history_t>();
+        JPH::PhysicsSystem& system = physics::system(world);   // waits for a running step
+        if (!h.restore(tick, system)) {
+            TraceLog(LOG_WARNING, "PHYSICS: tick %llu not in the history (%llu..%llu)",
+                     (unsigned long long)tick, (unsigned long long)h.first_tick(),
+                     (unsigned long long)h.last_tick());
+            return false;
+        }
+        physics::resync_after_restore(world);
+
+        // every body may have jumped, not only the awake ones
+        const JPH::BodyInterface& bi = system.GetBodyInterfaceNoLock();
+        world.each([&bi](const physics::RigidBody& rb, Transform3D& t) {
+            if (rb.id.IsInvalid()) return;
+            JPH::RVec3 p;
+            JPH::Quat q;
+            bi.GetPositionAndRotation(rb.id, p, q);
+            t.position = { (float)p.GetX(), (float)p.GetY(), (float)p.GetZ() };
+            t.rotation = { q.GetX(), q.GetY(), q.GetZ(), q.GetW() };
+            t.isDirty = true;
+        });
+
+        world.get_mut<fixed_step::fixed_time_t>().tick = tick;
+        return true;
+    }
+
+    // ------------------------------------------------------------
+    //  module
+    // ------------------------------------------------------------
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.import<fixed_step::module>();
+        world.import<physics::module>();
+
+        world.component<history_t>().add(flecs::Singleton);
+        world.add<history_t>();
+
+        // created before user systems, so it runs first in RLFixedPreUpdate
+        world.system("physics_history_record_system")
+            .kind<fixed_step::RLFixedPreUpdate>()
+            .run([](flecs::iter& it) {
+                flecs::world world = it.world();
+                history_t& h = world.get_mut<history_t>();
+                if (!h.recording) return;
+                const uint64_t tick = world.get<fixed_step::fixed_time_t>().tick;
+                h.record(tick, physics::system(world));
+            });
+    }
+}
@@ -1,2 +1,96 @@
 #include "module_raylib.hpp"
+#include "module_frame_arena.hpp"
+#include "rlImGui.h"
+#include <memory>
 
+namespace raylib {
+
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.import<phases>();
+        world.import<frame_arena::module>();
+
+        world.component<main_context_t>().add(flecs::Singleton);
+        world.component<render_config_t>().add(flecs::Singleton);
+        world.set<render_config_t>({});
+
+        // ------------------------------------------------------------
+        //  begin/end systems
+        // ------------------------------------------------------------
+        // Singletons are looked up once here; a flecs::ref only re-resolves
+        // when the owning table changes, which is far cheaper than a
+        // has() + get() pair every frame.
+        flecs::ref<main_context_t> ctx_ref = world.get_ref<main_context_t>();
+        flecs::ref<render_config_t> cfg_ref = world.get_ref<render_config_t>();
+
+        // shared between the begin/end pairs so they always match up
+        struct frame_state_t {
+            bool mode_3d = false;
+            bool imgui = false;
+        };
+        auto state = std::make_shared<frame_state_t>();
+
+        world.system("begin_drawing_system")
+            .kind<RLBeginDrawing>()
+            .run([](flecs::iter&) {
+                BeginDrawing();
+            });
+
+        world.system("render_2d_background_color_system")
+            .kind<RLStartRender>()
+            .run([cfg_ref](flecs::iter&) mutable {
+                const render_config_t* cfg = cfg_ref.try_get();
+                ClearBackground(cfg ? cfg->clear_color : RAYWHITE);
+            });
+
+        world.system("begin_camera_mode_3d_system")
+            .kind<RLBeginModeCamera3D>()
+            .run([ctx_ref, state](flecs::iter&) mutable {
+                const main_context_t* ctx = ctx_ref.try_get();
+                state->mode_3d = ctx != nullptr;
+                if (ctx) {
+                    BeginMode3D(ctx->camera);
+                }
+            });
+
+        world.system("end_camera_mode_3d_system")
+            .kind<RLEndMode3D>()
+            .run([state](flecs::iter&) {
+                if (state->mode_3d) {
+                    EndMode3D();
+                    state->mode_3d = false;
+                }
+            });
+
+        world.system("imgui_begin_system")
+            .kind<RLImguiBegin>()
+            .run([cfg_ref, state](flecs::iter&) mutable {
+                const render_config_t* cfg = cfg_ref.try_get();
+                state->imgui = cfg && cfg->imgui;
+                if (state->imgui) {
+                    rlImGuiBegin();
+                }
+            });
+
+        world.system("imgui_end_system")
+            .kind<RLImguiEnd>()
+            .run([state](flecs::iter&) {
+                if (state->imgui) {
+                    rlImGuiEnd();
+                    state->imgui = false;
+                }
+            });
+
+        world.system("end_drawing_system")
+            .kind<RLEndDrawing>()
+            .run([](flecs::iter&) {
+                EndDrawing();
+            });
+
+        // scratch memory handed out this frame goes back here
+        world.system("frame_arena_reset_system")
+            .kind<RLEndDrawing>()
+            .run(frame_arena::reset_system);
+    }
+}
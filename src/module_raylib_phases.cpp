@@ -0,0 +1,51 @@
+#include "module_raylib.hpp"
+
+namespace raylib {
+
+    // No drawing here and nothing that needs a window, so headless builds
+    // (physics_bench) can attach systems to RLUpdate without rlImGui.
+    phases::phases(flecs::world& world) {
+        world.module<phases>();
+
+        world.entity<RLUpdate>()
+            .add(flecs::Phase)
+            .depends_on(flecs::OnUpdate);
+        world.entity<RLBeginDrawing>()
+            .add(flecs::Phase)
+            .depends_on<RLUpdate>();
+        world.entity<RLStartRender>()
+            .add(flecs::Phase)
+            .depends_on<RLBeginDrawing>();
+        world.entity<RLLateLatch>()
+            .add(flecs::Phase)
+            .depends_on<RLStartRender>();
+        // camera 3d
+        world.entity<RLBeginModeCamera3D>()
+            .add(flecs::Phase)
+            .depends_on<RLLateLatch>();
+        world.entity<RLRender3D>()
+            .add(flecs::Phase)
+            .depends_on<RLBeginModeCamera3D>();
+        world.entity<RLEndMode3D>()
+            .add(flecs::Phase)
+            .depends_on<RLRender3D>();
+        // imgui
+        world.entity<RLImguiBegin>()
+            .add(flecs::Phase)
+            .depends_on<RLEndMode3D>();
+        world.entity<RLImguiRender>()
+            .add(flecs::Phase)
+            .depends_on<RLImguiBegin>();
+        world.entity<RLImguiEnd>()
+            .add(flecs::Phase)
+            .depends_on<RLImguiRender>();
+        // render 2d
+        world.entity<RLRender2D>()
+            .add(flecs::Phase)
+            .depends_on<RLImguiEnd>();
+        // end render
+        world.entity<RLEndDrawing>()
+            .add(flecs::Phase)
+            .depends_on<RLRender2D>();
+    }
+}
@@ -0,0 +1,251 @@
+#include "module_scene.hpp"
+#include "module_raylib.hpp"
+#include <rlgl.h>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <unordered_set>
+
+namespace scene {
+
+    // ------------------------------------------------------------
+    //  bulk spawn
+    // ------------------------------------------------------------
+    // entities that end up in the same table
+    struct run_key_t {
+        flecs::entity_t parent;
+        flecs::entity_t prefab;
+
+        bool operator==(const run_key_t& o) const { return parent == o.parent && prefab == o.prefab; }
+        bool operator!=(const run_key_t& o) const { return !(*this == o); }
+        bool operator<(const run_key_t& o) const {
+            return parent != o.parent ? parent < o.parent : prefab < o.prefab;
+        }
+    };
+
+    struct run_key_hash_t {
+        size_t operator()(const run_key_t& k) const {
+            return std::hash<flecs::entity_t>()(k.parent * 0x9E3779B97F4A7C15ull ^ k.prefab);
+        }
+    };
+
+    static run_key_t key_at(const spawn_desc_t& desc, int32_t i) {
+        return {
+            desc.parents ? desc.parents[i] : 0,
+            desc.prefabs ? desc.prefabs[i] : 0
+        };
+    }
+
+    // one ecs_bulk_init for a contiguous run of entities sharing a key
+    static void spawn_run(flecs::world& world, run_key_t key, int32_t count,
+                          const Transform3D* transforms, const cube_t* cubes,
+                          flecs::entity_t* out)
+    {
+        ecs_bulk_desc_t desc = {};
+        void* data[FLECS_ID_DESC_MAX] = {};
+        int32_t n = 0;
+
+        desc.ids[n] = world.id<Transform3D>();
+        data[n++] = const_cast<Transform3D*>(transforms);
+        if (cubes) {
+            desc.ids[n] = world.id<cube_t>();
+            data[n++] = const_cast<cube_t*>(cubes);
+        }
+        if (key.parent) {
+            desc.ids[n] = ecs_childof(key.parent);
+            data[n++] = nullptr;
+        }
+        if (key.prefab) {
+            desc.ids[n] = ecs_isa(key.prefab);
+            data[n++] = nullptr;
+        }
+        desc.count = count;
+        desc.data = data;
+
+        const ecs_entity_t* ids = ecs_bulk_init(world, &desc);
+        std::memcpy(out, ids, sizeof(ecs_entity_t) * (size_t)count);
+    }
+
+    // true when every key appears in exactly one contiguous run
+    static bool is_grouped(const spawn_desc_t& desc) {
+        std::unordered_set<run_key_t, run_key_hash_t> done;
+        for (int32_t i = 1; i < desc.count; i++) {
+            run_key_t prev = key_at(desc, i - 1);
+            run_key_t cur = key_at(desc, i);
+            if (cur != prev) {
+                if (!done.insert(prev).second) return false;
+                if (done.count(cur)) return false;
+            }
+        }
+        return true;
+    }
+
+    void spawn(flecs::world& world, const spawn_desc_t& desc, flecs::entity_t* out) {
+        const int32_t count = desc.count;
+        if (count <= 0 || !desc.transforms) return;
+
+        if (is_grouped(desc)) {
+            // already in table order, hand the caller's arrays to flecs as-is
+            int32_t start = 0;
+            for (int32_t i = 1; i <= count; i++) {
+                if (i == count || key_at(desc, i) != key_at(desc, start)) {
+                    spawn_run(world, key_at(desc, start), i - start,
+                              desc.transforms + start,
+                              desc.cubes ? desc.cubes + start : nullptr,
+                              out + start);
+                    start = i;
+                }
+            }
+            return;
+        }
+
+        // sort a permutation by key and gather the columns once
+        std::vector<int32_t> order((size_t)count);
+        for (int32_t i = 0; i < count; i++) order[(size_t)i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](int32_t a, int32_t b) {
+            return key_at(desc, a) < key_at(desc, b);
+        });
+
+        std::vector<Transform3D> transforms((size_t)count);
+        std::vector<cube_t> cubes(desc.cubes ? (size_t)count : 0);
+        std::vector<flecs::entity_t> ids((size_t)count);
+        for (int32_t i = 0; i < count; i++) {
+            transforms[(size_t)i] = desc.transforms[order[(size_t)i]];
+            if (desc.cubes) cubes[(size_t)i] = desc.cubes[order[(size_t)i]];
+        }
+
+        int32_t start = 0;
+        for (int32_t i = 1; i <= count; i++) {
+            run_key_t key = key_at(desc, order[(size_t)start]);
+            if (i == count || key_at(desc, order[(size_t)i]) != key) {
+                spawn_run(world, key, i - start,
+                          transforms.data() + start,
+                          desc.cubes ? cubes.data() + start : nullptr,
+                          ids.data() + start);
+                start = i;
+            }
+        }
+
+        for (int32_t i = 0; i < count; i++) {
+            out[order[(size_t)i]] = ids[(size_t)i];
+        }
+    }
+
+    std::vector<flecs::entity_t> spawn(flecs::world& world, const spawn_desc_t& desc) {
+        std::vector<flecs::entity_t> out(desc.count > 0 ? (size_t)desc.count : 0);
+        spawn(world, desc, out.data());
+        return out;
+    }
+
+    // ------------------------------------------------------------
+    //  prefabs
+    // ------------------------------------------------------------
+    flecs::entity cube_prefab(flecs::world& world, const char* name, Vector3 size, Color color) {
+        return world.prefab(name)
+            .set<cube_t>({ size, color });
+    }
+
+    flecs::entity mesh_prefab(flecs::world& world, const char* name, Mesh mesh, Material material) {
+        return world.prefab(name)
+            .set<mesh_t>({ mesh, material });
+    }
+
+    // ------------------------------------------------------------
+    //  memory report
+    // ------------------------------------------------------------
+    // size of the components on `e` that IsA instances inherit, minus the
+    // ones the instance table overrides (owner may be null)
+    static size_t inherited_size(flecs::world& world, flecs::entity_t e, const ecs_table_t* owner) {
+        const ecs_type_t* type = ecs_get_type(world, e);
+        if (!type) return 0;
+
+        size_t bytes = 0;
+        for (int32_t i = 0; i < type->count; i++) {
+            ecs_id_t id = type->array[i];
+            if (ECS_IS_PAIR(id)) continue;
+            if (owner && ecs_table_has_id(world, owner, id)) continue;
+            const ecs_type_info_t* ti = ecs_get_type_info(world, id);
+            if (ti && ecs_has_pair(world, id, EcsOnInstantiate, EcsInherit)) {
+                bytes += (size_t)ti->size;
+            }
+        }
+        return bytes;
+    }
+
+    memory_report_t memory_report(flecs::world& world) {
+        memory_report_t r;
+        std::unordered_set<flecs::entity_t> prefabs;
+
+        flecs::query<const Transform3D> q = world.query<const Transform3D>();
+        q.run([&](flecs::iter& it) {
+            while (it.next()) {
+                const ecs_table_t* table = it.c_ptr()->table;
+                const ecs_type_t* type = ecs_table_get_type(table);
+                const size_t count = it.count();
+
+                size_t owned = 0;
+                size_t inherited = 0;
+                for (int32_t i = 0; i < type->count; i++) {
+                    ecs_id_t id = type->array[i];
+                    if (ECS_IS_PAIR(id) && ECS_PAIR_FIRST(id) == EcsIsA) {
+                        flecs::entity_t prefab = ecs_pair_second(world, id);
+                        inherited += inherited_size(world, prefab, table);
+                        prefabs.insert(prefab);
+                        continue;
+                    }
+                    const ecs_type_info_t* ti = ecs_get_type_info(world, id);
+                    if (ti) owned += (size_t)ti->size;
+                }
+
+                r.entities += (int32_t)count;
+                r.owned_bytes += owned * count;
+                r.unshared_bytes += (owned + inherited) * count;
+            }
+        });
+
+        for (flecs::entity_t prefab : prefabs) {
+            r.shared_bytes += inherited_size(world, prefab, nullptr);
+        }
+        r.prefabs = (int32_t)prefabs.size();
+        return r;
+    }
+
+    void log_memory_report(flecs::world& world) {
+        memory_report_t r = memory_report(world);
+        TraceLog(LOG_INFO, "scene memory: %d entities, %d prefabs", r.entities, r.prefabs);
+        TraceLog(LOG_INFO, "  owned %zu B, shared %zu B, per entity %.1f B (unshared %.1f B)",
+                 r.owned_bytes, r.shared_bytes,
+                 r.bytes_per_entity(), r.bytes_per_entity_unshared());
+    }
+
+    // ------------------------------------------------------------
+    //  module
+    // ------------------------------------------------------------
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.import<raylib::module>();
+        world.import<transform_3d::module>();
+
+        world.component<cube_t>()
+            .add(flecs::OnInstantiate, flecs::Inherit);
+        world.component<mesh_t>()
+            .add(flecs::OnInstantiate, flecs::Inherit);
+
+        world.system<const cube_t, const Transform3D>("render_3d_cube_system")
+            .kind<raylib::RLRender3D>()
+            .each([](const cube_t& c, const Transform3D& tr) {
+                // push matrix, draw, pop
+                rlPushMatrix();
+                rlMultMatrixf(MatrixToFloat(tr.worldMatrix));
+                DrawCubeWires({0,0,0}, c.size.x, c.size.y, c.size.z, c.color);
+                rlPopMatrix();
+            });
+
+        world.system<const mesh_t, const Transform3D>("render_3d_mesh_system")
+            .kind<raylib::RLRender3D>()
+            .each([](const mesh_t& m, const Transform3D& tr) {
+                DrawMesh(m.mesh, m.material, tr.worldMatrix);
+            });
+    }
+}
@@ -1,3 +1,52 @@
 #include "module_transform_3d_hierarchy.hpp"
+#include "module_raylib.hpp"
 
+namespace transform_3d {
 
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.import<raylib::phases>();
+
+        world.component<Transform3D>();
+
+        // The parent term is matched with cascade, so tables come in depth
+        // order and a parent is always rebuilt before its children. A child
+        // only has to compare the parent's updateFrame with the current one
+        // instead of walking e.children() every frame.
+        world.system<Transform3D, const Transform3D*>("Transform3DSystem")
+            .term_at(1).parent().cascade()
+            .kind<raylib::RLUpdate>()
+            .run([](flecs::iter& it) {
+                const int64_t frame = it.world().get_info()->frame_count_total;
+
+                while (it.next()) {
+                    auto t = it.field<Transform3D>(0);
+                    auto p = it.field<const Transform3D>(1);
+                    const bool has_parent = it.is_set(1);
+
+                    for (auto i : it) {
+                        Transform3D& tr = t[i];
+                        const bool parentChanged = has_parent && p->updateFrame == frame;
+                        if (!tr.isDirty && !parentChanged) continue;
+
+                        // ---- local matrix --------------------------------------------
+                        Matrix translation = MatrixTranslate(tr.position.x, tr.position.y, tr.position.z);
+                        Matrix rotation    = QuaternionToMatrix(tr.rotation);
+                        Matrix scaling     = MatrixScale(tr.scale.x, tr.scale.y, tr.scale.z);
+                        tr.localMatrix = MatrixMultiply(scaling, MatrixMultiply(rotation, translation));
+
+                        // ---- world matrix --------------------------------------------
+                        if (has_parent) {
+                            tr.worldMatrix = MatrixMultiply(tr.localMatrix, p->worldMatrix);
+                        } else {
+                            tr.worldMatrix = tr.localMatrix;
+                        }
+
+                        tr.isDirty = false;
+                        tr.updateFrame = frame;
+                    }
+                }
+            });
+    }
+}
@@ -0,0 +1,305 @@
+#include "module_undo.hpp"
+#include "module_transform_3d_hierarchy.hpp"
+#include "delta_codec.hpp"
+#include <chrono>
+#include <cstring>
+
+namespace undo {
+
+    static double now_seconds() {
+        using clock = std::chrono::steady_clock;
+        return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+    }
+
+    // component pointer when e is alive and owns id, null otherwise
+    static void* owned_ptr(flecs::world& world, flecs::entity_t e, flecs::id_t id) {
+        if (!ecs_is_alive(world, e) || !ecs_owns_id(world, e, id)) return nullptr;
+        return ecs_get_mut_id(world, e, id);
+    }
+
+    history_t::history_t() = default;
+
+    history_t::history_t(size_t memory_cap)
+        : memory_cap_(memory_cap) {}
+
+    // ------------------------------------------------------------
+    //  transaction
+    // ------------------------------------------------------------
+    void history_t::begin(const char* label, uint64_t merge_key) {
+        if (open_) {
+            TraceLog(LOG_WARNING, "UNDO: begin(%s) while '%s' is open, dropping it", label, label_.c_str());
+        }
+        open_ = true;
+        label_ = label ? label : "";
+        merge_key_ = merge_key;
+        touched_.clear();
+        before_.clear();
+    }
+
+    void history_t::touch(flecs::world& world, flecs::entity_t e, flecs::id_t id) {
+        const ecs_type_info_t* ti = ecs_get_type_info(world, id);
+        if (!ti || ti->size == 0) return; // tags have no data
+        touch(world, e, id, 0, (uint32_t)ti->size);
+    }
+
+    void history_t::touch(flecs::world& world, flecs::entity_t e, flecs::id_t id, uint32_t field, uint32_t size) {
+        if (!open_) {
+            TraceLog(LOG_WARNING, "UNDO: touch outside of a transaction");
+            return;
+        }
+        for (const change_t& c : touched_) {
+            // already covered by an earlier touch
+            if (c.e == e && c.id == id && c.field <= field && field + size <= c.field + c.size) return;
+        }
+
+        const ecs_type_info_t* ti = ecs_get_type_info(world, id);
+        if (!ti || ti->size == 0) return;
+        if (ti->hooks.copy || ti->hooks.move || ti->hooks.dtor) {
+            TraceLog(LOG_WARNING, "UNDO: %s is not trivially copyable, not recorded",
+                     ecs_get_name(world, ecs_get_typeid(world, id)));
+            return;
+        }
+        if (size == 0 || field + size > (uint32_t)ti->size) {
+            TraceLog(LOG_WARNING, "UNDO: range %u+%u outside of %s, not recorded", field, size,
+                     ecs_get_name(world, ecs_get_typeid(world, id)));
+            return;
+        }
+
+        const uint8_t* ptr = (const uint8_t*)owned_ptr(world, e, id);
+        if (!ptr) return;
+
+        const uint32_t offset = (uint32_t)before_.size();
+        before_.resize(before_.size() + size);
+        std::memcpy(before_.data() + offset, ptr + field, size);
+        touched_.push_back({ e, id, field, size, offset, size });
+    }
+
+    void history_t::commit(flecs::world& world) {
+        if (!open_) return;
+        open_ = false;
+
+        entry_t entry;
+        entry.label = std::move(label_);
+        entry.merge_key = merge_key_;
+        entry.time = now_seconds();
+
+        for (const change_t& t : touched_) {
+            const uint8_t* ptr = (const uint8_t*)owned_ptr(world, t.e, t.id);
+            if (!ptr) continue;
+            const uint32_t offset = (uint32_t)entry.data.size();
+            const size_t length = delta::encode_runs(before_.data() + t.offset, ptr + t.field, t.size, entry.data);
+            if (length == 0) continue;
+            entry.changes.push_back({ t.e, t.id, t.field, t.size, offset, (uint32_t)length });
+        }
+        touched_.clear();
+
+        if (entry.changes.empty()) return;
+        push(world, std::move(entry));
+    }
+
+    void history_t::cancel(flecs::world& world) {
+        if (!open_) return;
+        open_ = false;
+
+        for (auto it = touched_.rbegin(); it != touched_.rend(); ++it) {
+            uint8_t* ptr = (uint8_t*)owned_ptr(world, it->e, it->id);
+            if (!ptr) continue;
+            std::memcpy(ptr + it->field, before_.data() + it->offset, it->size);
+            restored(world, it->e, it->id, ptr);
+        }
+        touched_.clear();
+    }
+
+    // ------------------------------------------------------------
+    //  history
+    // ------------------------------------------------------------
+    void history_t::push(flecs::world& world, entry_t&& entry) {
+        // a new operation drops the redo branch
+        while (entries_.size() > cursor_) {
+            memory_ -= entries_.back().bytes();
+            entries_.pop_back();
+        }
+
+        if (entry.merge_key && !entries_.empty()) {
+            entry_t& last = entries_.back();
+            if (last.merge_key == entry.merge_key && entry.time - last.time <= merge_window) {
+                memory_ -= last.bytes();
+                const bool merged = merge_into(world, last, entry);
+                memory_ += last.bytes();
+                if (merged) {
+                    enforce_cap();
+                    return;
+                }
+            }
+        }
+
+        entry.data.shrink_to_fit();
+        memory_ += entry.bytes();
+        entries_.push_back(std::move(entry));
+        cursor_ = entries_.size();
+        enforce_cap();
+    }
+
+    // Runs of the same range are merged against the current bytes (the
+    // after side of `next`): stepping both entries back gives the before
+    // side of `last`.
+    bool history_t::merge_into(flecs::world& world, entry_t& last, const entry_t& next) {
+        entry_t merged;
+        merged.label = last.label;
+        merged.merge_key = last.merge_key;
+        merged.time = next.time;
+
+        std::vector<bool> used(next.changes.size(), false);
+        for (const change_t& a : last.changes) {
+            const uint32_t offset = (uint32_t)merged.data.size();
+            size_t n = 0;
+            while (n < next.changes.size() &&
+                   (next.changes[n].e != a.e || next.changes[n].id != a.id ||
+                    next.changes[n].field != a.field || next.changes[n].size != a.size)) {
+                n++;
+            }
+
+            if (n == next.changes.size()) {
+                merged.data.insert(merged.data.end(), last.data.begin() + a.offset,
+                                   last.data.begin() + a.offset + a.length);
+            } else {
+                const change_t& b = next.changes[n];
+                const uint8_t* ptr = (const uint8_t*)owned_ptr(world, a.e, a.id);
+                if (!ptr) return false;
+                scratch_.assign(ptr + a.field, ptr + a.field + a.size);          // after
+                scratch_.insert(scratch_.end(), ptr + a.field, ptr + a.field + a.size);
+                uint8_t* before = scratch_.data() + a.size;
+                if (!delta::apply_runs(next.data.data() + b.offset, b.length, before, a.size, delta::side_t::before) ||
+                    !delta::apply_runs(last.data.data() + a.offset, a.length, before, a.size, delta::side_t::before)) {
+                    return false;
+                }
+                delta::encode_runs(before, scratch_.data(), a.size, merged.data);
+                used[n] = true;
+            }
+            // a drag back to the start leaves no runs, keep the slot anyway
+            merged.changes.push_back({ a.e, a.id, a.field, a.size, offset, (uint32_t)(merged.data.size() - offset) });
+        }
+
+        for (size_t n = 0; n < next.changes.size(); n++) {
+            if (used[n]) continue;
+            const change_t& b = next.changes[n];
+            const uint32_t offset = (uint32_t)merged.data.size();
+            merged.data.insert(merged.data.end(), next.data.begin() + b.offset,
+                               next.data.begin() + b.offset + b.length);
+            merged.changes.push_back({ b.e, b.id, b.field, b.size, offset, b.length });
+        }
+
+        merged.data.shrink_to_fit();
+        last = std::move(merged);
+        return true;
+    }
+
+    void history_t::enforce_cap() {
+        while (memory_ > memory_cap_ && entries_.size() > 1) {
+            if (cursor_ == 0) {
+                // only redo entries left, they can't be reached without the
+                // ones before them
+                entries_.clear();
+                memory_ = 0;
+                return;
+            }
+            memory_ -= entries_.front().bytes();
+            entries_.pop_front();
+            cursor_--;
+        }
+    }
+
+    // All or nothing: every range must still hold the side being replaced,
+    // otherwise the entry is refused and nothing is written.
+    bool history_t::apply(flecs::world& world, const entry_t& entry, bool reverse) {
+        const delta::side_t from = reverse ? delta::side_t::after : delta::side_t::before;
+        const delta::side_t to = reverse ? delta::side_t::before : delta::side_t::after;
+
+        for (const change_t& c : entry.changes) {
+            const uint8_t* ptr = (const uint8_t*)owned_ptr(world, c.e, c.id);
+            if (!ptr) {
+                TraceLog(LOG_WARNING, "UNDO: '%s' refused, entity or component gone", entry.label.c_str());
+                return false;
+            }
+            if (!delta::holds_runs(entry.data.data() + c.offset, c.length, ptr + c.field, c.size, from)) {
+                TraceLog(LOG_WARNING, "UNDO: '%s' refused, %s of entity %llu changed outside of the history",
+                         entry.label.c_str(), ecs_get_name(world, ecs_get_typeid(world, c.id)),
+                         (unsigned long long)c.e);
+                return false;
+            }
+        }
+
+        const size_t count = entry.changes.size();
+        for (size_t i = 0; i < count; i++) {
+            const change_t& c = entry.changes[reverse ? count - 1 - i : i];
+            uint8_t* ptr = (uint8_t*)owned_ptr(world, c.e, c.id);
+            delta::apply_runs(entry.data.data() + c.offset, c.length, ptr + c.field, c.size, to);
+            restored(world, c.e, c.id, ptr);
+        }
+        return true;
+    }
+
+    void history_t::restored(flecs::world& world, flecs::entity_t e, flecs::id_t id, void* ptr) {
+        auto hook = hooks_.find(id);
+        if (hook != hooks_.end()) hook->second(world, e, ptr);
+        ecs_modified_id(world, e, id);
+    }
+
+    bool history_t::undo(flecs::world& world) {
+        if (open_) cancel(world);
+        if (!can_undo()) return false;
+        if (!apply(world, entries_[cursor_ - 1], true)) return false;
+        cursor_--;
+        return true;
+    }
+
+    bool history_t::redo(flecs::world& world) {
+        if (open_) cancel(world);
+        if (!can_redo()) return false;
+        if (!apply(world, entries_[cursor_], false)) return false;
+        cursor_++;
+        return true;
+    }
+
+    const char* history_t::undo_label() const {
+        return can_undo() ? entries_[cursor_ - 1].label.c_str() : nullptr;
+    }
+
+    const char* history_t::redo_label() const {
+        return can_redo() ? entries_[cursor_].label.c_str() : nullptr;
+    }
+
+    void history_t::clear() {
+        entries_.clear();
+        cursor_ = 0;
+        memory_ = 0;
+    }
+
+    void history_t::set_memory_cap(size_t bytes) {
+        memory_cap_ = bytes;
+        enforce_cap();
+    }
+
+    void history_t::set_restore_hook(flecs::id_t id, restore_hook_t hook) {
+        hooks_[id] = std::move(hook);
+    }
+
+    // ------------------------------------------------------------
+    //  module
+    // ------------------------------------------------------------
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.import<transform_3d::module>();
+
+        world.component<history_t>().add(flecs::Singleton);
+        world.add<history_t>();
+
+        // A restored position / rotation / scale leaves the cached matrices
+        // stale, flag the transform so the hierarchy system rebuilds them.
+        world.get_mut<history_t>().set_restore_hook(world.id<transform_3d::Transform3D>(),
+            [](flecs::world&, flecs::entity_t, void* ptr) {
+                static_cast<transform_3d::Transform3D*>(ptr)->isDirty = true;
+            });
+    }
+}
@@ -0,0 +1,361 @@
+#include "module_world_partition.hpp"
+#include "module_raylib.hpp"
+#include "module_scene.hpp"
+#include "scene_snapshot.hpp"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace world_partition {
+
+    using scene::Transform3D;
+
+    // ------------------------------------------------------------
+    //  cell keys
+    // ------------------------------------------------------------
+    struct cell_key_t {
+        int32_t x;
+        int32_t z;
+
+        bool operator==(const cell_key_t& o) const { return x == o.x && z == o.z; }
+    };
+
+    struct cell_key_hash_t {
+        size_t operator()(const cell_key_t& k) const {
+            return std::hash<uint64_t>()(((uint64_t)(uint32_t)k.x << 32) | (uint32_t)k.z);
+        }
+    };
+
+    static cell_key_t cell_of(float x, float z, float cell_size) {
+        return { (int32_t)std::floor(x / cell_size), (int32_t)std::floor(z / cell_size) };
+    }
+
+    // Chebyshev distance, the ring index around the center cell
+    static int32_t ring_of(cell_key_t a, cell_key_t b) {
+        return std::max(std::abs(a.x - b.x), std::abs(a.z - b.z));
+    }
+
+    static std::string cell_path(const std::string& directory, cell_key_t k) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "/cell_%d_%d.rlsc", k.x, k.z);
+        return directory + name;
+    }
+
+    // ------------------------------------------------------------
+    //  loader thread
+    // ------------------------------------------------------------
+    struct read_request_t {
+        cell_key_t  key;
+        std::string path;
+    };
+
+    struct read_result_t {
+        cell_key_t key;
+        std::vector<unsigned char> bytes;
+        bool ok;
+    };
+
+    struct streamer_t {
+        // shared with the loader thread
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<read_request_t> requests;
+        std::vector<read_result_t> results;
+        bool quit = false;
+
+        // main thread only
+        std::unordered_set<cell_key_t, cell_key_hash_t> in_flight;
+        std::unordered_set<cell_key_t, cell_key_hash_t> missing;   // no file, don't ask again
+        std::unordered_map<cell_key_t, std::vector<unsigned char>, cell_key_hash_t> cache;
+        std::unordered_map<cell_key_t, flecs::entity_t, cell_key_hash_t> loaded;
+        std::vector<read_result_t> drained;
+
+        std::thread thread;
+
+        streamer_t() {
+            thread = std::thread([this] { run(); });
+        }
+
+        ~streamer_t() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+            }
+            cv.notify_all();
+            thread.join();
+        }
+
+        void request(cell_key_t key, std::string path) {
+            in_flight.insert(key);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                requests.push_back({ key, std::move(path) });
+            }
+            cv.notify_one();
+        }
+
+        void drain() {
+            drained.clear();
+            std::lock_guard<std::mutex> lock(mutex);
+            drained.swap(results);
+        }
+
+        void run() {
+            for (;;) {
+                read_request_t req;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [this] { return quit || !requests.empty(); });
+                    if (quit) return;
+                    req = std::move(requests.front());
+                    requests.pop_front();
+                }
+
+                read_result_t res;
+                res.key = req.key;
+                res.ok = read_file(req.path.c_str(), res.bytes);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                results.push_back(std::move(res));
+            }
+        }
+
+        static bool read_file(const char* path, std::vector<unsigned char>& out) {
+            FILE* f = std::fopen(path, "rb");
+            if (!f) return false;
+            bool ok = std::fseek(f, 0, SEEK_END) == 0;
+            long size = ok ? std::ftell(f) : -1;
+            ok = size > 0 && std::fseek(f, 0, SEEK_SET) == 0;
+            if (ok) {
+                out.resize((size_t)size);
+                ok = std::fread(out.data(), 1, out.size(), f) == out.size();
+            }
+            std::fclose(f);
+            return ok;
+        }
+    };
+
+    partition_state_t::partition_state_t() = default;
+    partition_state_t::~partition_state_t() = default;
+    partition_state_t::partition_state_t(partition_state_t&&) noexcept = default;
+    partition_state_t& partition_state_t::operator=(partition_state_t&&) noexcept = default;
+
+    // ------------------------------------------------------------
+    //  load / unload
+    // ------------------------------------------------------------
+    static void unload_cell(flecs::world& world, partition_state_t& state, flecs::entity_t id) {
+        flecs::entity cell = world.entity(id);
+        if (state.hooks.on_unloading) state.hooks.on_unloading(world, cell);
+        cell.destruct(); // roots and prefabs are children
+    }
+
+    // `header` was checked with scene::read_snapshot_header
+    static bool load_cell(flecs::world& world, partition_state_t& state, const partition_config_t& cfg,
+                          cell_key_t key, const scene::snapshot_header_t& header,
+                          const std::vector<unsigned char>& bytes)
+    {
+        flecs::entity cell = world.entity()
+            .set<cell_t>({ key.x, key.z, (size_t)header.entity_count * cfg.bytes_per_entity,
+                           (int32_t)header.entity_count });
+
+        if (!scene::load_snapshot_memory(world, bytes.data(), bytes.size(), nullptr, cell)) {
+            TraceLog(LOG_WARNING, "PARTITION: cell %d,%d is corrupt", key.x, key.z);
+            cell.destruct();
+            return false;
+        }
+
+        state.streamer->loaded[key] = cell;
+        if (state.hooks.on_loaded) state.hooks.on_loaded(world, cell);
+        return true;
+    }
+
+    static size_t loaded_bytes(flecs::world& world, const streamer_t& s) {
+        size_t bytes = 0;
+        for (const auto& kv : s.loaded) {
+            if (const cell_t* c = world.entity(kv.second).try_get<cell_t>()) bytes += c->bytes;
+        }
+        return bytes;
+    }
+
+    // ------------------------------------------------------------
+    //  update
+    // ------------------------------------------------------------
+    void update(flecs::world& world, Vector3 position) {
+        const partition_config_t& cfg = world.get<partition_config_t>();
+        partition_state_t& state = world.get_mut<partition_state_t>();
+        if (!state.streamer) state.streamer = std::make_unique<streamer_t>();
+        streamer_t& s = *state.streamer;
+
+        const cell_key_t center = cell_of(position.x, position.z, cfg.cell_size);
+        const int32_t load_r = cfg.load_radius;
+        const int32_t prefetch_r = std::max(cfg.prefetch_radius, load_r);
+
+        // ---- finished reads ------------------------------------------
+        s.drain();
+        for (read_result_t& r : s.drained) {
+            s.in_flight.erase(r.key);
+            if (!r.ok) {
+                s.missing.insert(r.key);
+            } else if (ring_of(r.key, center) <= prefetch_r + 1 && !s.loaded.count(r.key)) {
+                s.cache[r.key] = std::move(r.bytes);
+            }
+        }
+
+        // ---- unload / drop, one ring of hysteresis -------------------
+        for (auto it = s.loaded.begin(); it != s.loaded.end();) {
+            if (ring_of(it->first, center) > load_r + 1) {
+                unload_cell(world, state, it->second);
+                it = s.loaded.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto it = s.cache.begin(); it != s.cache.end();) {
+            if (ring_of(it->first, center) > prefetch_r + 1) it = s.cache.erase(it);
+            else ++it;
+        }
+
+        size_t resident = loaded_bytes(world, s);
+        for (const auto& kv : s.cache) resident += kv.second.size();
+
+        // ---- wanted cells, nearest ring first ------------------------
+        bool over_budget = false;
+        int32_t loads = 0;
+        for (int32_t r = 0; r <= prefetch_r; r++) {
+            for (int32_t dz = -r; dz <= r; dz++) {
+                for (int32_t dx = -r; dx <= r; dx++) {
+                    if (std::max(std::abs(dx), std::abs(dz)) != r) continue;
+                    const cell_key_t key = { center.x + dx, center.z + dz };
+                    if (s.loaded.count(key) || s.missing.count(key)) continue;
+
+                    auto cached = s.cache.find(key);
+                    if (cached == s.cache.end()) {
+                        if (s.in_flight.count(key)) continue;
+                        // the load ring is always read, prefetch only under budget
+                        if (r > load_r && resident >= cfg.memory_budget) {
+                            over_budget = true;
+                            continue;
+                        }
+                        s.request(key, cell_path(cfg.directory, key));
+                        continue;
+                    }
+
+                    if (r > load_r || loads >= cfg.max_loads_per_frame) continue;
+
+                    std::vector<unsigned char> bytes = std::move(cached->second);
+                    s.cache.erase(cached);
+                    resident -= bytes.size();
+
+                    // nothing in the header is trusted before it is checked
+                    scene::snapshot_header_t header;
+                    if (!scene::read_snapshot_header(bytes.data(), bytes.size(), header)) {
+                        TraceLog(LOG_WARNING, "PARTITION: cell %d,%d has no valid header", key.x, key.z);
+                        s.missing.insert(key);
+                        continue;
+                    }
+                    const size_t cost = (size_t)header.entity_count * cfg.bytes_per_entity;
+                    if (r > 0 && resident + cost > cfg.memory_budget) {
+                        // keep the bytes around, maybe the camera comes closer
+                        over_budget = true;
+                        resident += bytes.size();
+                        s.cache[key] = std::move(bytes);
+                        continue;
+                    }
+
+                    if (load_cell(world, state, cfg, key, header, bytes)) {
+                        resident += cost;
+                        loads++;
+                    } else {
+                        s.missing.insert(key);
+                    }
+                }
+            }
+        }
+
+        state.stats.loaded = (int32_t)s.loaded.size();
+        state.stats.prefetched = (int32_t)s.cache.size();
+        state.stats.pending = (int32_t)s.in_flight.size();
+        state.stats.resident_bytes = resident;
+        state.stats.over_budget = over_budget;
+    }
+
+    void unload_all(flecs::world& world) {
+        partition_state_t& state = world.get_mut<partition_state_t>();
+        if (!state.streamer) return;
+        streamer_t& s = *state.streamer;
+        for (const auto& kv : s.loaded) {
+            unload_cell(world, state, kv.second);
+        }
+        s.loaded.clear();
+        s.cache.clear();
+        s.missing.clear();
+        state.stats = {};
+    }
+
+    // ------------------------------------------------------------
+    //  bake
+    // ------------------------------------------------------------
+    int32_t bake_cells(flecs::world& world, const char* directory, float cell_size) {
+        std::unordered_map<cell_key_t, std::vector<flecs::entity_t>, cell_key_hash_t> cells;
+
+        world.query_builder<const Transform3D>()
+            .without(flecs::ChildOf, flecs::Wildcard)
+            .build()
+            .each([&](flecs::entity e, const Transform3D& t) {
+                cells[cell_of(t.position.x, t.position.z, cell_size)].push_back(e);
+            });
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) {
+            TraceLog(LOG_WARNING, "PARTITION: could not create %s", directory);
+            return 0;
+        }
+
+        int32_t written = 0;
+        for (const auto& kv : cells) {
+            const std::string path = cell_path(directory, kv.first);
+            if (scene::save_snapshot(world, path.c_str(), kv.second.data(), (int32_t)kv.second.size())) {
+                written++;
+            }
+        }
+        TraceLog(LOG_INFO, "PARTITION: baked %d cells to %s", written, directory);
+        return written;
+    }
+
+    // ------------------------------------------------------------
+    //  module
+    // ------------------------------------------------------------
+    module::module(flecs::world& world) {
+        world.module<module>();
+
+        world.import<raylib::module>();
+        world.import<scene::module>();
+
+        world.component<cell_t>();
+        world.component<partition_config_t>().add(flecs::Singleton);
+        world.component<partition_state_t>().add(flecs::Singleton);
+        world.add<partition_config_t>();
+        world.add<partition_state_t>();
+
+        // creates entities with scene::spawn, so it has to run outside of
+        // the deferred stage
+        world.system("world_partition_system")
+            .kind(flecs::PreUpdate)
+            .immediate()
+            .run([](flecs::iter& it) {
+                flecs::world world = it.world();
+                const raylib::main_context_t* ctx = world.try_get<raylib::main_context_t>();
+                if (ctx) update(world, ctx->camera.position);
+            });
+    }
+}
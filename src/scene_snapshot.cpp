@@ -0,0 +1,455 @@
+#include "scene_snapshot.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+namespace scene {
+
+    static constexpr uint32_t TAG_EIDS = snapshot_tag('E','I','D','S');
+    static constexpr uint32_t TAG_HIER = snapshot_tag('H','I','E','R');
+    static constexpr uint32_t TAG_LEVL = snapshot_tag('L','E','V','L');
+    static constexpr uint32_t TAG_XFRM = snapshot_tag('X','F','R','M');
+    static constexpr uint32_t TAG_ISA  = snapshot_tag('I','S','A','_');
+    static constexpr uint32_t TAG_FLAG = snapshot_tag('F','L','A','G');
+    static constexpr uint32_t TAG_CUBE = snapshot_tag('C','U','B','E');
+    static constexpr uint32_t TAG_PREF = snapshot_tag('P','R','E','F');
+
+    static size_t align16(size_t v) {
+        return (v + 15) & ~(size_t)15;
+    }
+
+    // ------------------------------------------------------------
+    //  save
+    // ------------------------------------------------------------
+    struct record_t {
+        flecs::entity_t  id;
+        flecs::entity_t  parent;
+        flecs::entity_t  prefab;
+        uint32_t         depth;
+        bool             owns_cube;
+        cube_t           cube;
+        snapshot_xform_t xform;
+    };
+
+    struct chunk_list_t {
+        std::vector<snapshot_chunk_t> chunks;
+        std::vector<const void*> data;
+
+        void add(uint32_t tag, uint32_t elem_size, size_t count, const void* ptr) {
+            snapshot_chunk_t c = {};
+            c.tag = tag;
+            c.elem_size = elem_size;
+            c.count = (uint32_t)count;
+            c.size = (uint64_t)elem_size * count;
+            chunks.push_back(c);
+            data.push_back(ptr);
+        }
+    };
+
+    static record_t make_record(flecs::entity e, const Transform3D& t) {
+        record_t r = {};
+        r.id = e;
+        r.parent = e.parent();
+        r.prefab = e.target(flecs::IsA);
+        r.owns_cube = e.owns<cube_t>();
+        if (r.owns_cube) r.cube = e.get<cube_t>();
+        r.xform = { t.position, t.rotation, t.scale };
+        return r;
+    }
+
+    static void gather_tree(flecs::entity e, std::vector<record_t>& records) {
+        const Transform3D* t = e.try_get<Transform3D>();
+        if (!t || e.has(flecs::Prefab)) return;
+        records.push_back(make_record(e, *t));
+        e.children([&](flecs::entity child) {
+            gather_tree(child, records);
+        });
+    }
+
+    static bool write_records(flecs::world& world, const char* path, std::vector<record_t>& records);
+
+    bool save_snapshot(flecs::world& world, const char* path) {
+        std::vector<record_t> records;
+        world.query<const Transform3D>()
+            .each([&](flecs::entity e, const Transform3D& t) {
+                records.push_back(make_record(e, t));
+            });
+        return write_records(world, path, records);
+    }
+
+    bool save_snapshot(flecs::world& world, const char* path,
+                       const flecs::entity_t* roots, int32_t count)
+    {
+        std::vector<record_t> records;
+        for (int32_t i = 0; i < count; i++) {
+            gather_tree(world.entity(roots[i]), records);
+        }
+        return write_records(world, path, records);
+    }
+
+    static bool write_records(flecs::world& world, const char* path, std::vector<record_t>& records) {
+        std::unordered_map<flecs::entity_t, size_t> index_of;
+        index_of.reserve(records.size());
+        for (size_t i = 0; i < records.size(); i++) index_of[records[i].id] = i;
+
+        // parents outside the saved set become roots
+        for (record_t& r : records) {
+            if (r.parent && !index_of.count(r.parent)) r.parent = 0;
+        }
+
+        // ---- depth -----------------------------------------------------
+        std::vector<int32_t> depth(records.size(), -1);
+        std::vector<size_t> chain;
+        for (size_t i = 0; i < records.size(); i++) {
+            size_t cur = i;
+            chain.clear();
+            while (depth[cur] < 0 && records[cur].parent) {
+                chain.push_back(cur);
+                cur = index_of[records[cur].parent];
+            }
+            if (depth[cur] < 0) depth[cur] = 0;
+            int32_t d = depth[cur];
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+                depth[*it] = ++d;
+            }
+        }
+        for (size_t i = 0; i < records.size(); i++) records[i].depth = (uint32_t)depth[i];
+
+        // ---- order: depth, then runs that land in the same table -------
+        std::sort(records.begin(), records.end(), [](const record_t& a, const record_t& b) {
+            if (a.depth != b.depth) return a.depth < b.depth;
+            if (a.parent != b.parent) return a.parent < b.parent;
+            if (a.prefab != b.prefab) return a.prefab < b.prefab;
+            return a.owns_cube < b.owns_cube;
+        });
+
+        const size_t count = records.size();
+        index_of.clear();
+        for (size_t i = 0; i < count; i++) index_of[records[i].id] = i;
+
+        // ---- prefab table ----------------------------------------------
+        std::vector<snapshot_prefab_t> prefabs;
+        std::unordered_map<flecs::entity_t, int32_t> prefab_index;
+        for (const record_t& r : records) {
+            if (!r.prefab || prefab_index.count(r.prefab)) continue;
+            snapshot_prefab_t p = {};
+            p.saved_id = r.prefab;
+            if (const cube_t* c = world.entity(r.prefab).try_get<cube_t>()) {
+                p.flags |= SNAPSHOT_OWNS_CUBE;
+                p.cube = *c;
+            }
+            prefab_index[r.prefab] = (int32_t)prefabs.size();
+            prefabs.push_back(p);
+        }
+
+        // ---- columns ---------------------------------------------------
+        std::vector<uint64_t> ids(count);
+        std::vector<int32_t> parents(count);
+        std::vector<snapshot_xform_t> xforms(count);
+        std::vector<int32_t> isa(count);
+        std::vector<uint8_t> flags(count);
+        std::vector<cube_t> cubes;
+        std::vector<snapshot_level_t> levels;
+
+        for (size_t i = 0; i < count; i++) {
+            const record_t& r = records[i];
+            ids[i] = r.id;
+            parents[i] = r.parent ? (int32_t)index_of[r.parent] : -1;
+            xforms[i] = r.xform;
+            isa[i] = r.prefab ? prefab_index[r.prefab] : -1;
+            flags[i] = r.owns_cube ? SNAPSHOT_OWNS_CUBE : 0;
+            if (r.owns_cube) cubes.push_back(r.cube);
+
+            if (levels.empty() || records[levels.back().first].depth != r.depth) {
+                levels.push_back({ (uint32_t)i, 0 });
+            }
+            levels.back().count++;
+        }
+
+        chunk_list_t list;
+        list.add(TAG_EIDS, sizeof(uint64_t), count, ids.data());
+        list.add(TAG_HIER, sizeof(int32_t), count, parents.data());
+        list.add(TAG_LEVL, sizeof(snapshot_level_t), levels.size(), levels.data());
+        list.add(TAG_XFRM, sizeof(snapshot_xform_t), count, xforms.data());
+        list.add(TAG_ISA, sizeof(int32_t), count, isa.data());
+        list.add(TAG_FLAG, sizeof(uint8_t), count, flags.data());
+        list.add(TAG_CUBE, sizeof(cube_t), cubes.size(), cubes.data());
+        list.add(TAG_PREF, sizeof(snapshot_prefab_t), prefabs.size(), prefabs.data());
+
+        snapshot_header_t header = {};
+        std::memcpy(header.magic, "RLSC", 4);
+        header.version = SNAPSHOT_VERSION;
+        header.entity_count = (uint32_t)count;
+        header.chunk_count = (uint32_t)list.chunks.size();
+        header.level_count = (uint32_t)levels.size();
+        header.prefab_count = (uint32_t)prefabs.size();
+
+        size_t offset = align16(sizeof(header) + sizeof(snapshot_chunk_t) * list.chunks.size());
+        for (snapshot_chunk_t& c : list.chunks) {
+            c.offset = offset;
+            offset = align16(offset + (size_t)c.size);
+        }
+
+        // ---- write -----------------------------------------------------
+        FILE* f = std::fopen(path, "wb");
+        if (!f) {
+            TraceLog(LOG_WARNING, "SNAPSHOT: could not open %s for writing", path);
+            return false;
+        }
+
+        static const unsigned char zeros[16] = {};
+        bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1;
+        ok = ok && std::fwrite(list.chunks.data(), sizeof(snapshot_chunk_t), list.chunks.size(), f) == list.chunks.size();
+        size_t written = sizeof(header) + sizeof(snapshot_chunk_t) * list.chunks.size();
+        for (size_t i = 0; ok && i < list.chunks.size(); i++) {
+            const snapshot_chunk_t& c = list.chunks[i];
+            size_t pad = (size_t)c.offset - written;
+            ok = ok && std::fwrite(zeros, 1, pad, f) == pad;
+            ok = ok && (c.size == 0 || std::fwrite(list.data[i], 1, (size_t)c.size, f) == (size_t)c.size);
+            written = (size_t)(c.offset + c.size);
+        }
+        ok = (std::fclose(f) == 0) && ok;
+
+        if (!ok) {
+            TraceLog(LOG_WARNING, "SNAPSHOT: write to %s failed", path);
+            return false;
+        }
+        TraceLog(LOG_INFO, "SNAPSHOT: saved %u entities, %u prefabs to %s (%zu bytes)",
+                 header.entity_count, header.prefab_count, path, written);
+        return true;
+    }
+
+    // ------------------------------------------------------------
+    //  load
+    // ------------------------------------------------------------
+    // chunk lookup with bounds and element size checks
+    static const snapshot_chunk_t* find_chunk(const std::vector<snapshot_chunk_t>& chunks, size_t size,
+                                              uint32_t tag, uint32_t elem_size)
+    {
+        for (const snapshot_chunk_t& c : chunks) {
+            if (c.tag != tag) continue;
+            if (c.elem_size != elem_size) return nullptr;
+            if (c.size != (uint64_t)c.elem_size * c.count) return nullptr;
+            if (c.offset % 16 != 0 || c.offset > size || c.size > size - c.offset) return nullptr;
+            return &c;
+        }
+        return nullptr;
+    }
+
+    // Column view. Chunks are 16-byte aligned inside the file, but the buffer
+    // itself may not be (a std::vector<unsigned char> from a prefetch), so
+    // misaligned columns are copied out instead of cast in place.
+    template <typename T>
+    struct column_t {
+        const T* ptr = nullptr;
+        std::vector<T> copy;
+
+        column_t(const unsigned char* data, const snapshot_chunk_t* c) {
+            if (!c) return;
+            const unsigned char* src = data + c->offset;
+            if (reinterpret_cast<uintptr_t>(src) % alignof(T) == 0) {
+                ptr = reinterpret_cast<const T*>(src);
+                return;
+            }
+            copy.resize(c->count);
+            if (c->size) std::memcpy(copy.data(), src, (size_t)c->size);
+            ptr = copy.data();
+        }
+    };
+
+    bool read_snapshot_header(const void* ptr, size_t size, snapshot_header_t& header) {
+        const unsigned char* data = static_cast<const unsigned char*>(ptr);
+        if (!data || size < sizeof(snapshot_header_t)) {
+            TraceLog(LOG_WARNING, "SNAPSHOT: buffer too small");
+            return false;
+        }
+
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, "RLSC", 4) != 0 || header.version != SNAPSHOT_VERSION) {
+            TraceLog(LOG_WARNING, "SNAPSHOT: bad magic or version %u", header.version);
+            return false;
+        }
+        if ((size - sizeof(header)) / sizeof(snapshot_chunk_t) < header.chunk_count) {
+            TraceLog(LOG_WARNING, "SNAPSHOT: truncated chunk table");
+            return false;
+        }
+        // every entity has at least a HIER and an XFRM entry
+        if (header.entity_count > size / (sizeof(int32_t) + sizeof(snapshot_xform_t))) {
+            TraceLog(LOG_WARNING, "SNAPSHOT: %u entities do not fit in %zu bytes", header.entity_count, size);
+            return false;
+        }
+        return true;
+    }
+
+    bool load_snapshot_memory(flecs::world& world, const void* ptr, size_t size,
+                              std::vector<flecs::entity_t>* out_entities,
+                              flecs::entity_t parent,
+                              snapshot_remap_t* out_remap)
+    {
+        const unsigned char* data = static_cast<const unsigned char*>(ptr);
+        snapshot_header_t header;
+        if (!read_snapshot_header(data, size, header)) return false;
+
+        std::vector<snapshot_chunk_t> chunks(header.chunk_count);
+        if (header.chunk_count) {
+            std::memcpy(chunks.data(), data + sizeof(header), sizeof(snapshot_chunk_t) * header.chunk_count);
+        }
+
+        const uint32_t count = header.entity_count;
+        const snapshot_chunk_t* c_eids = find_chunk(chunks, size, TAG_EIDS, sizeof(uint64_t));
+        const snapshot_chunk_t* c_hier = find_chunk(chunks, size, TAG_HIER, sizeof(int32_t));
+        const snapshot_chunk_t* c_levl = find_chunk(chunks, size, TAG_LEVL, sizeof(snapshot_level_t));
+        const snapshot_chunk_t* c_xfrm = find_chunk(chunks, size, TAG_XFRM, sizeof(snapshot_xform_t));
+        const snapshot_chunk_t* c_isa  = find_chunk(chunks, size, TAG_ISA, sizeof(int32_t));
+        const snapshot_chunk_t* c_flag = find_chunk(chunks, size, TAG_FLAG, sizeof(uint8_t));
+        const snapshot_chunk_t* c_cube = find_chunk(chunks, size, TAG_CUBE, sizeof(cube_t));
+        const snapshot_chunk_t* c_pref = find_chunk(chunks, size, TAG_PREF, sizeof(snapshot_prefab_t));
+
+        if (!c_hier || !c_levl || !c_xfrm || c_hier->count != count || c_xfrm->count != count ||
+            (c_eids && c_eids->count != count) || (c_isa && c_isa->count != count) ||
+            (c_flag && c_flag->count != count)) {
+            TraceLog(LOG_WARNING, "SNAPSHOT: missing or malformed chunks");
+            return false;
+        }
+
+        const column_t<uint64_t> eids(data, c_eids);
+        const column_t<int32_t> parents(data, c_hier);
+        const column_t<snapshot_level_t> levels(data, c_levl);
+        const column_t<snapshot_xform_t> xforms(data, c_xfrm);
+        const column_t<int32_t> isa(data, c_isa);
+        const column_t<uint8_t> flags(data, c_flag);
+        const column_t<cube_t> cubes(data, c_cube);
+        const column_t<snapshot_prefab_t> prefab_recs(data, c_pref);
+        const uint32_t cube_count = c_cube ? c_cube->count : 0;
+        const uint32_t prefab_count = c_pref ? c_pref->count : 0;
+
+        // ---- validate before anything is created -----------------------
+        // Levels must tile [0, count) in order, and every parent must sit in
+        // an earlier level so it exists by the time its children spawn.
+        uint32_t next_first = 0;
+        uint32_t owners = 0;
+        for (uint32_t l = 0; l < c_levl->count; l++) {
+            const uint32_t first = levels.ptr[l].first;
+            const uint32_t n = levels.ptr[l].count;
+            if (first != next_first || n == 0 || n > count - first) {
+                TraceLog(LOG_WARNING, "SNAPSHOT: level %u does not follow level %u", l, l ? l - 1 : 0);
+                return false;
+            }
+            for (uint32_t e = first; e < first + n; e++) {
+                const int32_t p = parents.ptr[e];
+                if (p < -1 || p >= (int32_t)first) {
+                    TraceLog(LOG_WARNING, "SNAPSHOT: entity %u has a parent outside the earlier levels", e);
+                    return false;
+                }
+                const int32_t pf = isa.ptr ? isa.ptr[e] : -1;
+                if (pf < -1 || pf >= (int32_t)prefab_count) {
+                    TraceLog(LOG_WARNING, "SNAPSHOT: entity %u has an unknown prefab", e);
+                    return false;
+                }
+                if (flags.ptr && (flags.ptr[e] & SNAPSHOT_OWNS_CUBE)) owners++;
+            }
+            next_first = first + n;
+        }
+        if (next_first != count) {
+            TraceLog(LOG_WARNING, "SNAPSHOT: levels cover %u of %u entities", next_first, count);
+            return false;
+        }
+        if (owners > cube_count) {
+            TraceLog(LOG_WARNING, "SNAPSHOT: cube column too short");
+            return false;
+        }
+
+        // ---- prefabs ---------------------------------------------------
+        std::vector<flecs::entity_t> prefabs(prefab_count);
+        for (uint32_t i = 0; i < prefab_count; i++) {
+            flecs::entity p = world.prefab();
+            if (parent) p.child_of(parent);
+            if (prefab_recs.ptr[i].flags & SNAPSHOT_OWNS_CUBE) {
+                p.set<cube_t>(prefab_recs.ptr[i].cube);
+            }
+            prefabs[i] = p;
+        }
+
+        // ---- entities, one level at a time -----------------------------
+        std::vector<flecs::entity_t> entities(count);
+        std::vector<Transform3D> transforms;
+        std::vector<flecs::entity_t> level_parents;
+        std::vector<flecs::entity_t> level_prefabs;
+        uint32_t cube_cursor = 0;
+
+        for (uint32_t l = 0; l < c_levl->count; l++) {
+            const uint32_t first = levels.ptr[l].first;
+            const uint32_t n = levels.ptr[l].count;
+
+            transforms.resize(n);
+            level_parents.resize(n);
+            level_prefabs.resize(n);
+            for (uint32_t i = 0; i < n; i++) {
+                const uint32_t e = first + i;
+                const snapshot_xform_t& x = xforms.ptr[e];
+                transforms[i] = Transform3D{};
+                transforms[i].position = x.position;
+                transforms[i].rotation = x.rotation;
+                transforms[i].scale = x.scale;
+
+                const int32_t p = parents.ptr[e];
+                level_parents[i] = p >= 0 ? entities[(size_t)p] : parent;
+
+                const int32_t pf = isa.ptr ? isa.ptr[e] : -1;
+                level_prefabs[i] = pf >= 0 ? prefabs[(size_t)pf] : 0;
+            }
+
+            // split on cube ownership, the cube column is consumed in order
+            uint32_t start = 0;
+            for (uint32_t i = 1; i <= n; i++) {
+                const bool owns = flags.ptr && (flags.ptr[first + start] & SNAPSHOT_OWNS_CUBE);
+                const bool next = i < n && flags.ptr && (flags.ptr[first + i] & SNAPSHOT_OWNS_CUBE);
+                if (i < n && next == owns) continue;
+
+                const uint32_t run = i - start;
+
+                spawn_desc_t desc;
+                desc.count = (int32_t)run;
+                desc.transforms = transforms.data() + start;
+                desc.parents = level_parents.data() + start;
+                desc.prefabs = level_prefabs.data() + start;
+                desc.cubes = owns ? cubes.ptr + cube_cursor : nullptr;
+                spawn(world, desc, entities.data() + first + start);
+
+                if (owns) cube_cursor += run;
+                start = i;
+            }
+        }
+
+        // ---- id remap ---------------------------------------------------
+        if (out_remap) {
+            out_remap->clear();
+            out_remap->reserve((size_t)prefab_count + (eids.ptr ? count : 0));
+            for (uint32_t i = 0; i < prefab_count; i++) {
+                (*out_remap)[prefab_recs.ptr[i].saved_id] = prefabs[i];
+            }
+            for (uint32_t e = 0; eids.ptr && e < count; e++) {
+                (*out_remap)[eids.ptr[e]] = entities[e];
+            }
+        }
+
+        if (out_entities) *out_entities = std::move(entities);
+        return true;
+    }
+
+    bool load_snapshot(flecs::world& world, const char* path,
+                       std::vector<flecs::entity_t>* out_entities,
+                       flecs::entity_t parent,
+                       snapshot_remap_t* out_remap)
+    {
+        mapped_file file;
+        if (!file.open(path)) {
+            TraceLog(LOG_WARNING, "SNAPSHOT: could not map %s", path);
+            return false;
+        }
+        return load_snapshot_memory(world, file.data(), file.size(), out_entities, parent, out_remap);
+    }
+}
@@ -0,0 +1,168 @@
+#include "shape_cache.hpp"
+#include "module_physics.hpp"
+
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/Shape/CapsuleShape.h>
+#include <Jolt/Physics/Collision/Shape/CylinderShape.h>
+
+#include <cstring>
+
+JPH_SUPPRESS_WARNINGS
+
+namespace shapes {
+
+    static const char* g_type_names[(int)shape_type_t::count] = { "sphere", "box", "capsule", "cylinder" };
+
+    // -0 and 0 are the same shape
+    static uint32_t float_bits(float f) {
+        if (f == 0.0f) f = 0.0f;
+        uint32_t u;
+        memcpy(&u, &f, sizeof(u));
+        return u;
+    }
+
+    static float bits_float(uint32_t u) {
+        float f;
+        memcpy(&f, &u, sizeof(f));
+        return f;
+    }
+
+    bool cache_t::key_t::operator==(const key_t& o) const {
+        return type == o.type && memcmp(params, o.params, sizeof(params)) == 0;
+    }
+
+    // FNV-1a over the type and the parameter bits
+    size_t cache_t::key_hash_t::operator()(const key_t& k) const {
+        uint64_t h = 14695981039346656037ull;
+        h = (h ^ (uint64_t)k.type) * 1099511628211ull;
+        for (uint32_t p : k.params) h = (h ^ p) * 1099511628211ull;
+        return (size_t)h;
+    }
+
+    // ------------------------------------------------------------
+    //  lookup
+    // ------------------------------------------------------------
+    // Shapes are built through their settings, so bad parameters come back
+    // as an error instead of a Jolt assert.
+    static JPH::ShapeSettings::ShapeResult create(shape_type_t type, const float* p) {
+        switch (type) {
+        case shape_type_t::sphere: {
+            JPH::SphereShapeSettings s(p[0]);
+            s.SetEmbedded();
+            return s.Create();
+        }
+        case shape_type_t::box: {
+            JPH::BoxShapeSettings s(JPH::Vec3(p[0], p[1], p[2]), p[3]);
+            s.SetEmbedded();
+            return s.Create();
+        }
+        case shape_type_t::capsule: {
+            JPH::CapsuleShapeSettings s(p[0], p[1]);
+            s.SetEmbedded();
+            return s.Create();
+        }
+        case shape_type_t::cylinder: {
+            JPH::CylinderShapeSettings s(p[0], p[1], p[2]);
+            s.SetEmbedded();
+            return s.Create();
+        }
+        default:
+            break;
+        }
+        JPH::ShapeSettings::ShapeResult result;
+        result.SetError("unknown shape type");
+        return result;
+    }
+
+    JPH::ShapeRefC cache_t::find_or_create(const key_t& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = shapes_.find(key);
+        if (it != shapes_.end()) {
+            hits_++;
+            return it->second;
+        }
+
+        float p[4];
+        for (int i = 0; i < 4; i++) p[i] = bits_float(key.params[i]);
+        JPH::ShapeSettings::ShapeResult result = create(key.type, p);
+        if (result.HasError()) {
+            TraceLog(LOG_WARNING, "PHYSICS: %s shape (%g %g %g %g): %s", g_type_names[(int)key.type],
+                     p[0], p[1], p[2], p[3], result.GetError().c_str());
+            return nullptr;
+        }
+
+        misses_++;
+        JPH::ShapeRefC shape = result.Get();
+        shapes_.emplace(key, shape);
+        return shape;
+    }
+
+    JPH::ShapeRefC cache_t::sphere(float radius) {
+        return find_or_create({ shape_type_t::sphere, { float_bits(radius), 0, 0, 0 } });
+    }
+
+    JPH::ShapeRefC cache_t::box(Vector3 half_extents, float convex_radius) {
+        return find_or_create({ shape_type_t::box, { float_bits(half_extents.x), float_bits(half_extents.y),
+                                                     float_bits(half_extents.z), float_bits(convex_radius) } });
+    }
+
+    JPH::ShapeRefC cache_t::capsule(float half_height, float radius) {
+        return find_or_create({ shape_type_t::capsule, { float_bits(half_height), float_bits(radius), 0, 0 } });
+    }
+
+    JPH::ShapeRefC cache_t::cylinder(float half_height, float radius, float convex_radius) {
+        return find_or_create({ shape_type_t::cylinder, { float_bits(half_height), float_bits(radius),
+                                                          float_bits(convex_radius), 0 } });
+    }
+
+    // ------------------------------------------------------------
+    //  housekeeping
+    // ------------------------------------------------------------
+    int32_t cache_t::trim() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int32_t dropped = 0;
+        for (auto it = shapes_.begin(); it != shapes_.end();) {
+            if (it->second->GetRefCount() == 1) {   // ours only
+                it = shapes_.erase(it);
+                dropped++;
+            } else {
+                ++it;
+            }
+        }
+        return dropped;
+    }
+
+    void cache_t::clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shapes_.clear();
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+    cache_stats_t cache_t::stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cache_stats_t st;
+        st.hits = hits_;
+        st.misses = misses_;
+        for (const auto& [key, shape] : shapes_) {
+            const int32_t users = (int32_t)shape->GetRefCount() - 1;
+            const size_t size = shape->GetStats().mSizeBytes;
+            st.shapes++;
+            st.per_type[(int)key.type]++;
+            st.users += users;
+            st.bytes += size;
+            if (users > 1) st.saved_bytes += (size_t)(users - 1) * size;
+        }
+        return st;
+    }
+
+    // The cache can create shapes before any physics world exists and
+    // holds them after the last one is gone, so it installs the hooks too.
+    cache_t& shared() {
+        physics::install_jolt_hooks();
+        static cache_t cache;
+        return cache;
+    }
+
+}